@@ -24,6 +24,7 @@
 
 #include "config-keepassx.h"
 
+#include "autotype/AutoTypeMatchIndex.h"
 #include "autotype/AutoTypePlatformPlugin.h"
 #include "autotype/AutoTypeSelectDialog.h"
 #include "autotype/WildcardMatcher.h"
@@ -35,6 +36,7 @@
 #include "core/Group.h"
 #include "core/ListDeleter.h"
 #include "core/Tools.h"
+#include "core/Trace.h"
 #include "gui/MessageBox.h"
 
 AutoType* AutoType::m_instance = nullptr;
@@ -44,6 +46,8 @@ AutoType::AutoType(QObject* parent, bool test)
     , m_autoTypeDelay(0)
     , m_currentGlobalKey(static_cast<Qt::Key>(0))
     , m_currentGlobalModifiers(0)
+    , m_pluginName("keepassx-autotype-")
+    , m_pluginLoadAttempted(false)
     , m_pluginLoader(new QPluginLoader(this))
     , m_plugin(nullptr)
     , m_executor(nullptr)
@@ -52,19 +56,10 @@ AutoType::AutoType(QObject* parent, bool test)
     // prevent crash when the plugin has unresolved symbols
     m_pluginLoader->setLoadHints(QLibrary::ResolveAllSymbolsHint);
 
-    QString pluginName = "keepassx-autotype-";
     if (!test) {
-        pluginName += QApplication::platformName();
+        m_pluginName += QApplication::platformName();
     } else {
-        pluginName += "test";
-    }
-
-    QString pluginPath = filePath()->pluginPath(pluginName);
-
-    if (!pluginPath.isEmpty()) {
-#ifdef WITH_XC_AUTOTYPE
-        loadPlugin(pluginPath);
-#endif
+        m_pluginName += "test";
     }
 
     connect(qApp, SIGNAL(aboutToQuit()), SLOT(unloadPlugin()));
@@ -76,6 +71,28 @@ AutoType::~AutoType()
         delete m_executor;
         m_executor = nullptr;
     }
+
+    qDeleteAll(m_matchIndexes);
+}
+
+/**
+ * Load the platform plugin on first use, it is not needed to show the main window.
+ */
+void AutoType::ensurePluginLoaded()
+{
+    if (m_pluginLoadAttempted) {
+        return;
+    }
+    m_pluginLoadAttempted = true;
+
+    TRACE_SPAN("startup", "AutoType::loadPlugin");
+    QString pluginPath = filePath()->pluginPath(m_pluginName);
+
+    if (!pluginPath.isEmpty()) {
+#ifdef WITH_XC_AUTOTYPE
+        loadPlugin(pluginPath);
+#endif
+    }
 }
 
 void AutoType::loadPlugin(const QString& pluginPath)
@@ -129,10 +146,18 @@ void AutoType::createTestInstance()
     Q_ASSERT(!m_instance);
 
     m_instance = new AutoType(qApp, true);
+    m_instance->ensurePluginLoaded();
+}
+
+bool AutoType::isAvailable()
+{
+    ensurePluginLoaded();
+    return m_plugin;
 }
 
 QStringList AutoType::windowTitles()
 {
+    ensurePluginLoaded();
     if (!m_plugin) {
         return QStringList();
     }
@@ -143,7 +168,10 @@ QStringList AutoType::windowTitles()
 void AutoType::raiseWindow()
 {
 #if defined(Q_OS_MAC)
-    m_plugin->raiseOwnWindow();
+    ensurePluginLoaded();
+    if (m_plugin) {
+        m_plugin->raiseOwnWindow();
+    }
 #endif
 }
 
@@ -152,6 +180,7 @@ bool AutoType::registerGlobalShortcut(Qt::Key key, Qt::KeyboardModifiers modifie
     Q_ASSERT(key);
     Q_ASSERT(modifiers);
 
+    ensurePluginLoaded();
     if (!m_plugin) {
         return false;
     }
@@ -180,6 +209,7 @@ void AutoType::unregisterGlobalShortcut()
 
 int AutoType::callEventFilter(void* event)
 {
+    // Native events arrive before the plugin is needed, they must not load it
     if (!m_plugin) {
         return -1;
     }
@@ -206,7 +236,12 @@ void AutoType::executeAutoTypeActions(const Entry* entry, QWidget* hideWindow, c
     QList<AutoTypeAction*> actions;
     ListDeleter<AutoTypeAction*> actionsDeleter(&actions);
 
-    if (!parseActions(sequence, entry, actions)) {
+    bool parsed;
+    {
+        TRACE_SPAN("autotype", "AutoType::parseActions");
+        parsed = parseActions(sequence, entry, actions);
+    }
+    if (!parsed) {
         emit autotypeRejected();
         m_inAutoType.unlock();
         return;
@@ -228,9 +263,12 @@ void AutoType::executeAutoTypeActions(const Entry* entry, QWidget* hideWindow, c
 
     QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
 
+    m_executor->execBegin(actions);
+
     for (AutoTypeAction* action : asConst(actions)) {
         if (m_plugin->activeWindow() != window) {
             qWarning("Active window changed, interrupting auto-type.");
+            m_executor->execEnd();
             emit autotypeRejected();
             m_inAutoType.unlock();
             return;
@@ -240,6 +278,8 @@ void AutoType::executeAutoTypeActions(const Entry* entry, QWidget* hideWindow, c
         QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
     }
 
+    m_executor->execEnd();
+
     // emit signal only if autotype performed correctly
     emit autotypePerformed();
 
@@ -252,6 +292,7 @@ void AutoType::executeAutoTypeActions(const Entry* entry, QWidget* hideWindow, c
  */
 void AutoType::performAutoType(const Entry* entry, QWidget* hideWindow)
 {
+    ensurePluginLoaded();
     if (!m_plugin) {
         return;
     }
@@ -270,6 +311,7 @@ void AutoType::performAutoType(const Entry* entry, QWidget* hideWindow)
  */
 void AutoType::performGlobalAutoType(const QList<Database*>& dbList)
 {
+    ensurePluginLoaded();
     if (!m_plugin) {
         return;
     }
@@ -287,15 +329,12 @@ void AutoType::performGlobalAutoType(const QList<Database*>& dbList)
 
     QList<AutoTypeMatch> matchList;
 
-    for (Database* db : dbList) {
-        const QList<Entry*> dbEntries = db->rootGroup()->entriesRecursive();
-        for (Entry* entry : dbEntries) {
-            const QSet<QString> sequences = autoTypeSequences(entry, windowTitle).toSet();
-            for (const QString& sequence : sequences) {
-                if (!sequence.isEmpty()) {
-                    matchList << AutoTypeMatch(entry, sequence);
-                }
-            }
+    const bool matchTitle = config()->get("AutoTypeEntryTitleMatch").toBool();
+    const bool matchUrl = config()->get("AutoTypeEntryURLMatch").toBool();
+    {
+        TRACE_SPAN("autotype", "AutoType::matchEntries");
+        for (Database* db : dbList) {
+            matchList << matchIndex(db)->match(windowTitle, matchTitle, matchUrl);
         }
     }
 
@@ -611,6 +650,32 @@ QList<QString> AutoType::autoTypeSequences(const Entry* entry, const QString& wi
     return sequenceList;
 }
 
+/**
+ * Returns the Auto-Type match index of a database, rebuilding it if the
+ * database was modified since it was last used
+ */
+AutoTypeMatchIndex* AutoType::matchIndex(Database* db)
+{
+    AutoTypeMatchIndex* index = m_matchIndexes.value(db);
+    if (index && index->isCurrent()) {
+        return index;
+    }
+
+    if (!index) {
+        connect(db, SIGNAL(destroyed(QObject*)), SLOT(removeMatchIndex(QObject*)));
+    }
+
+    delete index;
+    index = new AutoTypeMatchIndex(db);
+    m_matchIndexes.insert(db, index);
+    return index;
+}
+
+void AutoType::removeMatchIndex(QObject* db)
+{
+    delete m_matchIndexes.take(db);
+}
+
 /**
  * Checks if a window title matches a pattern
  */
@@ -19,6 +19,7 @@
 #ifndef KEEPASSX_AUTOTYPE_H
 #define KEEPASSX_AUTOTYPE_H
 
+#include <QHash>
 #include <QMutex>
 #include <QObject>
 #include <QStringList>
@@ -28,6 +29,7 @@
 
 class AutoTypeAction;
 class AutoTypeExecutor;
+class AutoTypeMatchIndex;
 class AutoTypePlatformInterface;
 class Database;
 class Entry;
@@ -49,10 +51,7 @@ public:
     static bool verifyAutoTypeSyntax(const QString& sequence);
     void performAutoType(const Entry* entry, QWidget* hideWindow = nullptr);
 
-    inline bool isAvailable()
-    {
-        return m_plugin;
-    }
+    bool isAvailable();
 
     static AutoType* instance();
     static void createTestInstance();
@@ -70,10 +69,12 @@ private slots:
     void performAutoTypeFromGlobal(AutoTypeMatch match);
     void autoTypeRejectedFromGlobal();
     void unloadPlugin();
+    void removeMatchIndex(QObject* db);
 
 private:
     explicit AutoType(QObject* parent = nullptr, bool test = false);
     ~AutoType();
+    void ensurePluginLoaded();
     void loadPlugin(const QString& pluginPath);
     void executeAutoTypeActions(const Entry* entry,
                                 QWidget* hideWindow = nullptr,
@@ -85,16 +86,20 @@ private:
     bool windowMatchesTitle(const QString& windowTitle, const QString& resolvedTitle);
     bool windowMatchesUrl(const QString& windowTitle, const QString& resolvedUrl);
     bool windowMatches(const QString& windowTitle, const QString& windowPattern);
+    AutoTypeMatchIndex* matchIndex(Database* db);
 
     QMutex m_inAutoType;
     QMutex m_inGlobalAutoTypeDialog;
     int m_autoTypeDelay;
     Qt::Key m_currentGlobalKey;
     Qt::KeyboardModifiers m_currentGlobalModifiers;
+    QString m_pluginName;
+    bool m_pluginLoadAttempted;
     QPluginLoader* m_pluginLoader;
     AutoTypePlatformInterface* m_plugin;
     AutoTypeExecutor* m_executor;
     WId m_windowFromGlobal;
+    QHash<QObject*, AutoTypeMatchIndex*> m_matchIndexes;
     static AutoType* m_instance;
 
     Q_DISABLE_COPY(AutoType)
@@ -87,3 +87,12 @@ void AutoTypeExecutor::execClearField(AutoTypeClearField* action)
 {
     Q_UNUSED(action);
 }
+
+void AutoTypeExecutor::execBegin(const QList<AutoTypeAction*>& actions)
+{
+    Q_UNUSED(actions);
+}
+
+void AutoTypeExecutor::execEnd()
+{
+}
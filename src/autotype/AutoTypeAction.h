@@ -19,6 +19,7 @@
 #define KEEPASSX_AUTOTYPEACTION_H
 
 #include <QChar>
+#include <QList>
 #include <QObject>
 #include <Qt>
 
@@ -84,6 +85,9 @@ public:
     virtual void execKey(AutoTypeKey* action) = 0;
     virtual void execDelay(AutoTypeDelay* action);
     virtual void execClearField(AutoTypeClearField* action);
+    // called with the whole sequence before the first action and after the last one
+    virtual void execBegin(const QList<AutoTypeAction*>& actions);
+    virtual void execEnd();
 };
 
 #endif // KEEPASSX_AUTOTYPEACTION_H
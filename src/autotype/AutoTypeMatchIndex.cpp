@@ -0,0 +1,260 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AutoTypeMatchIndex.h"
+
+#include <QUrl>
+#include <algorithm>
+
+#include "autotype/WildcardMatcher.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Global.h"
+#include "core/Group.h"
+
+namespace
+{
+    const int TrigramLength = 3;
+}
+
+AutoTypeMatchIndex::AutoTypeMatchIndex(Database* db)
+    : m_db(db)
+    , m_rootGroup(db->rootGroup())
+    , m_generation(db->generation())
+{
+    const QList<Entry*> entries = db->rootGroup()->entriesRecursive();
+    for (Entry* entry : entries) {
+        if (autoTypeEnabled(entry)) {
+            addCandidate(entry);
+        }
+    }
+
+    buildBuckets();
+}
+
+/**
+ * Returns false if the database was modified since the index was built
+ */
+bool AutoTypeMatchIndex::isCurrent() const
+{
+    return m_db && m_db->rootGroup() == m_rootGroup && m_db->generation() == m_generation;
+}
+
+/**
+ * Returns all Auto-Type sequences matching a window title, in the same
+ * order as AutoType::autoTypeSequences() and without duplicates per entry.
+ */
+QList<AutoTypeMatch> AutoTypeMatchIndex::match(const QString& windowTitle, bool matchTitle, bool matchUrl)
+{
+    QList<AutoTypeMatch> matchList;
+
+    QVector<int> candidates = m_unindexed;
+    const QString foldedTitle = windowTitle.toCaseFolded();
+    for (int i = 0; i + TrigramLength <= foldedTitle.size(); ++i) {
+        auto bucket = m_buckets.constFind(trigram(foldedTitle.constData() + i));
+        if (bucket != m_buckets.constEnd()) {
+            candidates += bucket.value();
+        }
+    }
+
+    // Keep the order of the entries in the database
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (int index : candidates) {
+        Candidate& candidate = m_candidates[index];
+        for (const QString& sequence : candidateSequences(candidate, windowTitle, matchTitle, matchUrl)) {
+            matchList << AutoTypeMatch(candidate.entry, sequence);
+        }
+    }
+
+    return matchList;
+}
+
+void AutoTypeMatchIndex::addCandidate(Entry* entry)
+{
+    const int index = m_candidates.size();
+
+    Candidate candidate;
+    candidate.entry = entry;
+    candidate.sequence = entry->effectiveAutoTypeSequence();
+
+    bool indexed = true;
+    const QList<AutoTypeAssociations::Association> assocList = entry->autoTypeAssociations()->getAll();
+    for (const AutoTypeAssociations::Association& assoc : assocList) {
+        const QString window = entry->resolveMultiplePlaceholders(assoc.window);
+
+        WindowPattern pattern;
+        pattern.sequence = assoc.sequence.isEmpty() ? candidate.sequence : assoc.sequence;
+        pattern.isRegExp = window.startsWith("//") && window.endsWith("//") && window.size() >= 4;
+
+        if (pattern.isRegExp) {
+            pattern.regExp = QRegExp(window.mid(2, window.size() - 4), Qt::CaseInsensitive, QRegExp::RegExp2);
+            indexed = false;
+        } else {
+            pattern.parts = WildcardMatcher::splitPattern(window);
+
+            // Every part has to be contained in the window title, use the longest one
+            QString literal;
+            for (const QString& part : pattern.parts) {
+                if (part.size() > literal.size()) {
+                    literal = part;
+                }
+            }
+
+            if (literal.isEmpty() && pattern.parts.size() > 1) {
+                indexed = false;
+            } else if (!literal.isEmpty()) {
+                addLiteral(index, literal);
+            }
+        }
+
+        candidate.patterns.append(pattern);
+    }
+
+    candidate.title = entry->resolvePlaceholder(entry->title());
+    addLiteral(index, candidate.title);
+
+    candidate.url = entry->resolvePlaceholder(entry->url());
+    addLiteral(index, candidate.url);
+
+    QUrl url(candidate.url);
+    if (url.isValid() && !url.host().isEmpty()) {
+        candidate.urlHost = url.host();
+        addLiteral(index, candidate.urlHost);
+    }
+
+    m_candidates.append(candidate);
+
+    if (!indexed) {
+        m_unindexed.append(index);
+    }
+}
+
+void AutoTypeMatchIndex::addLiteral(int candidate, const QString& literal)
+{
+    if (literal.isEmpty()) {
+        return;
+    }
+
+    Literal entry;
+    entry.candidate = candidate;
+    entry.text = literal.toCaseFolded();
+    m_literals.append(entry);
+}
+
+/**
+ * File every literal under its least common trigram. Literals shorter than a
+ * trigram can't be indexed, so their entries are checked for every window.
+ */
+void AutoTypeMatchIndex::buildBuckets()
+{
+    QHash<quint64, int> frequencies;
+    for (const Literal& literal : asConst(m_literals)) {
+        for (int i = 0; i + TrigramLength <= literal.text.size(); ++i) {
+            frequencies[trigram(literal.text.constData() + i)]++;
+        }
+    }
+
+    for (const Literal& literal : asConst(m_literals)) {
+        if (literal.text.size() < TrigramLength) {
+            m_unindexed.append(literal.candidate);
+            continue;
+        }
+
+        quint64 best = trigram(literal.text.constData());
+        for (int i = 1; i + TrigramLength <= literal.text.size(); ++i) {
+            const quint64 key = trigram(literal.text.constData() + i);
+            if (frequencies.value(key) < frequencies.value(best)) {
+                best = key;
+            }
+        }
+
+        QVector<int>& bucket = m_buckets[best];
+        if (bucket.isEmpty() || bucket.last() != literal.candidate) {
+            bucket.append(literal.candidate);
+        }
+    }
+
+    m_literals.clear();
+}
+
+QList<QString> AutoTypeMatchIndex::candidateSequences(Candidate& candidate,
+                                                     const QString& windowTitle,
+                                                     bool matchTitle,
+                                                     bool matchUrl)
+{
+    QList<QString> sequenceList;
+
+    WildcardMatcher matcher(windowTitle);
+    for (WindowPattern& pattern : candidate.patterns) {
+        bool matches;
+        if (pattern.isRegExp) {
+            matches = pattern.regExp.indexIn(windowTitle) != -1;
+        } else {
+            matches = matcher.matchParts(pattern.parts);
+        }
+
+        if (matches) {
+            sequenceList.append(pattern.sequence);
+        }
+    }
+
+    if (matchTitle && !candidate.title.isEmpty() && windowTitle.contains(candidate.title, Qt::CaseInsensitive)) {
+        sequenceList.append(candidate.sequence);
+    }
+
+    if (matchUrl
+        && ((!candidate.url.isEmpty() && windowTitle.contains(candidate.url, Qt::CaseInsensitive))
+            || (!candidate.urlHost.isEmpty() && windowTitle.contains(candidate.urlHost, Qt::CaseInsensitive)))) {
+        sequenceList.append(candidate.sequence);
+    }
+
+    QList<QString> uniqueSequences;
+    for (const QString& sequence : asConst(sequenceList)) {
+        if (!sequence.isEmpty() && !uniqueSequences.contains(sequence)) {
+            uniqueSequences.append(sequence);
+        }
+    }
+
+    return uniqueSequences;
+}
+
+bool AutoTypeMatchIndex::autoTypeEnabled(const Entry* entry)
+{
+    if (!entry->autoTypeEnabled()) {
+        return false;
+    }
+
+    const Group* group = entry->group();
+    do {
+        if (group->autoTypeEnabled() == Group::Disable) {
+            return false;
+        } else if (group->autoTypeEnabled() == Group::Enable) {
+            return true;
+        }
+        group = group->parentGroup();
+    } while (group);
+
+    return true;
+}
+
+quint64 AutoTypeMatchIndex::trigram(const QChar* data)
+{
+    return (static_cast<quint64>(data[0].unicode()) << 32) | (static_cast<quint64>(data[1].unicode()) << 16)
+           | static_cast<quint64>(data[2].unicode());
+}
@@ -0,0 +1,94 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_AUTOTYPEMATCHINDEX_H
+#define KEEPASSX_AUTOTYPEMATCHINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QRegExp>
+#include <QStringList>
+#include <QVector>
+
+#include "core/AutoTypeMatch.h"
+
+class Database;
+class Entry;
+class Group;
+
+/**
+ * Index of all entries of a database that can be used for global Auto-Type.
+ *
+ * Window association patterns are compiled and entry titles and URLs are
+ * resolved once when the index is built. Every literal that a window title
+ * has to contain is filed under one of its three character substrings, so a
+ * window title only needs to be checked against the entries sharing such a
+ * substring with it. The index has to be rebuilt once isCurrent() returns false.
+ */
+class AutoTypeMatchIndex
+{
+public:
+    explicit AutoTypeMatchIndex(Database* db);
+
+    bool isCurrent() const;
+    QList<AutoTypeMatch> match(const QString& windowTitle, bool matchTitle, bool matchUrl);
+
+private:
+    struct WindowPattern
+    {
+        QString sequence;
+        bool isRegExp;
+        QRegExp regExp;
+        QStringList parts;
+    };
+
+    struct Candidate
+    {
+        Entry* entry;
+        QString sequence;
+        QList<WindowPattern> patterns;
+        QString title;
+        QString url;
+        QString urlHost;
+    };
+
+    struct Literal
+    {
+        int candidate;
+        QString text;
+    };
+
+    void addCandidate(Entry* entry);
+    void addLiteral(int candidate, const QString& literal);
+    void buildBuckets();
+    QList<QString> candidateSequences(Candidate& candidate, const QString& windowTitle, bool matchTitle, bool matchUrl);
+
+    static bool autoTypeEnabled(const Entry* entry);
+    static quint64 trigram(const QChar* data);
+
+    QPointer<Database> m_db;
+    const Group* m_rootGroup;
+    quint64 m_generation;
+
+    QVector<Candidate> m_candidates;
+    QList<Literal> m_literals;
+    QHash<quint64, QVector<int>> m_buckets;
+    QVector<int> m_unindexed;
+};
+
+#endif // KEEPASSX_AUTOTYPEMATCHINDEX_H
@@ -29,29 +29,18 @@ WildcardMatcher::WildcardMatcher(const QString& text)
 
 bool WildcardMatcher::match(const QString& pattern)
 {
-    m_pattern = pattern;
-
-    if (patternContainsWildcard()) {
-        return matchWithWildcards();
-    } else {
-        return patternEqualsText();
-    }
-}
-
-bool WildcardMatcher::patternContainsWildcard()
-{
-    return m_pattern.contains(Wildcard);
-}
-
-bool WildcardMatcher::patternEqualsText()
-{
-    return m_text.compare(m_pattern, Sensitivity) == 0;
+    return matchParts(splitPattern(pattern));
 }
 
-bool WildcardMatcher::matchWithWildcards()
+/**
+ * Matches against a pattern that was split with splitPattern() before.
+ * This allows to split a pattern once and match it against many texts.
+ */
+bool WildcardMatcher::matchParts(const QStringList& parts)
 {
-    QStringList parts = m_pattern.split(Wildcard, QString::KeepEmptyParts);
-    Q_ASSERT(parts.size() >= 2);
+    if (parts.size() < 2) {
+        return patternEqualsText(parts.value(0));
+    }
 
     if (startOrEndDoesNotMatch(parts)) {
         return false;
@@ -60,6 +49,16 @@ bool WildcardMatcher::matchWithWildcards()
     return partsMatch(parts);
 }
 
+QStringList WildcardMatcher::splitPattern(const QString& pattern)
+{
+    return pattern.split(Wildcard, QString::KeepEmptyParts);
+}
+
+bool WildcardMatcher::patternEqualsText(const QString& pattern)
+{
+    return m_text.compare(pattern, Sensitivity) == 0;
+}
+
 bool WildcardMatcher::startOrEndDoesNotMatch(const QStringList& parts)
 {
     return !m_text.startsWith(parts.first(), Sensitivity) || !m_text.endsWith(parts.last(), Sensitivity);
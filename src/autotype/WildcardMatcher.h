@@ -25,13 +25,13 @@ class WildcardMatcher
 public:
     explicit WildcardMatcher(const QString& text);
     bool match(const QString& pattern);
+    bool matchParts(const QStringList& parts);
+    static QStringList splitPattern(const QString& pattern);
 
     static const QChar Wildcard;
 
 private:
-    bool patternEqualsText();
-    bool patternContainsWildcard();
-    bool matchWithWildcards();
+    bool patternEqualsText(const QString& pattern);
     bool startOrEndDoesNotMatch(const QStringList& parts);
     bool partsMatch(const QStringList& parts);
     int getMatchIndex(const QString& part, int startIndex);
@@ -40,7 +40,6 @@ private:
 
     static const Qt::CaseSensitivity Sensitivity;
     const QString m_text;
-    QString m_pattern;
 };
 
 #endif // KEEPASSX_WILDCARDMATCHER_H
@@ -31,6 +31,7 @@ int (*AutoTypePlatformX11::m_oldXErrorHandler)(Display*, XErrorEvent*) = nullptr
 AutoTypePlatformX11::AutoTypePlatformX11()
 {
     m_dpy = QX11Info::display();
+    m_connection = QX11Info::connection();
     m_rootWindow = QX11Info::appRootWindow();
 
     m_atomWmState = XInternAtom(m_dpy, "WM_STATE", True);
@@ -54,11 +55,15 @@ AutoTypePlatformX11::AutoTypePlatformX11()
 
     m_keysymTable = nullptr;
     m_xkb = nullptr;
-    m_remapKeycode = 0;
-    m_currentRemapKeysym = NoSymbol;
+    m_nextRemapKeycode = 0;
+    m_inKeySequence = false;
+    m_originalModifiers = 0;
+    m_modifierState = 0;
+    m_oldKeyErrorHandler = nullptr;
     m_modifierMask = ControlMask | ShiftMask | Mod1Mask | Mod4Mask;
 
     m_loaded = true;
+    m_windowCacheActive = false;
 
     updateKeymap();
 }
@@ -91,8 +96,12 @@ bool AutoTypePlatformX11::isAvailable()
 void AutoTypePlatformX11::unload()
 {
     // Restore the KeyboardMapping to its original state.
-    if (m_currentRemapKeysym != NoSymbol) {
-        AddKeysym(NoSymbol);
+    if (!m_remappedKeysyms.isEmpty()) {
+        QHash<KeyCode, KeySym> mapping;
+        for (KeyCode keycode : asConst(m_remappedKeysyms)) {
+            mapping.insert(keycode, NoSymbol);
+        }
+        remapKeycodes(mapping);
     }
 
     if (m_keysymTable) {
@@ -103,12 +112,23 @@ void AutoTypePlatformX11::unload()
         XkbFreeKeyboard(m_xkb, XkbAllComponentsMask, True);
     }
 
+    m_windowCacheActive = false;
+    m_windowCache.clear();
+    m_newWindows.clear();
+    m_dirtyWindows.clear();
+
     m_loaded = false;
 }
 
 QStringList AutoTypePlatformX11::windowTitles()
 {
-    return windowTitlesRecursive(m_rootWindow);
+    updateWindowCache();
+
+    QStringList titles;
+    const QList<Window> keepassxWindows = widgetsToX11Windows(QApplication::topLevelWidgets());
+    windowTitlesRecursive(m_rootWindow, keepassxWindows, titles);
+
+    return titles;
 }
 
 WId AutoTypePlatformX11::activeWindow()
@@ -237,6 +257,8 @@ int AutoTypePlatformX11::platformEventFilter(void* event)
             XRefreshKeyboardMapping(&xMappingEvent);
             updateKeymap();
         }
+    } else if (m_windowCacheActive) {
+        handleWindowCacheEvent(type, genericEvent);
     }
 
     return -1;
@@ -345,31 +367,443 @@ QList<Window> AutoTypePlatformX11::widgetsToX11Windows(const QWidgetList& widget
     return windows;
 }
 
-QStringList AutoTypePlatformX11::windowTitlesRecursive(Window window)
+void AutoTypePlatformX11::windowTitlesRecursive(xcb_window_t window,
+                                                const QList<Window>& excludedWindows,
+                                                QStringList& titles)
 {
-    QStringList titles;
+    auto it = m_windowCache.constFind(window);
+    if (it == m_windowCache.constEnd()) {
+        return;
+    }
+
+    const WindowInfo& info = it.value();
+    if (info.topLevel && !info.title.isEmpty() && window != m_rootWindow
+        && !m_classBlacklist.contains(info.className) && !excludedWindows.contains(window)) {
+        titles.append(info.title);
+    }
+
+    for (xcb_window_t child : info.children) {
+        windowTitlesRecursive(child, excludedWindows, titles);
+    }
+}
+
+/*
+ * Brings the cached window tree up to date. The first call reads the whole
+ * tree and starts listening for changes, later calls only fetch the windows
+ * that were created or had one of their properties changed since.
+ */
+void AutoTypePlatformX11::updateWindowCache()
+{
+    if (!m_windowCacheActive) {
+        // Qt listens to the root window as well, keep its event mask intact
+        uint32_t eventMask = XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+        xcb_get_window_attributes_reply_t* attributes = xcb_get_window_attributes_reply(
+            m_connection, xcb_get_window_attributes(m_connection, m_rootWindow), nullptr);
+        if (attributes) {
+            eventMask |= attributes->your_event_mask;
+            free(attributes);
+        }
+        xcb_change_window_attributes(m_connection, m_rootWindow, XCB_CW_EVENT_MASK, &eventMask);
+
+        m_windowCache.clear();
+        m_newWindows.clear();
+        m_dirtyWindows.clear();
+        m_windowCache.insert(m_rootWindow, WindowInfo());
+        m_windowCacheActive = true;
+
+        scanWindows(QVector<xcb_window_t>() << m_rootWindow);
+        return;
+    }
+
+    // windows that stopped being clients are queued for a rescan, so update properties first
+    if (!m_dirtyWindows.isEmpty()) {
+        const QList<xcb_window_t> dirtyWindows = m_dirtyWindows.toList();
+        m_dirtyWindows.clear();
+        updateWindowProperties(dirtyWindows);
+    }
+
+    if (!m_newWindows.isEmpty()) {
+        const QVector<xcb_window_t> newWindows = m_newWindows.toList().toVector();
+        m_newWindows.clear();
+        scanWindows(newWindows);
+    }
+}
+
+/*
+ * Reads the children and properties of the given windows and all their
+ * descendants. The requests for one level of the tree are all sent before
+ * waiting for the first reply, so the whole tree only takes one round trip
+ * per level instead of several per window.
+ *
+ * The scan stops at client windows (the ones with WM_STATE), their titles
+ * are all that is needed and nothing below them can be a top-level window.
+ */
+void AutoTypePlatformX11::scanWindows(QVector<xcb_window_t> windows)
+{
+    while (!windows.isEmpty()) {
+        QVector<xcb_query_tree_cookie_t> treeCookies;
+        QVector<PropertyCookies> propertyCookies;
+        for (xcb_window_t window : asConst(windows)) {
+            // select events before querying the tree so no new child can be missed
+            selectWindowEvents(window, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE);
+            treeCookies.append(xcb_query_tree(m_connection, window));
+            propertyCookies.append(requestWindowProperties(window));
+        }
+
+        QVector<xcb_window_t> nextLevel;
+        for (int i = 0; i < windows.size(); ++i) {
+            const xcb_window_t window = windows[i];
+
+            readWindowProperties(propertyCookies[i], window);
+
+            xcb_generic_error_t* error = nullptr;
+            xcb_query_tree_reply_t* tree = xcb_query_tree_reply(m_connection, treeCookies[i], &error);
+            free(error);
+            if (!tree || !m_windowCache.contains(window)) {
+                // the window is already gone
+                free(tree);
+                removeCachedWindow(window);
+                continue;
+            }
 
-    if (isTopLevelWindow(window)) {
-        QString title = windowTitle(window, true);
-        if (!title.isEmpty()) {
-            titles.append(title);
+            if (m_windowCache.value(window).client) {
+                free(tree);
+                setClientWindow(window);
+                continue;
+            }
+
+            const xcb_window_t* children = xcb_query_tree_children(tree);
+            const int numChildren = xcb_query_tree_children_length(tree);
+
+            QVector<xcb_window_t> childList;
+            childList.reserve(numChildren);
+            for (int j = 0; j < numChildren; ++j) {
+                const xcb_window_t child = children[j];
+                auto childIt = m_windowCache.find(child);
+                if (childIt == m_windowCache.end()) {
+                    WindowInfo childInfo;
+                    childInfo.parent = window;
+                    m_windowCache.insert(child, childInfo);
+                    nextLevel.append(child);
+                } else if (childIt->parent != window) {
+                    reparentCachedWindow(child, window);
+                }
+                childList.append(child);
+            }
+            free(tree);
+
+            m_windowCache[window].children = childList;
         }
+
+        windows = nextLevel;
+    }
+}
+
+void AutoTypePlatformX11::updateWindowProperties(const QList<xcb_window_t>& windows)
+{
+    QVector<PropertyCookies> cookies;
+    cookies.reserve(windows.size());
+    for (xcb_window_t window : windows) {
+        cookies.append(requestWindowProperties(window));
     }
 
-    Window root;
-    Window parent;
-    Window* children = nullptr;
-    unsigned int numChildren;
-    if (XQueryTree(m_dpy, window, &root, &parent, &children, &numChildren) && children) {
-        for (uint i = 0; i < numChildren; i++) {
-            titles.append(windowTitlesRecursive(children[i]));
+    for (int i = 0; i < windows.size(); ++i) {
+        const xcb_window_t window = windows[i];
+        const bool wasClient = m_windowCache.value(window).client;
+        readWindowProperties(cookies[i], window);
+
+        auto it = m_windowCache.constFind(window);
+        if (it == m_windowCache.constEnd() || it->client == wasClient) {
+            continue;
         }
+
+        if (it->client) {
+            setClientWindow(window);
+        } else {
+            // the window was withdrawn for good, its children have to be scanned now
+            m_newWindows.insert(window);
+        }
+    }
+}
+
+AutoTypePlatformX11::PropertyCookies AutoTypePlatformX11::requestWindowProperties(xcb_window_t window)
+{
+    // the window manager spec says we should read _NET_WM_NAME first, then fall back to WM_NAME
+    PropertyCookies cookies;
+    cookies.wmState = xcb_get_property(m_connection, false, window, m_atomWmState, m_atomWmState, 0, 2);
+    cookies.netWmName = xcb_get_property(m_connection, false, window, m_atomNetWmName, m_atomUtf8String, 0, 1000);
+    cookies.wmName = xcb_get_property(m_connection, false, window, XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0, 1000);
+    cookies.wmClass = xcb_get_property(m_connection, false, window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 256);
+    return cookies;
+}
+
+namespace
+{
+    xcb_get_property_reply_t* takePropertyReply(xcb_connection_t* connection, xcb_get_property_cookie_t cookie)
+    {
+        xcb_generic_error_t* error = nullptr;
+        xcb_get_property_reply_t* reply = xcb_get_property_reply(connection, cookie, &error);
+        free(error);
+
+        if (reply && (reply->type == XCB_ATOM_NONE || xcb_get_property_value_length(reply) <= 0)) {
+            free(reply);
+            return nullptr;
+        }
+
+        return reply;
     }
-    if (children) {
-        XFree(children);
+
+    QByteArray propertyString(xcb_get_property_reply_t* reply)
+    {
+        const char* value = static_cast<const char*>(xcb_get_property_value(reply));
+        return QByteArray(value, static_cast<int>(qstrnlen(value, xcb_get_property_value_length(reply))));
     }
+} // namespace
 
-    return titles;
+/*
+ * Collects the replies of requestWindowProperties() and stores them in the
+ * cache entry of the window, if it still has one.
+ */
+void AutoTypePlatformX11::readWindowProperties(const PropertyCookies& cookies, xcb_window_t window)
+{
+    WindowInfo info;
+
+    xcb_get_property_reply_t* reply = takePropertyReply(m_connection, cookies.wmState);
+    if (reply) {
+        if (reply->type == m_atomWmState && reply->format == 32) {
+            info.client = true;
+            const quint32 state = *static_cast<const quint32*>(xcb_get_property_value(reply));
+            info.topLevel = (state != WithdrawnState);
+        }
+        free(reply);
+    }
+
+    reply = takePropertyReply(m_connection, cookies.netWmName);
+    if (reply) {
+        info.title = QString::fromUtf8(propertyString(reply));
+        free(reply);
+    }
+
+    reply = takePropertyReply(m_connection, cookies.wmName);
+    if (reply) {
+        if (info.title.isEmpty()) {
+            info.title = textProperty(reply);
+        }
+        free(reply);
+    }
+
+    reply = takePropertyReply(m_connection, cookies.wmClass);
+    if (reply) {
+        info.className = QString::fromLocal8Bit(propertyString(reply));
+        free(reply);
+    }
+
+    auto it = m_windowCache.find(window);
+    if (it != m_windowCache.end()) {
+        it->client = info.client;
+        it->topLevel = info.topLevel;
+        it->title = info.title;
+        it->className = info.className;
+    }
+}
+
+QString AutoTypePlatformX11::textProperty(xcb_get_property_reply_t* reply)
+{
+    QByteArray value = propertyString(reply);
+    if (reply->type == m_atomUtf8String) {
+        return QString::fromUtf8(value);
+    }
+
+    QString text;
+
+    // the conversion of the other encodings happens locally in Xlib
+    XTextProperty textProp;
+    textProp.value = reinterpret_cast<unsigned char*>(value.data());
+    textProp.encoding = reply->type;
+    textProp.format = reply->format;
+    textProp.nitems = static_cast<unsigned long>(value.size());
+
+    char** textList = nullptr;
+    int count;
+    if ((XmbTextPropertyToTextList(m_dpy, &textProp, &textList, &count) == 0) && textList && (count > 0)) {
+        text = QString::fromLocal8Bit(textList[0]);
+    } else if (reply->type == XCB_ATOM_STRING) {
+        text = QString::fromLocal8Bit(value);
+    }
+
+    if (textList) {
+        XFreeStringList(textList);
+    }
+
+    return text;
+}
+
+void AutoTypePlatformX11::selectWindowEvents(xcb_window_t window, uint32_t eventMask)
+{
+    // the event mask is per client, don't overwrite the one Qt uses for its own windows
+    if (window == m_rootWindow || isOwnWindow(window)) {
+        return;
+    }
+
+    xcb_void_cookie_t cookie =
+        xcb_change_window_attributes_checked(m_connection, window, XCB_CW_EVENT_MASK, &eventMask);
+    // the window may be destroyed at any time, ignore BadWindow errors
+    xcb_discard_reply(m_connection, cookie.sequence);
+}
+
+bool AutoTypePlatformX11::isOwnWindow(xcb_window_t window)
+{
+    const xcb_setup_t* setup = xcb_get_setup(m_connection);
+    return (window & ~setup->resource_id_mask) == setup->resource_id_base;
+}
+
+/*
+ * Only the properties of a client window are watched, the windows below it
+ * are dropped from the cache.
+ */
+void AutoTypePlatformX11::setClientWindow(xcb_window_t window)
+{
+    selectWindowEvents(window, XCB_EVENT_MASK_PROPERTY_CHANGE);
+
+    const QVector<xcb_window_t> children = m_windowCache.value(window).children;
+    for (xcb_window_t child : children) {
+        removeCachedWindow(child);
+    }
+}
+
+void AutoTypePlatformX11::addCachedWindow(xcb_window_t window, xcb_window_t parent)
+{
+    auto parentIt = m_windowCache.find(parent);
+    if (parentIt == m_windowCache.end() || parentIt->client || m_windowCache.contains(window)) {
+        return;
+    }
+
+    // new windows are created on top of their siblings
+    parentIt->children.append(window);
+
+    WindowInfo info;
+    info.parent = parent;
+    m_windowCache.insert(window, info);
+
+    selectWindowEvents(window, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE);
+    m_newWindows.insert(window);
+}
+
+void AutoTypePlatformX11::removeCachedWindow(xcb_window_t window)
+{
+    auto it = m_windowCache.find(window);
+    if (it == m_windowCache.end()) {
+        return;
+    }
+
+    const xcb_window_t parent = it->parent;
+    const QVector<xcb_window_t> children = it->children;
+    m_windowCache.erase(it);
+    m_newWindows.remove(window);
+    m_dirtyWindows.remove(window);
+
+    for (xcb_window_t child : children) {
+        removeCachedWindow(child);
+    }
+
+    auto parentIt = m_windowCache.find(parent);
+    if (parentIt != m_windowCache.end()) {
+        parentIt->children.removeOne(window);
+    }
+}
+
+void AutoTypePlatformX11::reparentCachedWindow(xcb_window_t window, xcb_window_t parent)
+{
+    auto it = m_windowCache.find(window);
+    if (it == m_windowCache.end()) {
+        addCachedWindow(window, parent);
+        return;
+    }
+
+    if (it->parent == parent) {
+        return;
+    }
+
+    auto parentIt = m_windowCache.constFind(parent);
+    if (parentIt == m_windowCache.constEnd() || parentIt->client) {
+        removeCachedWindow(window);
+        return;
+    }
+
+    auto oldParentIt = m_windowCache.find(it->parent);
+    if (oldParentIt != m_windowCache.end()) {
+        oldParentIt->children.removeOne(window);
+    }
+
+    m_windowCache[window].parent = parent;
+    m_windowCache[parent].children.append(window);
+}
+
+/*
+ * Moves a window in the stacking order of its siblings, either to the top,
+ * directly above sibling or to the bottom if sibling is XCB_WINDOW_NONE.
+ */
+void AutoTypePlatformX11::restackCachedWindow(xcb_window_t window, xcb_window_t sibling, bool onTop)
+{
+    auto it = m_windowCache.constFind(window);
+    if (it == m_windowCache.constEnd()) {
+        return;
+    }
+
+    auto parentIt = m_windowCache.find(it->parent);
+    if (parentIt == m_windowCache.end()) {
+        return;
+    }
+
+    QVector<xcb_window_t>& children = parentIt->children;
+    children.removeOne(window);
+
+    if (onTop) {
+        children.append(window);
+    } else if (sibling == XCB_WINDOW_NONE) {
+        children.prepend(window);
+    } else {
+        const int siblingIndex = children.indexOf(sibling);
+        children.insert(siblingIndex + 1, window);
+        if (siblingIndex < 0) {
+            // the sibling isn't cached yet, read the order from the server again
+            m_newWindows.insert(parentIt.key());
+        }
+    }
+}
+
+void AutoTypePlatformX11::handleWindowCacheEvent(quint8 type, xcb_generic_event_t* event)
+{
+    if (type == XCB_CREATE_NOTIFY) {
+        xcb_create_notify_event_t* createEvent = reinterpret_cast<xcb_create_notify_event_t*>(event);
+        addCachedWindow(createEvent->window, createEvent->parent);
+    } else if (type == XCB_DESTROY_NOTIFY) {
+        xcb_destroy_notify_event_t* destroyEvent = reinterpret_cast<xcb_destroy_notify_event_t*>(event);
+        removeCachedWindow(destroyEvent->window);
+    } else if (type == XCB_REPARENT_NOTIFY) {
+        xcb_reparent_notify_event_t* reparentEvent = reinterpret_cast<xcb_reparent_notify_event_t*>(event);
+        reparentCachedWindow(reparentEvent->window, reparentEvent->parent);
+    } else if (type == XCB_CONFIGURE_NOTIFY) {
+        xcb_configure_notify_event_t* configureEvent = reinterpret_cast<xcb_configure_notify_event_t*>(event);
+        // only use the copy sent to the parent, moves and resizes report the unchanged sibling
+        if (configureEvent->event != configureEvent->window) {
+            restackCachedWindow(configureEvent->window, configureEvent->above_sibling, false);
+        }
+    } else if (type == XCB_CIRCULATE_NOTIFY) {
+        xcb_circulate_notify_event_t* circulateEvent = reinterpret_cast<xcb_circulate_notify_event_t*>(event);
+        if (circulateEvent->event != circulateEvent->window) {
+            restackCachedWindow(
+                circulateEvent->window, XCB_WINDOW_NONE, circulateEvent->place == XCB_PLACE_ON_TOP);
+        }
+    } else if (type == XCB_PROPERTY_NOTIFY) {
+        xcb_property_notify_event_t* propertyEvent = reinterpret_cast<xcb_property_notify_event_t*>(event);
+        const xcb_atom_t atom = propertyEvent->atom;
+        if ((atom == m_atomWmState || atom == m_atomNetWmName || atom == XCB_ATOM_WM_NAME || atom == XCB_ATOM_WM_CLASS)
+            && atom != XCB_ATOM_NONE && m_windowCache.contains(propertyEvent->window)
+            && !m_newWindows.contains(propertyEvent->window)) {
+            m_dirtyWindows.insert(propertyEvent->window);
+        }
+    }
 }
 
 bool AutoTypePlatformX11::isTopLevelWindow(Window window)
@@ -500,16 +934,22 @@ void AutoTypePlatformX11::updateKeymap()
         XFree(m_keysymTable);
     m_keysymTable = XGetKeyboardMapping(m_dpy, m_minKeycode, m_maxKeycode - m_minKeycode + 1, &m_keysymPerKeycode);
 
-    /* determine the keycode to use for remapped keys */
-    inx = (m_remapKeycode - m_minKeycode) * m_keysymPerKeycode;
-    if (m_remapKeycode == 0 || !isRemapKeycodeValid()) {
-        for (keycode = m_minKeycode; keycode <= m_maxKeycode; keycode++) {
-            inx = (keycode - m_minKeycode) * m_keysymPerKeycode;
-            if (m_keysymTable[inx] == NoSymbol) {
-                m_remapKeycode = keycode;
-                m_currentRemapKeysym = NoSymbol;
-                break;
-            }
+    /* forget remapped keysyms whose keycode was changed by somebody else */
+    for (auto it = m_remappedKeysyms.begin(); it != m_remappedKeysyms.end();) {
+        inx = (it.value() - m_minKeycode) * m_keysymPerKeycode;
+        if (m_keysymTable[inx] != it.key()) {
+            it = m_remappedKeysyms.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    /* determine the keycodes to use for remapped keys */
+    m_remapKeycodes.clear();
+    for (keycode = m_minKeycode; keycode <= m_maxKeycode; keycode++) {
+        inx = (keycode - m_minKeycode) * m_keysymPerKeycode;
+        if (m_keysymTable[inx] == NoSymbol || m_remappedKeysyms.value(m_keysymTable[inx]) == keycode) {
+            m_remapKeycodes.append(static_cast<KeyCode>(keycode));
         }
     }
 
@@ -536,18 +976,6 @@ void AutoTypePlatformX11::updateKeymap()
     nanosleep(&ts, nullptr);
 }
 
-bool AutoTypePlatformX11::isRemapKeycodeValid()
-{
-    int baseKeycode = (m_remapKeycode - m_minKeycode) * m_keysymPerKeycode;
-    for (int i = 0; i < m_keysymPerKeycode; i++) {
-        if (m_keysymTable[baseKeycode + i] == m_currentRemapKeysym) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
 void AutoTypePlatformX11::startCatchXErrors()
 {
     Q_ASSERT(!m_catchXErrors);
@@ -604,40 +1032,111 @@ XkbDescPtr AutoTypePlatformX11::getKeyboard()
 // --------------------------------------------------------------------------
 
 /*
- * Insert a specified keysym on the dedicated position in the keymap
- * table.
+ * Insert a specified keysym on one of the keycodes reserved for
+ * remapping, reusing them in turn.
  */
 int AutoTypePlatformX11::AddKeysym(KeySym keysym)
 {
-    if (m_remapKeycode == 0) {
+    if (m_remapKeycodes.isEmpty()) {
         return 0;
     }
 
-    int inx = (m_remapKeycode - m_minKeycode) * m_keysymPerKeycode;
-    m_keysymTable[inx] = keysym;
-    m_currentRemapKeysym = keysym;
+    KeyCode keycode = m_remapKeycodes[m_nextRemapKeycode++ % m_remapKeycodes.size()];
 
-    XChangeKeyboardMapping(m_dpy, m_remapKeycode, m_keysymPerKeycode, &m_keysymTable[inx], 1);
-    XFlush(m_dpy);
+    QHash<KeyCode, KeySym> mapping;
+    mapping.insert(keycode, keysym);
+    remapKeycodes(mapping);
     updateKeymap();
 
-    return m_remapKeycode;
+    return keycode;
 }
 
 /*
- * Send event to the focused window.
- * If input focus is specified explicitly, select the window
- * before send event to the window.
+ * Maps all keysyms that can't be typed with the current keymap to the
+ * reserved keycodes at once, so the keymap only changes (and has to be
+ * distributed to all clients) once per sequence instead of once per key.
+ * Keysyms that don't fit are remapped one by one by GetKeycode().
  */
-void AutoTypePlatformX11::SendKeyEvent(unsigned keycode, bool press)
+void AutoTypePlatformX11::reserveKeysyms(const QList<KeySym>& keysyms)
 {
-    XSync(m_dpy, False);
-    int (*oldHandler)(Display*, XErrorEvent*) = XSetErrorHandler(MyErrorHandler);
+    QSet<KeyCode> usedKeycodes;
+    QList<KeySym> missingKeysyms;
 
-    XTestFakeKeyEvent(m_dpy, keycode, press, 0);
+    for (KeySym keysym : keysyms) {
+        if (keysym == NoSymbol || missingKeysyms.contains(keysym)) {
+            continue;
+        }
+
+        unsigned int mask;
+        int keycode = XKeysymToKeycode(m_dpy, keysym);
+        if (keycode && keysymModifiers(keysym, keycode, &mask)) {
+            continue;
+        }
+
+        auto remapped = m_remappedKeysyms.constFind(keysym);
+        if (remapped != m_remappedKeysyms.constEnd()) {
+            usedKeycodes.insert(remapped.value());
+            continue;
+        }
+
+        missingKeysyms.append(keysym);
+    }
+
+    QHash<KeyCode, KeySym> mapping;
+    for (KeyCode keycode : asConst(m_remapKeycodes)) {
+        if (missingKeysyms.isEmpty()) {
+            break;
+        }
+        if (!usedKeycodes.contains(keycode)) {
+            mapping.insert(keycode, missingKeysyms.takeFirst());
+        }
+    }
+
+    if (!mapping.isEmpty()) {
+        remapKeycodes(mapping);
+        updateKeymap();
+    }
+}
+
+/*
+ * Changes the keysyms of the given keycodes with a single request.
+ */
+void AutoTypePlatformX11::remapKeycodes(const QHash<KeyCode, KeySym>& mapping)
+{
+    int firstKeycode = m_maxKeycode;
+    int lastKeycode = m_minKeycode;
+
+    for (auto it = mapping.constBegin(); it != mapping.constEnd(); ++it) {
+        const int inx = (it.key() - m_minKeycode) * m_keysymPerKeycode;
+        if (m_remappedKeysyms.value(m_keysymTable[inx]) == it.key()) {
+            m_remappedKeysyms.remove(m_keysymTable[inx]);
+        }
+
+        m_keysymTable[inx] = it.value();
+        if (it.value() != NoSymbol) {
+            m_remappedKeysyms.insert(it.value(), it.key());
+        }
+
+        firstKeycode = qMin(firstKeycode, static_cast<int>(it.key()));
+        lastKeycode = qMax(lastKeycode, static_cast<int>(it.key()));
+    }
+
+    // keycodes in between are rewritten with their current keysyms
+    XChangeKeyboardMapping(m_dpy,
+                           firstKeycode,
+                           m_keysymPerKeycode,
+                           &m_keysymTable[(firstKeycode - m_minKeycode) * m_keysymPerKeycode],
+                           lastKeycode - firstKeycode + 1);
     XFlush(m_dpy);
+}
 
-    XSetErrorHandler(oldHandler);
+/*
+ * Queue a key event for the focused window. Events are only sent
+ * to the server with the next flush.
+ */
+void AutoTypePlatformX11::SendKeyEvent(unsigned keycode, bool press)
+{
+    XTestFakeKeyEvent(m_dpy, keycode, press, 0);
 }
 
 /*
@@ -666,6 +1165,11 @@ int AutoTypePlatformX11::GetKeycode(KeySym keysym, unsigned int* mask)
         return keycode;
     }
 
+    auto remapped = m_remappedKeysyms.constFind(keysym);
+    if (remapped != m_remappedKeysyms.constEnd() && keysymModifiers(keysym, remapped.value(), mask)) {
+        return remapped.value();
+    }
+
     /* no modifier matches => resort to remapping */
     keycode = AddKeysym(keysym);
     if (keycode && keysymModifiers(keysym, keycode, mask)) {
@@ -704,6 +1208,13 @@ bool AutoTypePlatformX11::keysymModifiers(KeySym keysym, int keycode, unsigned i
  */
 void AutoTypePlatformX11::SendKey(KeySym keysym, unsigned int modifiers)
 {
+    if (!m_inKeySequence) {
+        beginKeySequence(QList<KeySym>() << keysym);
+        SendKey(keysym, modifiers);
+        endKeySequence();
+        return;
+    }
+
     if (keysym == NoSymbol) {
         qWarning("No such key: keysym=0x%lX", keysym);
         return;
@@ -720,15 +1231,8 @@ void AutoTypePlatformX11::SendKey(KeySym keysym, unsigned int modifiers)
     }
     wanted_mask |= modifiers;
 
-    Window root, child;
-    int root_x, root_y, x, y;
-    unsigned int original_mask;
-
-    XSync(m_dpy, False);
-    XQueryPointer(m_dpy, m_rootWindow, &root, &child, &root_x, &root_y, &x, &y, &original_mask);
-
-    // modifiers that need to be pressed but aren't
-    unsigned int press_mask = wanted_mask & ~original_mask;
+    // modifiers that were pressed when the sequence started
+    unsigned int original_mask = m_originalModifiers;
 
     // modifiers that are pressed but maybe shouldn't
     unsigned int release_check_mask = original_mask & ~wanted_mask;
@@ -764,25 +1268,75 @@ void AutoTypePlatformX11::SendKey(KeySym keysym, unsigned int modifiers)
         release_mask = release_check_mask;
     }
 
-    /* set modifiers mask */
-    if ((release_mask | press_mask) & LockMask) {
-        SendModifiers(LockMask, true);
-        SendModifiers(LockMask, false);
-    }
-    SendModifiers(release_mask & ~LockMask, false);
-    SendModifiers(press_mask & ~LockMask, true);
+    /* set modifiers mask, they are only restored at the end of the sequence */
+    setModifiers((original_mask & ~release_mask) | wanted_mask);
 
-    /* press and release release key */
+    /* press and release key */
     SendKeyEvent(keycode, true);
     SendKeyEvent(keycode, false);
+}
+
+/*
+ * Prepares typing a sequence of keysyms: remaps all missing keysyms
+ * and reads the current modifier state once.
+ */
+void AutoTypePlatformX11::beginKeySequence(const QList<KeySym>& keysyms)
+{
+    Q_ASSERT(!m_inKeySequence);
+
+    reserveKeysyms(keysyms);
+
+    Window root, child;
+    int root_x, root_y, x, y;
+    unsigned int mask;
+
+    XQueryPointer(m_dpy, m_rootWindow, &root, &child, &root_x, &root_y, &x, &y, &mask);
+
+    m_originalModifiers =
+        mask & (ShiftMask | LockMask | ControlMask | Mod1Mask | Mod2Mask | Mod3Mask | Mod4Mask | Mod5Mask);
+    m_modifierState = m_originalModifiers;
+    m_oldKeyErrorHandler = XSetErrorHandler(MyErrorHandler);
+    m_inKeySequence = true;
+}
 
-    /* restore previous modifiers mask */
-    SendModifiers(press_mask & ~LockMask, false);
-    SendModifiers(release_mask & ~LockMask, true);
-    if ((release_mask | press_mask) & LockMask) {
+/*
+ * Restores the modifiers pressed before the sequence and sends
+ * all pending events.
+ */
+void AutoTypePlatformX11::endKeySequence()
+{
+    if (!m_inKeySequence) {
+        return;
+    }
+
+    setModifiers(m_originalModifiers);
+
+    XSync(m_dpy, False);
+    XSetErrorHandler(m_oldKeyErrorHandler);
+    m_inKeySequence = false;
+}
+
+void AutoTypePlatformX11::flushKeyEvents()
+{
+    XFlush(m_dpy);
+}
+
+/*
+ * Press and release modifiers so that exactly the ones in mask
+ * are active.
+ */
+void AutoTypePlatformX11::setModifiers(unsigned int mask)
+{
+    unsigned int changed = m_modifierState ^ mask;
+
+    if (changed & LockMask) {
         SendModifiers(LockMask, true);
         SendModifiers(LockMask, false);
     }
+    SendModifiers(m_modifierState & changed & ~LockMask, false);
+    SendModifiers(mask & changed & ~LockMask, true);
+
+    m_modifierState = mask;
 }
 
 int AutoTypePlatformX11::MyErrorHandler(Display* my_dpy, XErrorEvent* event)
@@ -812,6 +1366,12 @@ void AutoTypeExecutorX11::execKey(AutoTypeKey* action)
     m_platform->SendKey(m_platform->keyToKeySym(action->key));
 }
 
+void AutoTypeExecutorX11::execDelay(AutoTypeDelay* action)
+{
+    m_platform->flushKeyEvents();
+    AutoTypeExecutor::execDelay(action);
+}
+
 void AutoTypeExecutorX11::execClearField(AutoTypeClearField* action = nullptr)
 {
     Q_UNUSED(action);
@@ -821,15 +1381,41 @@ void AutoTypeExecutorX11::execClearField(AutoTypeClearField* action = nullptr)
     ts.tv_nsec = 25 * 1000 * 1000;
 
     m_platform->SendKey(m_platform->keyToKeySym(Qt::Key_Home), static_cast<unsigned int>(ControlMask));
+    m_platform->flushKeyEvents();
     nanosleep(&ts, nullptr);
 
     m_platform->SendKey(m_platform->keyToKeySym(Qt::Key_End), static_cast<unsigned int>(ControlMask | ShiftMask));
+    m_platform->flushKeyEvents();
     nanosleep(&ts, nullptr);
 
     m_platform->SendKey(m_platform->keyToKeySym(Qt::Key_Backspace));
+    m_platform->flushKeyEvents();
     nanosleep(&ts, nullptr);
 }
 
+/*
+ * Collects the keysyms of the whole sequence so missing ones can be
+ * remapped before the first key is sent.
+ */
+void AutoTypeExecutorX11::execBegin(const QList<AutoTypeAction*>& actions)
+{
+    QList<KeySym> keysyms;
+    for (AutoTypeAction* action : actions) {
+        if (AutoTypeChar* charAction = dynamic_cast<AutoTypeChar*>(action)) {
+            keysyms.append(m_platform->charToKeySym(charAction->character));
+        } else if (AutoTypeKey* keyAction = dynamic_cast<AutoTypeKey*>(action)) {
+            keysyms.append(m_platform->keyToKeySym(keyAction->key));
+        }
+    }
+
+    m_platform->beginKeySequence(keysyms);
+}
+
+void AutoTypeExecutorX11::execEnd()
+{
+    m_platform->endKeySequence();
+}
+
 bool AutoTypePlatformX11::raiseWindow(WId window)
 {
     if (m_atomNetActiveWindow == None) {
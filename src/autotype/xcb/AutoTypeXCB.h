@@ -21,7 +21,9 @@
 #define KEEPASSX_AUTOTYPEXCB_H
 
 #include <QApplication>
+#include <QHash>
 #include <QSet>
+#include <QVector>
 #include <QWidget>
 #include <QX11Info>
 #include <QtPlugin>
@@ -29,6 +31,7 @@
 #include <X11/XKBlib.h>
 #include <X11/Xutil.h>
 #include <X11/extensions/XTest.h>
+#include <xcb/xcb.h>
 
 #include "autotype/AutoTypeAction.h"
 #include "autotype/AutoTypePlatformPlugin.h"
@@ -58,13 +61,55 @@ public:
     KeySym keyToKeySym(Qt::Key key);
 
     void SendKey(KeySym keysym, unsigned int modifiers = 0);
+    void beginKeySequence(const QList<KeySym>& keysyms);
+    void endKeySequence();
+    void flushKeyEvents();
 
 signals:
     void globalShortcutTriggered();
 
 private:
+    struct WindowInfo
+    {
+        WindowInfo()
+            : parent(XCB_WINDOW_NONE)
+            , client(false)
+            , topLevel(false)
+        {
+        }
+
+        xcb_window_t parent;
+        QVector<xcb_window_t> children;
+        bool client;
+        bool topLevel;
+        QString title;
+        QString className;
+    };
+
+    struct PropertyCookies
+    {
+        xcb_get_property_cookie_t wmState;
+        xcb_get_property_cookie_t netWmName;
+        xcb_get_property_cookie_t wmName;
+        xcb_get_property_cookie_t wmClass;
+    };
+
     QString windowTitle(Window window, bool useBlacklist);
-    QStringList windowTitlesRecursive(Window window);
+    void windowTitlesRecursive(xcb_window_t window, const QList<Window>& excludedWindows, QStringList& titles);
+    void updateWindowCache();
+    void scanWindows(QVector<xcb_window_t> windows);
+    void updateWindowProperties(const QList<xcb_window_t>& windows);
+    PropertyCookies requestWindowProperties(xcb_window_t window);
+    void readWindowProperties(const PropertyCookies& cookies, xcb_window_t window);
+    QString textProperty(xcb_get_property_reply_t* reply);
+    void selectWindowEvents(xcb_window_t window, uint32_t eventMask);
+    bool isOwnWindow(xcb_window_t window);
+    void setClientWindow(xcb_window_t window);
+    void addCachedWindow(xcb_window_t window, xcb_window_t parent);
+    void removeCachedWindow(xcb_window_t window);
+    void reparentCachedWindow(xcb_window_t window, xcb_window_t parent);
+    void restackCachedWindow(xcb_window_t window, xcb_window_t sibling, bool onTop);
+    void handleWindowCacheEvent(quint8 type, xcb_generic_event_t* event);
     QString windowClassName(Window window);
     QList<Window> widgetsToX11Windows(const QWidgetList& widgetList);
     bool isTopLevelWindow(Window window);
@@ -75,8 +120,10 @@ private:
 
     XkbDescPtr getKeyboard();
     void updateKeymap();
-    bool isRemapKeycodeValid();
+    void reserveKeysyms(const QList<KeySym>& keysyms);
+    void remapKeycodes(const QHash<KeyCode, KeySym>& mapping);
     int AddKeysym(KeySym keysym);
+    void setModifiers(unsigned int mask);
     void AddModifier(KeySym keysym);
     void SendKeyEvent(unsigned keycode, bool press);
     void SendModifiers(unsigned int mask, bool press);
@@ -112,11 +159,25 @@ private:
     int m_minKeycode;
     int m_maxKeycode;
     int m_keysymPerKeycode;
-    /* dedicated keycode for remapped keys */
-    unsigned int m_remapKeycode;
-    KeySym m_currentRemapKeysym;
+    /* unused keycodes that keysyms missing from the keymap are remapped to */
+    QVector<KeyCode> m_remapKeycodes;
+    QHash<KeySym, KeyCode> m_remappedKeysyms;
+    int m_nextRemapKeycode;
     KeyCode m_modifier_keycode[N_MOD_INDICES];
     bool m_loaded;
+
+    /* modifier state while typing a sequence, tracked locally instead of queried for every key */
+    bool m_inKeySequence;
+    unsigned int m_originalModifiers;
+    unsigned int m_modifierState;
+    int (*m_oldKeyErrorHandler)(Display*, XErrorEvent*);
+
+    /* window tree and titles, kept up to date through X events once enabled */
+    xcb_connection_t* m_connection;
+    bool m_windowCacheActive;
+    QHash<xcb_window_t, WindowInfo> m_windowCache;
+    QSet<xcb_window_t> m_newWindows;
+    QSet<xcb_window_t> m_dirtyWindows;
 };
 
 class AutoTypeExecutorX11 : public AutoTypeExecutor
@@ -126,7 +187,10 @@ public:
 
     void execChar(AutoTypeChar* action) override;
     void execKey(AutoTypeKey* action) override;
+    void execDelay(AutoTypeDelay* action) override;
     void execClearField(AutoTypeClearField* action) override;
+    void execBegin(const QList<AutoTypeAction*>& actions) override;
+    void execEnd() override;
 
 private:
     AutoTypePlatformX11* const m_platform;
@@ -20,6 +20,7 @@
 #include "BrowserSettings.h"
 #include "NativeMessagingBase.h"
 #include "config-keepassx.h"
+#include "core/Base64.h"
 #include "sodium.h"
 #include "sodium/crypto_box.h"
 #include "sodium/randombytes.h"
@@ -491,7 +492,7 @@ QString BrowserAction::encrypt(const QString plaintext, const QString nonce)
 
     if (crypto_box_easy(e.data(), m.data(), m.size(), n.data(), ck.data(), sk.data()) == 0) {
         QByteArray res = getQByteArray(e.data(), (crypto_box_MACBYTES + ma.length()));
-        return res.toBase64();
+        return Base64::encodeToString(res);
     }
 
     return QString();
@@ -526,7 +527,7 @@ QByteArray BrowserAction::decrypt(const QString encrypted, const QString nonce)
 
 QString BrowserAction::getBase64FromKey(const uchar* array, const uint len)
 {
-    return getQByteArray(array, len).toBase64();
+    return Base64::encodeToString(getQByteArray(array, len));
 }
 
 QByteArray BrowserAction::getQByteArray(const uchar* array, const uint len) const
@@ -556,7 +557,7 @@ QJsonObject BrowserAction::getJsonObject(const QByteArray ba) const
 
 QByteArray BrowserAction::base64Decode(const QString str)
 {
-    return QByteArray::fromBase64(str.toUtf8());
+    return Base64::decode(str);
 }
 
 QString BrowserAction::incrementNonce(const QString& nonce)
@@ -565,7 +566,7 @@ QString BrowserAction::incrementNonce(const QString& nonce)
     std::vector<unsigned char> n(nonceArray.cbegin(), nonceArray.cend());
 
     sodium_increment(n.data(), n.size());
-    return getQByteArray(n.data(), n.size()).toBase64();
+    return Base64::encodeToString(getQByteArray(n.data(), n.size()));
 }
 
 void BrowserAction::removeSharedEncryptionKeys()
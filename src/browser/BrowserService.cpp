@@ -32,6 +32,7 @@
 #include "core/Group.h"
 #include "core/Metadata.h"
 #include "core/PasswordGenerator.h"
+#include "core/Trace.h"
 #include "gui/MainWindow.h"
 
 static const QUuid KEEPASSXCBROWSER_UUID = QUuid::fromRfc4122(QByteArray::fromHex("de887cc3036343b8974b5911b8816224"));
@@ -39,6 +40,7 @@ static const char KEEPASSXCBROWSER_NAME[] = "KeePassXC-Browser Settings";
 static const char ASSOCIATE_KEY_PREFIX[] = "Public Key: ";
 static const char KEEPASSXCBROWSER_GROUP_NAME[] = "KeePassXC-Browser Passwords";
 static int KEEPASSXCBROWSER_DEFAULT_ICON = 1;
+static const int MAX_CACHED_RESPONSES = 64;
 
 BrowserService::BrowserService(DatabaseTabWidget* parent)
     : m_dbTabWidget(parent)
@@ -51,6 +53,7 @@ BrowserService::BrowserService(DatabaseTabWidget* parent)
             SIGNAL(activateDatabaseChanged(DatabaseWidget*)),
             this,
             SLOT(activateDatabaseChanged(DatabaseWidget*)));
+    connect(m_dbTabWidget, SIGNAL(databaseWithFileClosed(QString)), this, SLOT(clearResponseCache()));
 }
 
 bool BrowserService::isDatabaseOpened() const
@@ -243,6 +246,30 @@ QJsonArray BrowserService::findMatchingEntries(const QString& id,
         return result;
     }
 
+    TRACE_SPAN("browser", "BrowserService::findMatchingEntries");
+
+    // Answer repeated requests from the cache as long as no database has changed
+    const QString generations = databaseGenerations();
+    if (generations != m_responseCacheGenerations) {
+        m_responseCache.clear();
+        m_responseCacheGenerations = generations;
+    }
+
+    const QString cacheKey = responseCacheKey(id, url, submitUrl, realm, keyList);
+    auto cached = m_responseCache.constFind(cacheKey);
+    if (cached != m_responseCache.constEnd()) {
+        if (!cached->validUntil.isValid() || cached->validUntil > QDateTime::currentDateTimeUtc()) {
+            // Only the matches are cached, passwords are never kept outside of the database
+            for (const QPointer<Entry>& entry : cached->entries) {
+                if (entry) {
+                    result << prepareEntry(entry);
+                }
+            }
+            return result;
+        }
+        m_responseCache.remove(cacheKey);
+    }
+
     const bool alwaysAllowAccess = BrowserSettings::alwaysAllowAccess();
     const QString host = QUrl(url).host();
     const QString submitHost = QUrl(submitUrl).host();
@@ -269,21 +296,43 @@ QJsonArray BrowserService::findMatchingEntries(const QString& id,
         }
     }
 
+    // Results that required user interaction must not be reused
+    bool cacheable = pwEntriesToConfirm.isEmpty();
+
     // Confirm entries
     if (confirmEntries(pwEntriesToConfirm, url, host, submitHost, realm)) {
         pwEntries.append(pwEntriesToConfirm);
     }
 
-    if (pwEntries.isEmpty()) {
-        return QJsonArray();
-    }
-
     // Sort results
-    pwEntries = sortEntries(pwEntries, host, submitUrl);
+    if (!pwEntries.isEmpty()) {
+        pwEntries = sortEntries(pwEntries, host, submitUrl);
+    }
 
     // Fill the list
+    QDateTime validUntil;
     for (Entry* entry : pwEntries) {
         result << prepareEntry(entry);
+
+        // Expiring entries drop out of the result
+        if (entry->timeInfo().expires()) {
+            const QDateTime expiryTime = entry->timeInfo().expiryTime();
+            if (!validUntil.isValid() || expiryTime < validUntil) {
+                validUntil = expiryTime;
+            }
+        }
+    }
+
+    if (cacheable) {
+        if (m_responseCache.size() >= MAX_CACHED_RESPONSES) {
+            m_responseCache.clear();
+        }
+        ResponseCache response;
+        for (Entry* entry : pwEntries) {
+            response.entries.append(entry);
+        }
+        response.validUntil = validUntil;
+        m_responseCache.insert(cacheKey, response);
     }
 
     return result;
@@ -388,11 +437,11 @@ QList<Entry*> BrowserService::searchEntries(Database* db, const QString& hostnam
         return entries;
     }
 
+    const QUrl qUrl(url);
     for (Entry* entry : EntrySearcher().search(hostname, rootGroup, Qt::CaseInsensitive)) {
-        QString entryUrl = entry->url();
-        QUrl entryQUrl(entryUrl);
-        QString entryScheme = entryQUrl.scheme();
-        QUrl qUrl(url);
+        const QString entryUrl = entry->url();
+        const QUrl entryQUrl = entryCache(entry).url;
+        const QString entryScheme = entryQUrl.scheme();
 
         // Ignore entry if port or scheme defined in the URL doesn't match    
         if ((entryQUrl.port() > 0 && entryQUrl.port() != qUrl.port()) ||
@@ -402,7 +451,7 @@ QList<Entry*> BrowserService::searchEntries(Database* db, const QString& hostnam
 
         // Filter to match hostname in URL field
         if ((!entryUrl.isEmpty() && hostname.contains(entryUrl))
-            || (matchUrlScheme(entryUrl) && hostname.endsWith(entryQUrl.host()))) {
+            || (!entryScheme.isEmpty() && hostname.endsWith(entryQUrl.host()))) {
                 entries.append(entry);
         }
     }
@@ -660,20 +709,20 @@ QJsonObject BrowserService::prepareEntry(const Entry* entry)
 BrowserService::Access
 BrowserService::checkAccess(const Entry* entry, const QString& host, const QString& submitHost, const QString& realm)
 {
-    BrowserEntryConfig config;
-    if (!config.load(entry)) {
+    const BrowserEntryConfig* config = entryCache(entry).config.data();
+    if (!config) {
         return Unknown;
     }
     if (entry->isExpired()) {
         return Denied;
     }
-    if ((config.isAllowed(host)) && (submitHost.isEmpty() || config.isAllowed(submitHost))) {
+    if ((config->isAllowed(host)) && (submitHost.isEmpty() || config->isAllowed(submitHost))) {
         return Allowed;
     }
-    if ((config.isDenied(host)) || (!submitHost.isEmpty() && config.isDenied(submitHost))) {
+    if ((config->isDenied(host)) || (!submitHost.isEmpty() && config->isDenied(submitHost))) {
         return Denied;
     }
-    if (!realm.isEmpty() && config.realm() != realm) {
+    if (!realm.isEmpty() && config->realm() != realm) {
         return Denied;
     }
     return Unknown;
@@ -713,13 +762,9 @@ int BrowserService::sortPriority(const Entry* entry,
                                  const QString& submitUrl,
                                  const QString& baseSubmitUrl) const
 {
-    QUrl url(entry->url());
-    if (url.scheme().isEmpty()) {
-        url.setScheme("http");
-    }
-    const QString entryURL = url.toString(QUrl::StripTrailingSlash);
-    const QString baseEntryURL =
-        url.toString(QUrl::StripTrailingSlash | QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment);
+    const EntryCache& cache = entryCache(entry);
+    const QString& entryURL = cache.entryUrl;
+    const QString& baseEntryURL = cache.baseEntryUrl;
 
     if (submitUrl == entryURL) {
         return 100;
@@ -757,12 +802,6 @@ int BrowserService::sortPriority(const Entry* entry,
     return 0;
 }
 
-bool BrowserService::matchUrlScheme(const QString& url)
-{
-    QUrl address(url);
-    return !address.scheme().isEmpty();
-}
-
 bool BrowserService::removeFirstDomain(QString& hostname)
 {
     int pos = hostname.indexOf(".");
@@ -790,9 +829,102 @@ Database* BrowserService::getDatabase()
     return nullptr;
 }
 
+/**
+ * Returns the parsed browser settings and URL of an entry. The data is
+ * computed on first use and dropped as soon as the entry is modified.
+ */
+const BrowserService::EntryCache& BrowserService::entryCache(const Entry* entry) const
+{
+    auto it = m_entryCache.find(entry);
+    if (it != m_entryCache.end()) {
+        return it.value();
+    }
+
+    EntryCache cache;
+    cache.config.reset(new BrowserEntryConfig());
+    if (!cache.config->load(entry)) {
+        cache.config.reset();
+    }
+
+    cache.url = QUrl(entry->url());
+    QUrl url(cache.url);
+    if (url.scheme().isEmpty()) {
+        url.setScheme("http");
+    }
+    cache.entryUrl = url.toString(QUrl::StripTrailingSlash);
+    cache.baseEntryUrl =
+        url.toString(QUrl::StripTrailingSlash | QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment);
+
+    connect(entry, SIGNAL(modified()), SLOT(clearEntryCache()), Qt::UniqueConnection);
+    connect(entry, SIGNAL(destroyed()), SLOT(clearEntryCache()), Qt::UniqueConnection);
+    return m_entryCache.insert(entry, cache).value();
+}
+
+void BrowserService::clearEntryCache()
+{
+    m_entryCache.remove(sender());
+}
+
+void BrowserService::clearResponseCache()
+{
+    m_responseCache.clear();
+    m_responseCacheGenerations.clear();
+}
+
+int BrowserService::responseCacheSize() const
+{
+    return m_responseCache.size();
+}
+
+QString BrowserService::responseCacheKey(const QString& id,
+                                         const QString& url,
+                                         const QString& submitUrl,
+                                         const QString& realm,
+                                         const StringPairList& keyList) const
+{
+    QStringList key;
+    key << id << url << submitUrl << realm;
+    for (const StringPair& keyPair : keyList) {
+        key << keyPair.first << keyPair.second;
+    }
+
+    // Settings influencing the result
+    key << QString::number(BrowserSettings::alwaysAllowAccess()) << QString::number(BrowserSettings::bestMatchOnly())
+        << QString::number(BrowserSettings::sortByTitle()) << QString::number(BrowserSettings::matchUrlScheme())
+        << QString::number(BrowserSettings::supportKphFields())
+        << QString::number(BrowserSettings::searchInAllDatabases());
+    return key.join(QChar('\n'));
+}
+
+/**
+ * Returns a string identifying the current state of all open databases.
+ * It changes whenever a database is opened, closed, activated or modified.
+ */
+QString BrowserService::databaseGenerations() const
+{
+    QStringList generations;
+    if (DatabaseWidget* dbWidget = m_dbTabWidget->currentDatabaseWidget()) {
+        if (Database* db = dbWidget->database()) {
+            generations << db->uuid().toString();
+        }
+    }
+
+    const int count = m_dbTabWidget->count();
+    for (int i = 0; i < count; ++i) {
+        if (DatabaseWidget* dbWidget = qobject_cast<DatabaseWidget*>(m_dbTabWidget->widget(i))) {
+            if (Database* db = dbWidget->database()) {
+                generations << QString("%1:%2").arg(db->uuid().toString()).arg(db->generation());
+            }
+        }
+    }
+    return generations.join(QChar(';'));
+}
+
 void BrowserService::databaseLocked(DatabaseWidget* dbWidget)
 {
     if (dbWidget) {
+        // never answer from entries of a locked database
+        clearResponseCache();
         emit databaseLocked();
     }
 }
@@ -25,6 +25,8 @@
 #include <QObject>
 #include <QtCore>
 
+class BrowserEntryConfig;
+
 typedef QPair<QString, QString> StringPair;
 typedef QList<StringPair> StringPairList;
 
@@ -56,6 +58,7 @@ public:
     QList<Entry*> searchEntries(const QString& url, const StringPairList& keyList);
     void removeSharedEncryptionKeys();
     void removeStoredPermissions();
+    int responseCacheSize() const;
 
 public slots:
     QJsonArray findMatchingEntries(const QString& id,
@@ -74,6 +77,10 @@ public slots:
     void activateDatabaseChanged(DatabaseWidget* dbWidget);
     void lockDatabase();
 
+private slots:
+    void clearEntryCache();
+    void clearResponseCache();
+
 signals:
     void databaseLocked();
     void databaseUnlocked();
@@ -87,6 +94,21 @@ private:
         Allowed
     };
 
+    struct EntryCache
+    {
+        QSharedPointer<BrowserEntryConfig> config;
+        QUrl url;
+        QString entryUrl;
+        QString baseEntryUrl;
+    };
+
+    // The matched entries of a request, the response is built from them again for each answer
+    struct ResponseCache
+    {
+        QList<QPointer<Entry>> entries;
+        QDateTime validUntil;
+    };
+
 private:
     QList<Entry*> sortEntries(QList<Entry*>& pwEntries, const QString& host, const QString& submitUrl);
     bool confirmEntries(QList<Entry*>& pwEntriesToConfirm,
@@ -99,14 +121,24 @@ private:
     Group* findCreateAddEntryGroup();
     int
     sortPriority(const Entry* entry, const QString& host, const QString& submitUrl, const QString& baseSubmitUrl) const;
-    bool matchUrlScheme(const QString& url);
     bool removeFirstDomain(QString& hostname);
     Database* getDatabase();
+    const EntryCache& entryCache(const Entry* entry) const;
+    QString responseCacheKey(const QString& id,
+                             const QString& url,
+                             const QString& submitUrl,
+                             const QString& realm,
+                             const StringPairList& keyList) const;
+    QString databaseGenerations() const;
 
 private:
     DatabaseTabWidget* const m_dbTabWidget;
     bool m_dialogActive;
     bool m_bringToFrontRequested;
+
+    mutable QHash<const QObject*, EntryCache> m_entryCache;
+    QHash<QString, ResponseCache> m_responseCache;
+    QString m_responseCacheGenerations;
 };
 
 #endif // BROWSERSERVICE_H
@@ -37,7 +37,9 @@ NativeMessagingHost::NativeMessagingHost(DatabaseTabWidget* parent, const bool e
     m_localServer->setSocketOptions(QLocalServer::UserAccessOption);
     m_running.store(false);
 
-    if (BrowserSettings::isEnabled() && !m_running) {
+    // Browsers talking over stdin expect an answer right away, the proxy
+    // socket is only started once the main window is on screen
+    if (BrowserSettings::isEnabled() && !BrowserSettings::supportBrowserProxy()) {
         run();
     }
 
@@ -81,7 +81,9 @@ int Add::execute(const QStringList& arguments)
     parser.addOption(length);
 
     parser.addPositionalArgument("entry", QObject::tr("Path of the entry to add."));
-    parser.process(arguments);
+    if (!parseArguments(parser, arguments)) {
+        return EXIT_FAILURE;
+    }
 
     const QStringList args = parser.positionalArguments();
     if (args.size() != 2) {
@@ -92,7 +94,7 @@ int Add::execute(const QStringList& arguments)
     QString databasePath = args.at(0);
     QString entryPath = args.at(1);
 
-    Database* db = Database::unlockFromStdin(databasePath, parser.value(keyFile));
+    Database* db = Utils::unlockDatabase(databasePath, parser.value(keyFile));
     if (db == nullptr) {
         return EXIT_FAILURE;
     }
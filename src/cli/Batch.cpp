@@ -0,0 +1,480 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <stdio.h>
+
+#include "Batch.h"
+
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include "cli/Utils.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "core/Metadata.h"
+#include "core/PasswordGenerator.h"
+#include "core/Tools.h"
+
+namespace
+{
+    /*
+     * Positional arguments of each command in the plain text syntax,
+     * e.g. "export Sample/Entry Password".
+     */
+    const QHash<QString, QStringList> PositionalArguments = {{"show", {"entry"}},
+                                                             {"add", {"entry"}},
+                                                             {"edit", {"entry"}},
+                                                             {"rm", {"entry"}},
+                                                             {"locate", {"term"}},
+                                                             {"export", {"entry", "field"}}};
+
+    struct BatchState
+    {
+        Database* db;
+        bool modified;
+    };
+
+    bool tokenize(const QString& line, QStringList& tokens)
+    {
+        QString token;
+        bool inToken = false;
+        QChar quote;
+
+        for (int i = 0; i < line.size(); ++i) {
+            const QChar c = line.at(i);
+            if (!quote.isNull()) {
+                if (c == quote) {
+                    quote = QChar();
+                } else if (c == '\\' && quote == '"' && i + 1 < line.size()) {
+                    token.append(line.at(++i));
+                } else {
+                    token.append(c);
+                }
+            } else if (c.isSpace()) {
+                if (inToken) {
+                    tokens.append(token);
+                    token.clear();
+                    inToken = false;
+                }
+            } else {
+                inToken = true;
+                if (c == '"' || c == '\'') {
+                    quote = c;
+                } else if (c == '\\' && i + 1 < line.size()) {
+                    token.append(line.at(++i));
+                } else {
+                    token.append(c);
+                }
+            }
+        }
+
+        if (!quote.isNull()) {
+            return false;
+        }
+        if (inToken) {
+            tokens.append(token);
+        }
+        return true;
+    }
+
+    /*
+     * Turns "command arg... --option value --flag" into the same object a
+     * JSON request would give. --attribute can be repeated for show.
+     */
+    bool parseTextRequest(const QString& line, QJsonObject& request, QString& error)
+    {
+        QStringList tokens;
+        if (!tokenize(line, tokens)) {
+            error = QObject::tr("Unterminated quote.");
+            return false;
+        }
+
+        if (tokens.isEmpty()) {
+            error = QObject::tr("Missing command.");
+            return false;
+        }
+
+        const QString command = tokens.takeFirst();
+        request.insert("command", command);
+
+        const QStringList positionalNames = PositionalArguments.value(command);
+        int position = 0;
+        QJsonArray attributes;
+
+        while (!tokens.isEmpty()) {
+            QString token = tokens.takeFirst();
+            if (!token.startsWith("--")) {
+                if (position >= positionalNames.size()) {
+                    error = QObject::tr("Unexpected argument %1.").arg(token);
+                    return false;
+                }
+                request.insert(positionalNames.at(position++), token);
+                continue;
+            }
+
+            QString name = token.mid(2);
+            QString value;
+            const int separator = name.indexOf('=');
+            if (separator >= 0) {
+                value = name.mid(separator + 1);
+                name.truncate(separator);
+            } else if (name == "generate") {
+                request.insert(name, true);
+                continue;
+            } else if (tokens.isEmpty()) {
+                error = QObject::tr("Missing value for option --%1.").arg(name);
+                return false;
+            } else {
+                value = tokens.takeFirst();
+            }
+
+            if (name == "attribute") {
+                attributes.append(value);
+            } else if (name == "length") {
+                request.insert(name, value.toInt());
+            } else {
+                request.insert(name, value);
+            }
+        }
+
+        if (!attributes.isEmpty()) {
+            request.insert("attributes", attributes);
+        }
+        return true;
+    }
+
+    Entry* findEntry(BatchState& state, const QJsonObject& request, QJsonObject& response, QString& error)
+    {
+        const QString entryPath = request.value("entry").toString();
+        if (entryPath.isEmpty()) {
+            error = QObject::tr("Missing entry path.");
+            return nullptr;
+        }
+
+        Entry* entry = state.db->rootGroup()->findEntryByPath(entryPath);
+        if (!entry) {
+            error = QObject::tr("Could not find entry with path %1.").arg(entryPath);
+            return nullptr;
+        }
+
+        response.insert("entry", entryPath);
+        return entry;
+    }
+
+    // Checked before anything is changed, so failed requests leave no trace in the database
+    bool validateEntryFields(const QJsonObject& request, QString& error)
+    {
+        if (request.contains("length") && request.value("length").toInt() <= 0) {
+            error = QObject::tr("Invalid value for password length.");
+            return false;
+        }
+        return true;
+    }
+
+    void setEntryFields(Entry* entry, const QJsonObject& request)
+    {
+        if (request.contains("title")) {
+            entry->setTitle(request.value("title").toString());
+        }
+        if (request.contains("username")) {
+            entry->setUsername(request.value("username").toString());
+        }
+        if (request.contains("url")) {
+            entry->setUrl(request.value("url").toString());
+        }
+
+        if (request.contains("password")) {
+            entry->setPassword(request.value("password").toString());
+        } else if (request.value("generate").toBool()) {
+            PasswordGenerator passwordGenerator;
+            passwordGenerator.setLength(request.value("length").toInt(PasswordGenerator::DefaultLength));
+            passwordGenerator.setCharClasses(PasswordGenerator::DefaultCharset);
+            passwordGenerator.setFlags(PasswordGenerator::DefaultFlags);
+            entry->setPassword(passwordGenerator.generatePassword());
+        }
+    }
+
+    bool showEntry(BatchState& state, const QJsonObject& request, QJsonObject& response, QString& error)
+    {
+        Entry* entry = findEntry(state, request, response, error);
+        if (!entry) {
+            return false;
+        }
+
+        QStringList attributes;
+        for (const QJsonValue& attribute : request.value("attributes").toArray()) {
+            attributes.append(attribute.toString());
+        }
+        if (attributes.isEmpty()) {
+            attributes = EntryAttributes::DefaultAttributes;
+        }
+
+        QJsonObject values;
+        for (const QString& attribute : asConst(attributes)) {
+            if (!entry->attributes()->contains(attribute)) {
+                error = QObject::tr("Unknown attribute %1.").arg(attribute);
+                return false;
+            }
+            values.insert(attribute, entry->resolveMultiplePlaceholders(entry->attributes()->value(attribute)));
+        }
+
+        response.insert("attributes", values);
+        return true;
+    }
+
+    bool exportField(BatchState& state, const QJsonObject& request, QJsonObject& response, QString& error)
+    {
+        Entry* entry = findEntry(state, request, response, error);
+        if (!entry) {
+            return false;
+        }
+
+        const QString field = request.value("field").toString(EntryAttributes::PasswordKey);
+        if (!entry->attributes()->contains(field)) {
+            error = QObject::tr("Unknown attribute %1.").arg(field);
+            return false;
+        }
+
+        response.insert("field", field);
+        response.insert("value", entry->resolveMultiplePlaceholders(entry->attributes()->value(field)));
+        return true;
+    }
+
+    bool addEntry(BatchState& state, const QJsonObject& request, QJsonObject& response, QString& error)
+    {
+        const QString entryPath = request.value("entry").toString();
+        if (entryPath.isEmpty()) {
+            error = QObject::tr("Missing entry path.");
+            return false;
+        }
+        if (!validateEntryFields(request, error)) {
+            return false;
+        }
+
+        Entry* entry = state.db->rootGroup()->addEntryWithPath(entryPath);
+        if (!entry) {
+            error = QObject::tr("Could not create entry with path %1.").arg(entryPath);
+            return false;
+        }
+
+        setEntryFields(entry, request);
+        state.modified = true;
+        response.insert("entry", entryPath);
+        return true;
+    }
+
+    bool editEntry(BatchState& state, const QJsonObject& request, QJsonObject& response, QString& error)
+    {
+        Entry* entry = findEntry(state, request, response, error);
+        if (!entry || !validateEntryFields(request, error)) {
+            return false;
+        }
+
+        entry->beginUpdate();
+        setEntryFields(entry, request);
+        if (entry->endUpdate()) {
+            state.modified = true;
+        }
+
+        return true;
+    }
+
+    bool removeEntry(BatchState& state, const QJsonObject& request, QJsonObject& response, QString& error)
+    {
+        Entry* entry = findEntry(state, request, response, error);
+        if (!entry) {
+            return false;
+        }
+
+        Metadata* metadata = state.db->metadata();
+        if (Tools::hasChild(metadata->recycleBin(), entry) || !metadata->recycleBinEnabled()) {
+            delete entry;
+            response.insert("recycled", false);
+        } else {
+            state.db->recycleEntry(entry);
+            response.insert("recycled", true);
+        }
+
+        state.modified = true;
+        return true;
+    }
+
+    bool locateEntries(BatchState& state, const QJsonObject& request, QJsonObject& response, QString& error)
+    {
+        const QString term = request.value("term").toString();
+        if (term.isEmpty()) {
+            error = QObject::tr("Missing search term.");
+            return false;
+        }
+
+        response.insert("entries", QJsonArray::fromStringList(state.db->rootGroup()->locate(term)));
+        return true;
+    }
+
+    QJsonObject handleRequest(BatchState& state, const QJsonObject& request)
+    {
+        typedef bool (*Handler)(BatchState&, const QJsonObject&, QJsonObject&, QString&);
+        static const QHash<QString, Handler> handlers = {{"show", showEntry},
+                                                         {"export", exportField},
+                                                         {"add", addEntry},
+                                                         {"edit", editEntry},
+                                                         {"rm", removeEntry},
+                                                         {"locate", locateEntries}};
+
+        QJsonObject response;
+        if (request.contains("id")) {
+            response.insert("id", request.value("id"));
+        }
+
+        const QString command = request.value("command").toString();
+        QString error;
+        bool success = false;
+
+        Handler handler = handlers.value(command);
+        if (handler) {
+            success = handler(state, request, response, error);
+        } else {
+            error = QObject::tr("Invalid command %1.").arg(command);
+        }
+
+        response.insert("ok", success);
+        if (!success) {
+            response.insert("error", error);
+        }
+        return response;
+    }
+} // namespace
+
+/**
+ * Parse a request line, either a JSON object or the plain text syntax.
+ *
+ * @return true if line is a valid request
+ */
+bool Batch::parseRequest(const QString& line, QJsonObject& request, QString& error)
+{
+    if (line.startsWith('{')) {
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(line.toUtf8(), &parseError);
+        if (parseError.error != QJsonParseError::NoError) {
+            error = parseError.errorString();
+            return false;
+        }
+        request = document.object();
+        return true;
+    }
+    return parseTextRequest(line, request, error);
+}
+
+/**
+ * Run a parsed request against db.
+ *
+ * @param modified set if the request changed the database
+ * @return response object, with "ok" and an "error" for failed requests
+ */
+QJsonObject Batch::runRequest(Database* db, const QJsonObject& request, bool& modified)
+{
+    BatchState state = {db, modified};
+    const QJsonObject response = handleRequest(state, request);
+    modified = state.modified;
+    return response;
+}
+
+Batch::Batch()
+{
+    name = QString("batch");
+    description = QObject::tr("Run commands read from stdin against the database.");
+}
+
+Batch::~Batch()
+{
+}
+
+int Batch::execute(const QStringList& arguments)
+{
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(this->description);
+    parser.addPositionalArgument("database", QObject::tr("Path of the database."));
+    QCommandLineOption keyFile(QStringList() << "k"
+                                             << "key-file",
+                               QObject::tr("Key file of the database."),
+                               QObject::tr("path"));
+    parser.addOption(keyFile);
+    if (!parseArguments(parser, arguments)) {
+        return EXIT_FAILURE;
+    }
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 1) {
+        out << parser.helpText().replace("keepassxc-cli", "keepassxc-cli batch");
+        return EXIT_FAILURE;
+    }
+
+    const QString databasePath = args.at(0);
+    Database* db = Utils::unlockDatabase(databasePath, parser.value(keyFile));
+    if (!db) {
+        return EXIT_FAILURE;
+    }
+
+    // The password was read from the same stream, anything it buffered
+    // already belongs to the commands.
+    QTextStream& in = Utils::stdinTextStream();
+    bool modified = false;
+    bool failed = false;
+
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        QJsonObject request;
+        QString error;
+        QJsonObject response;
+        if (parseRequest(line, request, error)) {
+            response = runRequest(db, request, modified);
+        } else {
+            response.insert("ok", false);
+            response.insert("error", error);
+        }
+
+        failed |= !response.value("ok").toBool();
+        out << QJsonDocument(response).toJson(QJsonDocument::Compact) << endl;
+    }
+
+    // All changes are written at once after the last command.
+    if (modified) {
+        QJsonObject response;
+        response.insert("command", QString("save"));
+
+        const QString errorMessage = db->saveToFile(databasePath);
+        response.insert("ok", errorMessage.isEmpty());
+        if (!errorMessage.isEmpty()) {
+            response.insert("error", errorMessage);
+            failed = true;
+        }
+        out << QJsonDocument(response).toJson(QJsonDocument::Compact) << endl;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
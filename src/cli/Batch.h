@@ -0,0 +1,36 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_BATCH_H
+#define KEEPASSXC_BATCH_H
+
+#include "Command.h"
+
+#include <QJsonObject>
+
+class Batch : public Command
+{
+public:
+    Batch();
+    ~Batch();
+    int execute(const QStringList& arguments);
+
+    static bool parseRequest(const QString& line, QJsonObject& request, QString& error);
+    static QJsonObject runRequest(Database* db, const QJsonObject& request, bool& modified);
+};
+
+#endif // KEEPASSXC_BATCH_H
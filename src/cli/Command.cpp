@@ -18,11 +18,13 @@
 #include <cstdlib>
 #include <stdio.h>
 
+#include <QCommandLineParser>
 #include <QMap>
 
 #include "Command.h"
 
 #include "Add.h"
+#include "Batch.h"
 #include "Clip.h"
 #include "Diceware.h"
 #include "Edit.h"
@@ -32,8 +34,10 @@
 #include "List.h"
 #include "Locate.h"
 #include "Merge.h"
+#include "Open.h"
 #include "Remove.h"
 #include "Show.h"
+#include "Stats.h"
 
 QMap<QString, Command*> commands;
 
@@ -58,10 +62,25 @@ QString Command::getDescriptionLine()
     return response;
 }
 
+/*
+ * Same as QCommandLineParser::process(), but returns false instead of
+ * exiting on invalid arguments, as commands also run inside a session.
+ */
+bool Command::parseArguments(QCommandLineParser& parser, const QStringList& arguments)
+{
+    if (!parser.parse(arguments)) {
+        qCritical("%s", qPrintable(parser.errorText()));
+        return false;
+    }
+
+    return true;
+}
+
 void populateCommands()
 {
     if (commands.isEmpty()) {
         commands.insert(QString("add"), new Add());
+        commands.insert(QString("batch"), new Batch());
         commands.insert(QString("clip"), new Clip());
         commands.insert(QString("diceware"), new Diceware());
         commands.insert(QString("edit"), new Edit());
@@ -71,8 +90,10 @@ void populateCommands()
         commands.insert(QString("locate"), new Locate());
         commands.insert(QString("ls"), new List());
         commands.insert(QString("merge"), new Merge());
+        commands.insert(QString("open"), new Open());
         commands.insert(QString("rm"), new Remove());
         commands.insert(QString("show"), new Show());
+        commands.insert(QString("stats"), new Stats());
     }
 }
 
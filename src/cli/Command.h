@@ -25,6 +25,8 @@
 
 #include "core/Database.h"
 
+class QCommandLineParser;
+
 class Command
 {
 public:
@@ -36,6 +38,9 @@ public:
 
     static QList<Command*> getCommands();
     static Command* getCommand(QString commandName);
+
+protected:
+    static bool parseArguments(QCommandLineParser& parser, const QStringList& arguments);
 };
 
 #endif // KEEPASSXC_COMMAND_H
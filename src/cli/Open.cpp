@@ -0,0 +1,212 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <stdio.h>
+
+#include "Open.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "cli/Session.h"
+#include "cli/Utils.h"
+#include "core/Database.h"
+#include "keys/CompositeKey.h"
+#include "keys/FileKey.h"
+#include "keys/PasswordKey.h"
+
+namespace
+{
+    const int DefaultIdleTimeout = 600;
+
+    // quote a value for the shell evaluating our output
+    QString shellQuote(QString value)
+    {
+        return "'" + value.replace("'", "'\\''") + "'";
+    }
+} // namespace
+
+Open::Open()
+{
+    name = QString("open");
+    description = QObject::tr("Keep a database unlocked in a background session.");
+}
+
+Open::~Open()
+{
+}
+
+int Open::execute(const QStringList& arguments)
+{
+    QTextStream out(stdout);
+    QTextStream errorTextStream(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(this->description);
+    parser.addPositionalArgument("database", QObject::tr("Path of the database."));
+    QCommandLineOption keyFile(QStringList() << "k"
+                                             << "key-file",
+                               QObject::tr("Key file of the database."),
+                               QObject::tr("path"));
+    parser.addOption(keyFile);
+    QCommandLineOption timeout(QStringList() << "t"
+                                             << "timeout",
+                               QObject::tr("Close the session after this many seconds without a command, "
+                                           "0 keeps it open. Default: %1.")
+                                   .arg(DefaultIdleTimeout),
+                               QObject::tr("seconds"));
+    parser.addOption(timeout);
+    if (!parseArguments(parser, arguments)) {
+        return EXIT_FAILURE;
+    }
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 1) {
+        out << parser.helpText().replace("keepassxc-cli", "keepassxc-cli open");
+        return EXIT_FAILURE;
+    }
+
+    int idleTimeout = DefaultIdleTimeout;
+    if (parser.isSet(timeout)) {
+        bool ok;
+        idleTimeout = parser.value(timeout).toInt(&ok);
+        if (!ok || idleTimeout < 0) {
+            qCritical("Invalid timeout value %s.", qPrintable(parser.value(timeout)));
+            return EXIT_FAILURE;
+        }
+    }
+
+#ifdef Q_OS_UNIX
+    const QString databasePath = args.at(0);
+
+    // The output is meant to be evaluated by the shell, so the prompt goes to stderr.
+    errorTextStream << QObject::tr("Insert password to unlock %1: ").arg(databasePath);
+    errorTextStream.flush();
+
+    CompositeKey compositeKey;
+    PasswordKey passwordKey;
+    passwordKey.setPassword(Utils::getPassword());
+    compositeKey.addKey(passwordKey);
+
+    if (parser.isSet(keyFile)) {
+        FileKey fileKey;
+        QString errorMessage;
+        if (!fileKey.load(parser.value(keyFile), &errorMessage)) {
+            errorTextStream << QObject::tr("Failed to load key file %1: %2").arg(parser.value(keyFile), errorMessage);
+            errorTextStream << endl;
+            return EXIT_FAILURE;
+        }
+        compositeKey.addKey(fileKey);
+    }
+
+    QByteArray socketDirTemplate = QFile::encodeName(QDir::tempPath() + "/keepassxc-cli-XXXXXX");
+    if (!mkdtemp(socketDirTemplate.data())) {
+        qCritical("Unable to create the session directory: %s", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    const QString socketDir = QFile::decodeName(socketDirTemplate);
+    const QString socketPath = socketDir + "/session";
+
+    int socket = Session::listen(socketPath);
+    if (socket < 0) {
+        QDir().rmdir(socketDir);
+        return EXIT_FAILURE;
+    }
+
+    // The database is only opened after forking, the key derivation may
+    // start threads which would not survive the fork.
+    int statusPipe[2];
+    if (pipe(statusPipe) != 0) {
+        qCritical("Unable to start the session: %s", strerror(errno));
+        close(socket);
+        QFile::remove(socketPath);
+        QDir().rmdir(socketDir);
+        return EXIT_FAILURE;
+    }
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(statusPipe[0]);
+        setsid();
+
+        Database* db = Database::openDatabaseFile(databasePath, compositeKey);
+        const char status = db ? 0 : 1;
+        while (write(statusPipe[1], &status, 1) < 0 && errno == EINTR) {
+        }
+        close(statusPipe[1]);
+
+        if (!db) {
+            close(socket);
+            return EXIT_FAILURE;
+        }
+
+        int devNull = ::open("/dev/null", O_RDWR);
+        if (devNull >= 0) {
+            dup2(devNull, STDIN_FILENO);
+            dup2(devNull, STDOUT_FILENO);
+            dup2(devNull, STDERR_FILENO);
+            close(devNull);
+        }
+
+        int exitCode = Session::serve(socket, db, databasePath, idleTimeout);
+        QFile::remove(socketPath);
+        QDir().rmdir(socketDir);
+        return exitCode;
+    }
+
+    close(statusPipe[1]);
+    close(socket);
+
+    char status = 1;
+    if (pid > 0) {
+        while (read(statusPipe[0], &status, 1) < 0 && errno == EINTR) {
+        }
+    } else {
+        qCritical("Unable to start the session: %s", strerror(errno));
+    }
+    close(statusPipe[0]);
+
+    if (status != 0) {
+        if (pid > 0) {
+            waitpid(pid, nullptr, 0);
+        }
+        QFile::remove(socketPath);
+        QDir().rmdir(socketDir);
+        return EXIT_FAILURE;
+    }
+
+    out << Session::SocketVariable << "=" << shellQuote(socketPath) << "; export " << Session::SocketVariable << ";" << endl;
+    out << Session::PidVariable << "=" << pid << "; export " << Session::PidVariable << ";" << endl;
+    return EXIT_SUCCESS;
+#else
+    Q_UNUSED(keyFile);
+    Q_UNUSED(idleTimeout);
+    qCritical("Sessions are only supported on Unix.");
+    return EXIT_FAILURE;
+#endif
+}
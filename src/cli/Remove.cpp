@@ -55,7 +55,9 @@ int Remove::execute(const QStringList& arguments)
                                QObject::tr("path"));
     parser.addOption(keyFile);
     parser.addPositionalArgument("entry", QCoreApplication::translate("main", "Path of the entry to remove."));
-    parser.process(arguments);
+    if (!parseArguments(parser, arguments)) {
+        return EXIT_FAILURE;
+    }
 
     const QStringList args = parser.positionalArguments();
     if (args.size() != 2) {
@@ -63,7 +65,7 @@ int Remove::execute(const QStringList& arguments)
         return EXIT_FAILURE;
     }
 
-    Database* db = Database::unlockFromStdin(args.at(0), parser.value(keyFile));
+    Database* db = Utils::unlockDatabase(args.at(0), parser.value(keyFile));
     if (db == nullptr) {
         return EXIT_FAILURE;
     }
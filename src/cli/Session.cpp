@@ -0,0 +1,487 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <stdio.h>
+
+#include "Session.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QtEndian>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "cli/Command.h"
+#include "cli/Utils.h"
+#include "core/Database.h"
+
+const char* const Session::SocketVariable = "KEEPASSXC_CLI_SOCKET";
+const char* const Session::PidVariable = "KEEPASSXC_CLI_PID";
+
+namespace
+{
+    // commands that take a database as their first argument and can run inside a session
+    const QSet<QString> SessionCommands = {"add", "clip", "edit", "locate", "ls", "rm", "show", "stats"};
+
+    const int StandardStreams = 3;
+    const quint32 MaxRequestSize = 64 * 1024;
+
+    Database* sessionDatabase = nullptr;
+    QString sessionDatabasePath;
+    QDateTime sessionLastModified;
+    qint64 sessionFileSize = 0;
+
+#ifdef Q_OS_UNIX
+    volatile sig_atomic_t terminated = 0;
+
+    void handleTermination(int signal)
+    {
+        Q_UNUSED(signal);
+        terminated = 1;
+    }
+
+    bool readFully(int fd, char* data, size_t size)
+    {
+        while (size > 0) {
+            ssize_t count = read(fd, data, size);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            data += count;
+            size -= static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    bool writeFully(int fd, const char* data, size_t size)
+    {
+        while (size > 0) {
+            ssize_t count = write(fd, data, size);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            data += count;
+            size -= static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    bool socketAddress(const QString& socketPath, sockaddr_un& address)
+    {
+        const QByteArray path = QFile::encodeName(socketPath);
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.isEmpty() || static_cast<size_t>(path.size()) >= sizeof(address.sun_path)) {
+            return false;
+        }
+        memcpy(address.sun_path, path.constData(), static_cast<size_t>(path.size()));
+        return true;
+    }
+
+    /*
+     * A request is the size of the serialized working directory and arguments,
+     * sent together with the standard streams of the client, followed by them.
+     */
+    bool receiveRequest(int fd, QString& workingDirectory, QStringList& arguments, int streams[StandardStreams])
+    {
+        quint32 size = 0;
+        iovec iov;
+        iov.iov_base = &size;
+        iov.iov_len = sizeof(size);
+
+        union
+        {
+            cmsghdr header;
+            char buffer[CMSG_SPACE(sizeof(int) * StandardStreams)];
+        } control;
+
+        msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+
+        ssize_t received;
+        do {
+            received = recvmsg(fd, &message, 0);
+        } while (received < 0 && errno == EINTR);
+
+        int receivedStreams = 0;
+        if (received > 0) {
+            for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+                if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+                    continue;
+                }
+                const int* fds = reinterpret_cast<const int*>(CMSG_DATA(header));
+                const size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (size_t i = 0; i < count; ++i) {
+                    if (receivedStreams < StandardStreams) {
+                        streams[receivedStreams++] = fds[i];
+                    } else {
+                        close(fds[i]);
+                    }
+                }
+            }
+        }
+
+        bool valid = received > 0 && receivedStreams == StandardStreams && !(message.msg_flags & MSG_CTRUNC);
+        if (valid && static_cast<size_t>(received) < sizeof(size)) {
+            valid = readFully(fd, reinterpret_cast<char*>(&size) + received, sizeof(size) - received);
+        }
+
+        size = qFromBigEndian(size);
+        if (valid && size <= MaxRequestSize) {
+            QByteArray payload(static_cast<int>(size), '\0');
+            if (readFully(fd, payload.data(), size)) {
+                QDataStream stream(payload);
+                stream >> workingDirectory >> arguments;
+                if (stream.status() == QDataStream::Ok) {
+                    return true;
+                }
+            }
+        }
+
+        for (int i = 0; i < receivedStreams; ++i) {
+            close(streams[i]);
+        }
+        return false;
+    }
+
+    void updateFileStamp()
+    {
+        const QFileInfo fileInfo(sessionDatabasePath);
+        sessionLastModified = fileInfo.lastModified();
+        sessionFileSize = fileInfo.size();
+    }
+
+    /*
+     * Replace the session database with the content of its file.
+     * Returns false if the session can't continue.
+     */
+    bool reloadDatabase()
+    {
+        Database* db = Database::openDatabaseFile(sessionDatabasePath, sessionDatabase->key());
+        if (!db) {
+            qCritical("The database could not be reloaded, closing the session.");
+            return false;
+        }
+
+        delete sessionDatabase;
+        sessionDatabase = db;
+        Utils::setSessionDatabase(sessionDatabase, sessionDatabasePath);
+        updateFileStamp();
+        return true;
+    }
+
+    /*
+     * Reload the database when it was changed by someone else, so commands
+     * saving it don't overwrite those changes. Returns false if the session
+     * can't continue.
+     */
+    bool reloadIfChanged()
+    {
+        const QFileInfo fileInfo(sessionDatabasePath);
+        if (fileInfo.lastModified() == sessionLastModified && fileInfo.size() == sessionFileSize) {
+            return true;
+        }
+        return reloadDatabase();
+    }
+
+    // only the user owning the session may run commands in it
+    bool isSameUser(int fd)
+    {
+#if defined(Q_OS_LINUX)
+        ucred credentials;
+        socklen_t length = sizeof(credentials);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0) {
+            return false;
+        }
+        const uid_t peerUid = credentials.uid;
+#else
+        uid_t peerUid;
+        gid_t peerGid;
+        if (getpeereid(fd, &peerUid, &peerGid) != 0) {
+            return false;
+        }
+#endif
+        return peerUid == getuid();
+    }
+
+    /*
+     * Run the requested command with the standard streams of the client.
+     * Returns false if the session has to be closed.
+     */
+    bool handleRequest(int fd)
+    {
+        QString workingDirectory;
+        QStringList arguments;
+        int streams[StandardStreams];
+        if (!receiveRequest(fd, workingDirectory, arguments, streams)) {
+            return true;
+        }
+
+        // relative paths are relative to the client
+        const QString sessionDirectory = QDir::currentPath();
+        QDir::setCurrent(workingDirectory);
+
+        int savedStreams[StandardStreams];
+        fflush(stdout);
+        fflush(stderr);
+        for (int i = 0; i < StandardStreams; ++i) {
+            savedStreams[i] = dup(i);
+            dup2(streams[i], i);
+            close(streams[i]);
+        }
+        Utils::resetStdinTextStream();
+
+        int exitCode = EXIT_FAILURE;
+        bool sessionValid = reloadIfChanged();
+        if (sessionValid) {
+            const quint64 generation = sessionDatabase->generation();
+            Command* command = arguments.isEmpty() ? nullptr : Command::getCommand(arguments.first());
+            if (command && SessionCommands.contains(arguments.first())) {
+                exitCode = command->execute(arguments);
+            } else {
+                qCritical("Invalid command for a session.");
+            }
+
+            if (exitCode != EXIT_SUCCESS && sessionDatabase->generation() != generation) {
+                // the change could not be saved, later commands must not see or save it
+                sessionValid = reloadDatabase();
+            }
+        }
+
+        fflush(stdout);
+        fflush(stderr);
+        for (int i = 0; i < StandardStreams; ++i) {
+            dup2(savedStreams[i], i);
+            close(savedStreams[i]);
+        }
+        Utils::resetStdinTextStream();
+        QDir::setCurrent(sessionDirectory);
+
+        Utils::releaseRequestDatabases();
+        if (sessionValid) {
+            updateFileStamp();
+        }
+
+        const qint32 result = qToBigEndian(static_cast<qint32>(exitCode));
+        writeFully(fd, reinterpret_cast<const char*>(&result), sizeof(result));
+
+        return sessionValid;
+    }
+#endif
+} // namespace
+
+/**
+ * Run a command inside the session the environment points to, if any.
+ *
+ * @return false if the command has to run in this process instead
+ */
+bool Session::forwardCommand(const QStringList& arguments, int& exitCode)
+{
+#ifdef Q_OS_UNIX
+    const QString socketPath = QString::fromLocal8Bit(qgetenv(SocketVariable));
+    if (socketPath.isEmpty() || arguments.isEmpty() || !SessionCommands.contains(arguments.first())) {
+        return false;
+    }
+
+    sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || !socketAddress(socketPath, address)
+        || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        qWarning("Unable to connect to the session at %s, unlocking the database directly.", qPrintable(socketPath));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+
+    QByteArray request;
+    QDataStream stream(&request, QIODevice::WriteOnly);
+    stream << QDir::currentPath() << arguments;
+
+    quint32 size = qToBigEndian(static_cast<quint32>(request.size()));
+    iovec iov;
+    iov.iov_base = &size;
+    iov.iov_len = sizeof(size);
+
+    union
+    {
+        cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(int) * StandardStreams)];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    const int streams[StandardStreams] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(streams));
+    memcpy(CMSG_DATA(header), streams, sizeof(streams));
+
+    qint32 result;
+    if (sendmsg(fd, &message, 0) != static_cast<ssize_t>(sizeof(size))
+        || !writeFully(fd, request.constData(), static_cast<size_t>(request.size()))
+        || !readFully(fd, reinterpret_cast<char*>(&result), sizeof(result))) {
+        qCritical("The session at %s closed the connection.", qPrintable(socketPath));
+        exitCode = EXIT_FAILURE;
+    } else {
+        exitCode = qFromBigEndian(result);
+    }
+
+    close(fd);
+    return true;
+#else
+    Q_UNUSED(arguments);
+    Q_UNUSED(exitCode);
+    return false;
+#endif
+}
+
+/**
+ * Create the listening socket of a session, accessible by the current user only.
+ *
+ * @return socket descriptor or -1 on error
+ */
+int Session::listen(const QString& socketPath)
+{
+#ifdef Q_OS_UNIX
+    sockaddr_un address;
+    if (!socketAddress(socketPath, address)) {
+        qCritical("Invalid socket path %s.", qPrintable(socketPath));
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        qCritical("Unable to create socket: %s", strerror(errno));
+        return -1;
+    }
+
+    mode_t oldUmask = umask(S_IRWXG | S_IRWXO);
+    bool bound = ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    umask(oldUmask);
+
+    if (!bound || ::listen(fd, 16) != 0) {
+        qCritical("Unable to listen on %s: %s", qPrintable(socketPath), strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+#else
+    Q_UNUSED(socketPath);
+    qCritical("Sessions are only supported on Unix.");
+    return -1;
+#endif
+}
+
+/**
+ * Serve commands for an unlocked database until no command was received
+ * for idleTimeout seconds (0 to never time out).
+ */
+int Session::serve(int socket, Database* database, const QString& databaseFilename, int idleTimeout)
+{
+#ifdef Q_OS_UNIX
+    // clients may go away at any time
+    signal(SIGPIPE, SIG_IGN);
+    // close the session cleanly when it is killed
+    signal(SIGTERM, handleTermination);
+    signal(SIGHUP, handleTermination);
+    signal(SIGINT, handleTermination);
+
+    sessionDatabase = database;
+    sessionDatabasePath = QFileInfo(databaseFilename).canonicalFilePath();
+    Utils::setSessionDatabase(sessionDatabase, sessionDatabasePath);
+    updateFileStamp();
+
+    while (!terminated) {
+        pollfd pollFd;
+        pollFd.fd = socket;
+        pollFd.events = POLLIN;
+        pollFd.revents = 0;
+
+        int ready = poll(&pollFd, 1, idleTimeout > 0 ? idleTimeout * 1000 : -1);
+        if (terminated) {
+            break;
+        }
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            break;
+        }
+
+        int client = accept(socket, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        if (!isSameUser(client)) {
+            close(client);
+            continue;
+        }
+
+        bool keepRunning = handleRequest(client);
+        close(client);
+        if (!keepRunning) {
+            break;
+        }
+    }
+
+    close(socket);
+    Utils::setSessionDatabase(nullptr, QString());
+    delete sessionDatabase;
+    sessionDatabase = nullptr;
+
+    return EXIT_SUCCESS;
+#else
+    Q_UNUSED(socket);
+    Q_UNUSED(database);
+    Q_UNUSED(databaseFilename);
+    Q_UNUSED(idleTimeout);
+    return EXIT_FAILURE;
+#endif
+}
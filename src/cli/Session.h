@@ -0,0 +1,46 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_SESSION_H
+#define KEEPASSXC_SESSION_H
+
+#include <QString>
+#include <QStringList>
+
+class Database;
+
+/**
+ * A session keeps one unlocked database in a background process, which is
+ * started by the open command and listens on a user-only Unix socket.
+ *
+ * When the environment variable named by SocketVariable points to such a
+ * socket, commands are forwarded to the session together with the standard
+ * streams of the client, so they run against the unlocked database without
+ * asking for the password again.
+ */
+class Session
+{
+public:
+    static const char* const SocketVariable;
+    static const char* const PidVariable;
+
+    static bool forwardCommand(const QStringList& arguments, int& exitCode);
+    static int listen(const QString& socketPath);
+    static int serve(int socket, Database* database, const QString& databaseFilename, int idleTimeout);
+};
+
+#endif // KEEPASSXC_SESSION_H
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <stdio.h>
+
+#include "Stats.h"
+
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QTextStream>
+
+#include "cli/Utils.h"
+#include "core/Database.h"
+#include "core/DatabaseMemoryStats.h"
+
+Stats::Stats()
+{
+    name = QString("stats");
+    description = QObject::tr("Show the memory used by a database as JSON.");
+}
+
+Stats::~Stats()
+{
+}
+
+int Stats::execute(const QStringList& arguments)
+{
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(this->description);
+    parser.addPositionalArgument("database", QObject::tr("Path of the database."));
+    QCommandLineOption keyFile(QStringList() << "k"
+                                             << "key-file",
+                               QObject::tr("Key file of the database."),
+                               QObject::tr("path"));
+    parser.addOption(keyFile);
+    QCommandLineOption largest(QStringList() << "n"
+                                             << "largest",
+                               QObject::tr("Number of largest entries to list. Default: 10."),
+                               QObject::tr("count"));
+    parser.addOption(largest);
+    if (!parseArguments(parser, arguments)) {
+        return EXIT_FAILURE;
+    }
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 1) {
+        out << parser.helpText().replace("keepassxc-cli", "keepassxc-cli stats");
+        return EXIT_FAILURE;
+    }
+
+    int largestEntryCount = 10;
+    if (parser.isSet(largest)) {
+        bool ok;
+        largestEntryCount = parser.value(largest).toInt(&ok);
+        if (!ok || largestEntryCount < 0) {
+            qCritical("Invalid number of entries %s.", qPrintable(parser.value(largest)));
+            return EXIT_FAILURE;
+        }
+    }
+
+    Database* db = Utils::unlockDatabase(args.at(0), parser.value(keyFile));
+    if (db == nullptr) {
+        return EXIT_FAILURE;
+    }
+
+    out << QJsonDocument(db->memoryStats(largestEntryCount).toJson()).toJson(QJsonDocument::Indented);
+    out.flush();
+    return EXIT_SUCCESS;
+}
@@ -17,16 +17,35 @@
 
 #include "Utils.h"
 
+#include <stdio.h>
+
 #ifdef Q_OS_WIN
 #include <windows.h>
 #else
 #include <termios.h>
 #include <unistd.h>
+#if defined(Q_OS_LINUX)
+#include <stdio_ext.h>
+#endif
 #endif
 
+#include <QFileInfo>
 #include <QProcess>
+#include <QScopedPointer>
 #include <QTextStream>
 
+#include "core/Database.h"
+
+namespace
+{
+    QScopedPointer<QTextStream> inputTextStream;
+
+    // set while a session serves a request, see Session::serve()
+    Database* sessionDatabase = nullptr;
+    QString sessionDatabasePath;
+    QList<Database*> requestDatabases;
+}
+
 void Utils::setStdinEcho(bool enable = true)
 {
 #ifdef Q_OS_WIN
@@ -56,13 +75,78 @@ void Utils::setStdinEcho(bool enable = true)
 #endif
 }
 
+/*
+ * The stream buffers what it reads from stdin, so everything reading
+ * lines after the password has to share it.
+ */
+QTextStream& Utils::stdinTextStream()
+{
+    if (!inputTextStream) {
+        inputTextStream.reset(new QTextStream(stdin, QIODevice::ReadOnly));
+    }
+    return *inputTextStream;
+}
+
+/*
+ * Drop everything buffered from stdin, both by the shared stream and by
+ * stdio itself. Needed when stdin is swapped to read from somewhere else.
+ */
+void Utils::resetStdinTextStream()
+{
+    inputTextStream.reset();
+#if defined(Q_OS_LINUX)
+    __fpurge(stdin);
+#elif defined(Q_OS_UNIX)
+    fpurge(stdin);
+#else
+    fflush(stdin);
+#endif
+    clearerr(stdin);
+}
+
+/*
+ * Used by the commands instead of Database::unlockFromStdin(). Inside a
+ * session, the session database is returned without asking for a password.
+ */
+Database* Utils::unlockDatabase(const QString& databaseFilename, const QString& keyFilename)
+{
+    if (sessionDatabase && QFileInfo(databaseFilename).canonicalFilePath() == sessionDatabasePath) {
+        return sessionDatabase;
+    }
+
+    Database* db = Database::unlockFromStdin(databaseFilename, keyFilename);
+    if (db && sessionDatabase) {
+        // a different database, only kept for the current request
+        requestDatabases.append(db);
+    }
+    return db;
+}
+
+/*
+ * The database a session keeps unlocked, at its canonical file path.
+ * It is owned by the session.
+ */
+void Utils::setSessionDatabase(Database* database, const QString& canonicalFilePath)
+{
+    sessionDatabase = database;
+    sessionDatabasePath = canonicalFilePath;
+}
+
+/*
+ * Delete the other databases unlocked while a session served a request.
+ */
+void Utils::releaseRequestDatabases()
+{
+    qDeleteAll(requestDatabases);
+    requestDatabases.clear();
+}
+
 QString Utils::getPassword()
 {
-    static QTextStream inputTextStream(stdin, QIODevice::ReadOnly);
     static QTextStream outputTextStream(stdout, QIODevice::WriteOnly);
 
     setStdinEcho(false);
-    QString line = inputTextStream.readLine();
+    QString line = stdinTextStream().readLine();
     setStdinEcho(true);
 
     // The new line was also not echoed, but we do want to echo it.
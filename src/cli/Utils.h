@@ -20,11 +20,19 @@
 
 #include <QtCore/qglobal.h>
 
+class Database;
+class QTextStream;
+
 class Utils
 {
 public:
     static void setStdinEcho(bool enable);
+    static QTextStream& stdinTextStream();
+    static void resetStdinTextStream();
     static QString getPassword();
+    static Database* unlockDatabase(const QString& databaseFilename, const QString& keyFilename);
+    static void setSessionDatabase(Database* database, const QString& canonicalFilePath);
+    static void releaseRequestDatabases();
     static int clipText(const QString& text);
 };
 
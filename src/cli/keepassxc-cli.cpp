@@ -23,9 +23,11 @@
 #include <QTextStream>
 
 #include <cli/Command.h>
+#include <cli/Session.h>
 
 #include "config-keepassx.h"
 #include "core/Tools.h"
+#include "core/Trace.h"
 #include "crypto/Crypto.h"
 
 #if defined(WITH_ASAN) && defined(WITH_LSAN)
@@ -45,6 +47,7 @@ int main(int argc, char** argv)
 
     QCoreApplication app(argc, argv);
     app.setApplicationVersion(KEEPASSX_VERSION);
+    Trace::startFromEnvironment();
 
     QTextStream out(stdout);
     QStringList arguments;
@@ -90,7 +93,11 @@ int main(int argc, char** argv)
 
     // Removing the first argument (keepassxc).
     arguments.removeFirst();
-    int exitCode = command->execute(arguments);
+    int exitCode;
+    if (!Session::forwardCommand(arguments, exitCode)) {
+        exitCode = command->execute(arguments);
+    }
+    Trace::finish();
 
 #if defined(WITH_ASAN) && defined(WITH_LSAN)
     // do leak check here to prevent massive tail of end-of-process leak errors from third-party libraries
@@ -0,0 +1,536 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The vector kernels follow the SSSE3/AVX2 encoder and decoder described by
+ * Wojciech Muła and Daniel Lemire, "Faster Base64 Encoding and Decoding using
+ * AVX2 Instructions", and the usual vld3/vld4 table lookup on AArch64. They
+ * only handle whole blocks of alphabet characters, everything else (padding,
+ * whitespace, short tails) goes through the scalar code.
+ */
+
+#include "Base64.h"
+
+#include <string.h>
+
+#if defined(Q_PROCESSOR_X86) && defined(Q_CC_GNU)
+#define BASE64_X86_KERNELS
+#define BASE64_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define BASE64_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(Q_PROCESSOR_ARM_64) && defined(__ARM_NEON)
+#define BASE64_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    const char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const uchar Invalid = 0xff;
+
+    const uchar* decodeTable()
+    {
+        static const struct Table
+        {
+            Table()
+            {
+                memset(values, Invalid, sizeof(values));
+                for (int i = 0; i < 64; ++i) {
+                    values[static_cast<uchar>(Alphabet[i])] = static_cast<uchar>(i);
+                }
+            }
+            uchar values[256];
+        } table;
+        return table.values;
+    }
+
+    inline uint lookup(const uchar* table, char c)
+    {
+        return table[static_cast<uchar>(c)];
+    }
+
+    inline uint lookup(const uchar* table, ushort c)
+    {
+        return c < 256 ? table[c] : Invalid;
+    }
+
+    template <typename Char> void encodeScalar(const uchar* src, int size, Char* dst)
+    {
+        int i = 0;
+        for (; i + 3 <= size; i += 3) {
+            const quint32 value = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+            *dst++ = Alphabet[value >> 18];
+            *dst++ = Alphabet[(value >> 12) & 63];
+            *dst++ = Alphabet[(value >> 6) & 63];
+            *dst++ = Alphabet[value & 63];
+        }
+
+        const int rest = size - i;
+        if (rest > 0) {
+            const quint32 value = (src[i] << 16) | (rest == 2 ? src[i + 1] << 8 : 0);
+            *dst++ = Alphabet[value >> 18];
+            *dst++ = Alphabet[(value >> 12) & 63];
+            *dst++ = rest == 2 ? Alphabet[(value >> 6) & 63] : '=';
+            *dst++ = '=';
+        }
+    }
+
+    /**
+     * Decodes like QByteArray::fromBase64(), characters outside the alphabet
+     * are skipped wherever they appear.
+     *
+     * @return end of the decoded data
+     */
+    template <typename Char> char* decodeScalar(const Char* src, int size, char* dst)
+    {
+        const uchar* table = decodeTable();
+
+        int i = 0;
+        for (; i + 4 <= size; i += 4) {
+            const uint a = lookup(table, src[i]);
+            const uint b = lookup(table, src[i + 1]);
+            const uint c = lookup(table, src[i + 2]);
+            const uint d = lookup(table, src[i + 3]);
+            if ((a | b | c | d) & 0x80) {
+                break;
+            }
+            const quint32 value = (a << 18) | (b << 12) | (c << 6) | d;
+            *dst++ = static_cast<char>(value >> 16);
+            *dst++ = static_cast<char>(value >> 8);
+            *dst++ = static_cast<char>(value);
+        }
+
+        quint32 buffer = 0;
+        int bits = 0;
+        for (; i < size; ++i) {
+            const uint value = lookup(table, src[i]);
+            if (value == Invalid) {
+                continue;
+            }
+            buffer = (buffer << 6) | value;
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                *dst++ = static_cast<char>(buffer >> bits);
+                buffer &= (1u << bits) - 1;
+            }
+        }
+
+        return dst;
+    }
+
+#if defined(BASE64_X86_KERNELS)
+    bool hasSsse3()
+    {
+        static const bool supported = __builtin_cpu_supports("ssse3");
+        return supported;
+    }
+
+    bool hasAvx2()
+    {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    BASE64_TARGET_SSSE3 inline __m128i loadChars(const char* src)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    }
+
+    // UTF-16 units above 0xff saturate to bytes outside the alphabet
+    BASE64_TARGET_SSSE3 inline __m128i loadChars(const ushort* src)
+    {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8));
+        return _mm_packus_epi16(lo, hi);
+    }
+
+    BASE64_TARGET_SSSE3 inline void storeChars(char* dst, __m128i chars)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), chars);
+    }
+
+    BASE64_TARGET_SSSE3 inline void storeChars(ushort* dst, __m128i chars)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi8(chars, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm_unpackhi_epi8(chars, zero));
+    }
+
+    BASE64_TARGET_AVX2 inline __m256i loadChars32(const char* src)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    }
+
+    BASE64_TARGET_AVX2 inline __m256i loadChars32(const ushort* src)
+    {
+        const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 16));
+        return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+    }
+
+    BASE64_TARGET_AVX2 inline void storeChars32(char* dst, __m256i chars)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), chars);
+    }
+
+    BASE64_TARGET_AVX2 inline void storeChars32(ushort* dst, __m256i chars)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(chars)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 16),
+                            _mm256_cvtepu8_epi16(_mm256_extracti128_si256(chars, 1)));
+    }
+
+    /**
+     * Encodes 12 bytes, spread over four 32-bit lanes, into 16 characters.
+     */
+    BASE64_TARGET_SSSE3 inline __m128i encodeBlock(__m128i in)
+    {
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t1, t3);
+
+        // 0 for a-z, 1-10 for digits, 11 and 12 for + and /, 13 for A-Z
+        __m128i offsets = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        offsets = _mm_or_si128(offsets, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        const __m128i shift = _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        return _mm_add_epi8(_mm_shuffle_epi8(shift, offsets), indices);
+    }
+
+    BASE64_TARGET_AVX2 inline __m256i encodeBlock32(__m256i in)
+    {
+        const __m256i order = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                              10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        in = _mm256_shuffle_epi8(in, order);
+        const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i offsets = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        offsets = _mm256_or_si256(offsets, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+        const __m256i shift = _mm256_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        return _mm256_add_epi8(_mm256_shuffle_epi8(shift, offsets), indices);
+    }
+
+    /**
+     * Translates 16 characters to their 6-bit values and packs them into
+     * the low 12 bytes of out.
+     *
+     * @return false if a character is outside the alphabet
+     */
+    BASE64_TARGET_SSSE3 inline bool decodeBlock(__m128i in, __m128i& out)
+    {
+        const __m128i lutLo = _mm_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m128i lutHi = _mm_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i mask2f = _mm_set1_epi8(0x2f);
+
+        const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2f);
+        const __m128i loNibbles = _mm_and_si128(in, mask2f);
+        const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff) {
+            return false;
+        }
+
+        const __m128i eq2f = _mm_cmpeq_epi8(in, mask2f);
+        const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2f, hiNibbles));
+        const __m128i values = _mm_add_epi8(in, roll);
+
+        const __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        const __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        out = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        return true;
+    }
+
+    BASE64_TARGET_AVX2 inline bool decodeBlock32(__m256i in, __m256i& out)
+    {
+        const __m256i lutLo = _mm256_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m256i lutHi = _mm256_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i mask2f = _mm256_set1_epi8(0x2f);
+
+        const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask2f);
+        const __m256i loNibbles = _mm256_and_si256(in, mask2f);
+        const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        const __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+        if (!_mm256_testz_si256(lo, hi)) {
+            return false;
+        }
+
+        const __m256i eq2f = _mm256_cmpeq_epi8(in, mask2f);
+        const __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2f, hiNibbles));
+        const __m256i values = _mm256_add_epi8(in, roll);
+
+        const __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        packed = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        out = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        return true;
+    }
+
+    /**
+     * @return number of bytes consumed, a multiple of 3
+     */
+    template <typename Char> BASE64_TARGET_SSSE3 int encodeSsse3(const uchar* src, int size, Char* dst)
+    {
+        int i = 0;
+        for (; i + 16 <= size; i += 12, dst += 16) {
+            storeChars(dst, encodeBlock(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+        }
+        return i;
+    }
+
+    template <typename Char> BASE64_TARGET_AVX2 int encodeAvx2(const uchar* src, int size, Char* dst)
+    {
+        int i = 0;
+        for (; i + 28 <= size; i += 24, dst += 32) {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12));
+            storeChars32(dst, encodeBlock32(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1)));
+        }
+        return i;
+    }
+
+    /**
+     * Stores 16 bytes per 12 decoded ones, so dst needs 4 bytes of slack.
+     *
+     * @return number of characters consumed, a multiple of 4
+     */
+    template <typename Char> BASE64_TARGET_SSSE3 int decodeSsse3(const Char* src, int size, char* dst)
+    {
+        int i = 0;
+        __m128i out;
+        for (; i + 16 <= size && decodeBlock(loadChars(src + i), out); i += 16, dst += 12) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out);
+        }
+        return i;
+    }
+
+    // Stores 32 bytes per 24 decoded ones, so dst needs 8 bytes of slack.
+    template <typename Char> BASE64_TARGET_AVX2 int decodeAvx2(const Char* src, int size, char* dst)
+    {
+        int i = 0;
+        __m256i out;
+        for (; i + 32 <= size && decodeBlock32(loadChars32(src + i), out); i += 32, dst += 24) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), out);
+        }
+        return i;
+    }
+#elif defined(BASE64_NEON_KERNELS)
+    inline uint8x16x4_t loadChars(const char* src)
+    {
+        return vld4q_u8(reinterpret_cast<const uint8_t*>(src));
+    }
+
+    // UTF-16 units above 0xff saturate to bytes outside the alphabet
+    inline uint8x16x4_t loadChars(const ushort* src)
+    {
+        const uint16x8x4_t lo = vld4q_u16(src);
+        const uint16x8x4_t hi = vld4q_u16(src + 32);
+        uint8x16x4_t chars;
+        for (int i = 0; i < 4; ++i) {
+            chars.val[i] = vcombine_u8(vqmovn_u16(lo.val[i]), vqmovn_u16(hi.val[i]));
+        }
+        return chars;
+    }
+
+    inline void storeChars(char* dst, const uint8x16x4_t& chars)
+    {
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst), chars);
+    }
+
+    inline void storeChars(ushort* dst, const uint8x16x4_t& chars)
+    {
+        uint16x8x4_t lo;
+        uint16x8x4_t hi;
+        for (int i = 0; i < 4; ++i) {
+            lo.val[i] = vmovl_u8(vget_low_u8(chars.val[i]));
+            hi.val[i] = vmovl_high_u8(chars.val[i]);
+        }
+        vst4q_u16(dst, lo);
+        vst4q_u16(dst + 32, hi);
+    }
+
+    inline uint8x16x4_t loadTable(const uchar* table)
+    {
+        uint8x16x4_t result;
+        for (int i = 0; i < 4; ++i) {
+            result.val[i] = vld1q_u8(table + 16 * i);
+        }
+        return result;
+    }
+
+    template <typename Char> int encodeNeon(const uchar* src, int size, Char* dst)
+    {
+        const uint8x16x4_t alphabet = loadTable(reinterpret_cast<const uchar*>(Alphabet));
+        const uint8x16_t mask = vdupq_n_u8(63);
+
+        int i = 0;
+        for (; i + 48 <= size; i += 48, dst += 64) {
+            const uint8x16x3_t in = vld3q_u8(src + i);
+            uint8x16x4_t chars;
+            chars.val[0] = vshrq_n_u8(in.val[0], 2);
+            chars.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask);
+            chars.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask);
+            chars.val[3] = vandq_u8(in.val[2], mask);
+            for (int k = 0; k < 4; ++k) {
+                chars.val[k] = vqtbl4q_u8(alphabet, chars.val[k]);
+            }
+            storeChars(dst, chars);
+        }
+        return i;
+    }
+
+    template <typename Char> int decodeNeon(const Char* src, int size, char* dst)
+    {
+        const uchar* table = decodeTable();
+        const uint8x16x4_t lower = loadTable(table);
+        const uint8x16x4_t upper = loadTable(table + 64);
+
+        int i = 0;
+        for (; i + 64 <= size; i += 64, dst += 48) {
+            uint8x16x4_t values = loadChars(src + i);
+            uint8x16_t error = vdupq_n_u8(0);
+            for (int k = 0; k < 4; ++k) {
+                const uint8x16_t chars = values.val[k];
+                // indices past the 64-byte tables leave the value untouched
+                values.val[k] = vqtbx4q_u8(vqtbl4q_u8(lower, chars), upper, vsubq_u8(chars, vdupq_n_u8(64)));
+                error = vorrq_u8(error, vorrq_u8(values.val[k], vandq_u8(chars, vdupq_n_u8(0x80))));
+            }
+            if (vmaxvq_u8(error) > 63) {
+                break;
+            }
+
+            uint8x16x3_t out;
+            out.val[0] = vorrq_u8(vshlq_n_u8(values.val[0], 2), vshrq_n_u8(values.val[1], 4));
+            out.val[1] = vorrq_u8(vshlq_n_u8(values.val[1], 4), vshrq_n_u8(values.val[2], 2));
+            out.val[2] = vorrq_u8(vshlq_n_u8(values.val[2], 6), values.val[3]);
+            vst3q_u8(reinterpret_cast<uint8_t*>(dst), out);
+        }
+        return i;
+    }
+#endif
+
+    template <typename Char> void encodeInto(const uchar* src, int size, Char* dst)
+    {
+        int done = 0;
+#if defined(BASE64_X86_KERNELS)
+        if (hasAvx2()) {
+            done = encodeAvx2(src, size, dst);
+        }
+        if (hasSsse3()) {
+            done += encodeSsse3(src + done, size - done, dst + done / 3 * 4);
+        }
+#elif defined(BASE64_NEON_KERNELS)
+        done = encodeNeon(src, size, dst);
+#endif
+        encodeScalar(src + done, size - done, dst + done / 3 * 4);
+    }
+
+    // Decoded bytes never exceed this, including the slack of the vector stores
+    inline int decodedCapacity(int size)
+    {
+        return size / 4 * 3 + 3 + 8;
+    }
+
+    template <typename Char> char* decodeInto(const Char* src, int size, char* dst)
+    {
+        int done = 0;
+#if defined(BASE64_X86_KERNELS)
+        if (hasAvx2()) {
+            done = decodeAvx2(src, size, dst);
+        }
+        if (hasSsse3()) {
+            done += decodeSsse3(src + done, size - done, dst + done / 4 * 3);
+        }
+#elif defined(BASE64_NEON_KERNELS)
+        done = decodeNeon(src, size, dst);
+#endif
+        return decodeScalar(src + done, size - done, dst + done / 4 * 3);
+    }
+} // namespace
+
+QByteArray Base64::encode(const QByteArray& data)
+{
+    QByteArray encoded;
+    encoded.resize((data.size() + 2) / 3 * 4);
+    encodeInto(reinterpret_cast<const uchar*>(data.constData()), data.size(), encoded.data());
+    return encoded;
+}
+
+/**
+ * Encodes straight into the UTF-16 buffer of the returned string, without
+ * going through an intermediate QByteArray.
+ */
+QString Base64::encodeToString(const QByteArray& data)
+{
+    QString encoded((data.size() + 2) / 3 * 4, Qt::Uninitialized);
+    encodeInto(reinterpret_cast<const uchar*>(data.constData()),
+               data.size(),
+               reinterpret_cast<ushort*>(encoded.data()));
+    return encoded;
+}
+
+QByteArray Base64::decode(const QByteArray& encodedData)
+{
+    QByteArray decoded;
+    decoded.resize(decodedCapacity(encodedData.size()));
+    const char* end = decodeInto(encodedData.constData(), encodedData.size(), decoded.data());
+    decoded.truncate(static_cast<int>(end - decoded.constData()));
+    return decoded;
+}
+
+QByteArray Base64::decode(const QString& encodedData)
+{
+    return decode(QStringRef(&encodedData));
+}
+
+/**
+ * Decodes straight from the UTF-16 buffer, e.g. the one of a
+ * QXmlStreamReader, without converting it to Latin-1 first.
+ */
+QByteArray Base64::decode(const QStringRef& encodedData)
+{
+    QByteArray decoded;
+    decoded.resize(decodedCapacity(encodedData.size()));
+    const char* end = decodeInto(reinterpret_cast<const ushort*>(encodedData.unicode()),
+                                 encodedData.size(),
+                                 decoded.data());
+    decoded.truncate(static_cast<int>(end - decoded.constData()));
+    return decoded;
+}
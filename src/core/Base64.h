@@ -0,0 +1,42 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Conforms to RFC 4648 with the standard alphabet and padding. The results
+ * match QByteArray::toBase64() and QByteArray::fromBase64(): decoding skips
+ * every character outside the alphabet, including misplaced padding.
+ */
+
+#ifndef BASE64_H
+#define BASE64_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringRef>
+#include <QtCore/qglobal.h>
+
+class Base64
+{
+public:
+    Base64() = default;
+    Q_REQUIRED_RESULT static QByteArray encode(const QByteArray& data);
+    Q_REQUIRED_RESULT static QString encodeToString(const QByteArray& data);
+    Q_REQUIRED_RESULT static QByteArray decode(const QByteArray& encodedData);
+    Q_REQUIRED_RESULT static QByteArray decode(const QString& encodedData);
+    Q_REQUIRED_RESULT static QByteArray decode(const QStringRef& encodedData);
+};
+
+#endif // BASE64_H
@@ -20,6 +20,7 @@
 
 #include <QDebug>
 #include <QFile>
+#include <QMutexLocker>
 #include <QSaveFile>
 #include <QTemporaryFile>
 #include <QTextStream>
@@ -27,6 +28,8 @@
 #include <QXmlStreamReader>
 
 #include "cli/Utils.h"
+#include "core/DatabaseMemoryStats.h"
+#include "core/Global.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
 #include "crypto/kdf/AesKdf.h"
@@ -37,11 +40,19 @@
 #include "keys/PasswordKey.h"
 
 QHash<QUuid, Database*> Database::m_uuidMap;
+QMutex Database::m_uuidMapMutex;
+
+namespace
+{
+    const QString CompressionLevelKey = QStringLiteral("KPXC_COMPRESSION_LEVEL");
+}
 
 Database::Database()
     : m_metadata(new Metadata(this))
     , m_timer(new QTimer(this))
     , m_emitModified(false)
+    , m_generation(0)
+    , m_snapshot(false)
     , m_uuid(QUuid::createUuid())
 {
     m_data.cipher = KeePass2::CIPHER_AES;
@@ -57,16 +68,21 @@ Database::Database()
     rootGroup()->setUuid(QUuid::createUuid());
     m_timer->setSingleShot(true);
 
-    m_uuidMap.insert(m_uuid, this);
+    {
+        QMutexLocker locker(&m_uuidMapMutex);
+        m_uuidMap.insert(m_uuid, this);
+    }
 
     connect(m_metadata, SIGNAL(modified()), this, SIGNAL(modifiedImmediate()));
     connect(m_metadata, SIGNAL(nameTextChanged()), this, SIGNAL(nameTextChanged()));
+    connect(this, SIGNAL(modifiedImmediate()), this, SLOT(incrementGeneration()));
     connect(this, SIGNAL(modifiedImmediate()), this, SLOT(startModifiedTimer()));
     connect(m_timer, SIGNAL(timeout()), SIGNAL(modified()));
 }
 
 Database::~Database()
 {
+    QMutexLocker locker(&m_uuidMapMutex);
     m_uuidMap.remove(m_uuid);
 }
 
@@ -201,7 +217,7 @@ Group* Database::findGroupRecursive(const QUuid& uuid, Group* group)
     return nullptr;
 }
 
-QList<DeletedObject> Database::deletedObjects()
+QList<DeletedObject> Database::deletedObjects() const
 {
     return m_deletedObjects;
 }
@@ -231,6 +247,20 @@ Database::CompressionAlgorithm Database::compressionAlgo() const
     return m_data.compressionAlgo;
 }
 
+/**
+ * The deflate level used when saving, from 1 (fastest) to 9 (smallest).
+ * It is not part of the KDBX format and kept in the metadata custom data.
+ */
+int Database::compressionLevel() const
+{
+    bool ok;
+    const int level = m_metadata->customData()->value(CompressionLevelKey).toInt(&ok);
+    if (!ok || level < 1 || level > 9) {
+        return DefaultCompressionLevel;
+    }
+    return level;
+}
+
 QByteArray Database::transformedMasterKey() const
 {
     return m_data.transformedMasterKey;
@@ -261,6 +291,17 @@ void Database::setCompressionAlgo(Database::CompressionAlgorithm algo)
     m_data.compressionAlgo = algo;
 }
 
+void Database::setCompressionLevel(int level)
+{
+    Q_ASSERT(level >= 1 && level <= 9);
+
+    if (level == DefaultCompressionLevel) {
+        m_metadata->customData()->remove(CompressionLevelKey);
+    } else {
+        m_metadata->customData()->set(CompressionLevelKey, QString::number(level));
+    }
+}
+
 /**
  * Set and transform a new encryption key.
  *
@@ -399,6 +440,181 @@ void Database::merge(const Database* other)
     emit modified();
 }
 
+namespace
+{
+    struct TreeUpdate
+    {
+        QHash<QUuid, Group*> groups;
+        QHash<QUuid, Entry*> entries;
+        QSet<Group*> keptGroups;
+        QSet<Entry*> keptEntries;
+    };
+
+    bool groupDiffers(const Group* group, const Group* other)
+    {
+        return group->timeInfo().lastModificationTime() != other->timeInfo().lastModificationTime()
+               || group->timeInfo().locationChanged() != other->timeInfo().locationChanged()
+               || group->name() != other->name() || group->notes() != other->notes()
+               || group->isExpanded() != other->isExpanded();
+    }
+
+    bool entryDiffers(const Entry* entry, const Entry* other)
+    {
+        return entry->timeInfo().lastModificationTime() != other->timeInfo().lastModificationTime()
+               || entry->timeInfo().locationChanged() != other->timeInfo().locationChanged()
+               || *entry->attributes() != *other->attributes() || *entry->attachments() != *other->attachments()
+               || entry->historyItems().size() != other->historyItems().size();
+    }
+
+    void updateEntry(Entry* entry, const Entry* other)
+    {
+        entry->copyDataFrom(other);
+        entry->setUpdateTimeinfo(false);
+
+        entry->removeHistoryItems(entry->historyItems());
+        for (const Entry* historyItem : other->historyItems()) {
+            Entry* historyItemCopy = historyItem->clone(Entry::CloneNoFlags);
+            historyItemCopy->setUpdateTimeinfo(false);
+            entry->addHistoryItem(historyItemCopy);
+        }
+
+        emit entry->dataChanged(entry);
+    }
+
+    void updateGroupTree(Group* group, const Group* other, TreeUpdate& update)
+    {
+        update.keptGroups.insert(group);
+        if (groupDiffers(group, other)) {
+            group->copyDataFrom(other);
+            emit group->dataChanged(group);
+        }
+
+        // The ancestors of group are all kept already, so moving a child here can't create a cycle.
+        // Children that are gone from other stay behind the updated ones until they are deleted.
+        int index = 0;
+        for (const Group* otherChild : other->children()) {
+            Group* child = update.groups.value(otherChild->uuid());
+            if (!child || update.keptGroups.contains(child)) {
+                child = otherChild->clone(Entry::CloneNoFlags, Group::CloneNoFlags);
+                child->setUpdateTimeinfo(false);
+                child->setParent(group, index);
+            } else if (child->parentGroup() != group || child->row() != index) {
+                child->setParent(group, index);
+            }
+            updateGroupTree(child, otherChild, update);
+            ++index;
+        }
+
+        for (const Entry* otherEntry : other->entries()) {
+            Entry* entry = update.entries.value(otherEntry->uuid());
+            if (!entry || update.keptEntries.contains(entry)) {
+                entry = otherEntry->clone(Entry::CloneIncludeHistory);
+                entry->setUpdateTimeinfo(false);
+                entry->setGroup(group);
+            } else {
+                if (entry->group() != group) {
+                    entry->setGroup(group);
+                }
+                if (entryDiffers(entry, otherEntry)) {
+                    updateEntry(entry, otherEntry);
+                }
+            }
+            update.keptEntries.insert(entry);
+        }
+    }
+
+    /**
+     * Point the top visible entries at the entries of this database. They can be
+     * any entry of the tree, so this only works once the whole tree is updated.
+     */
+    void updateLastTopVisibleEntries(Group* rootGroup, const Group* otherRootGroup)
+    {
+        QHash<QUuid, const Group*> otherGroups;
+        for (const Group* otherGroup : otherRootGroup->groupsRecursive(true)) {
+            otherGroups.insert(otherGroup->uuid(), otherGroup);
+        }
+        QHash<QUuid, Entry*> entries;
+        for (Entry* entry : rootGroup->entriesRecursive(false)) {
+            entries.insert(entry->uuid(), entry);
+        }
+
+        for (Group* group : rootGroup->groupsRecursive(true)) {
+            const Group* otherGroup = otherGroups.value(group->uuid());
+            const Entry* otherEntry = otherGroup ? otherGroup->lastTopVisibleEntry() : nullptr;
+            group->setLastTopVisibleEntry(otherEntry ? entries.value(otherEntry->uuid()) : nullptr);
+        }
+    }
+} // namespace
+
+/**
+ * Make this database equal to other, which usually was just read from the
+ * same file again. Groups and entries are matched by uuid, and only those
+ * that differ are changed, added, moved or deleted. Views on this database
+ * thus get fine-grained updates instead of having to be rebuilt.
+ */
+void Database::updateFrom(const Database* other)
+{
+    TreeUpdate update;
+    const QList<Group*> groups = m_rootGroup->groupsRecursive(true);
+    for (Group* group : groups) {
+        group->setUpdateTimeinfo(false);
+        update.groups.insert(group->uuid(), group);
+    }
+    const QList<Entry*> entries = m_rootGroup->entriesRecursive(true);
+    for (Entry* entry : entries) {
+        entry->setUpdateTimeinfo(false);
+        if (!entry->parent()) {
+            // history item
+            continue;
+        }
+        update.entries.insert(entry->uuid(), entry);
+    }
+
+    if (m_rootGroup->uuid() != other->rootGroup()->uuid()) {
+        update.groups.remove(m_rootGroup->uuid());
+        m_rootGroup->setUuid(other->rootGroup()->uuid());
+    }
+    updateGroupTree(m_rootGroup, other->rootGroup(), update);
+
+    // Everything that was kept has been moved out of the deleted groups,
+    // so deleting the topmost ones takes care of their contents
+    QList<Entry*> deletedEntries;
+    for (Entry* entry : asConst(update.entries)) {
+        if (!update.keptEntries.contains(entry) && update.keptGroups.contains(entry->group())) {
+            deletedEntries.append(entry);
+        }
+    }
+    QList<Group*> deletedGroups;
+    for (Group* group : asConst(update.groups)) {
+        if (!update.keptGroups.contains(group) && update.keptGroups.contains(group->parentGroup())) {
+            deletedGroups.append(group);
+        }
+    }
+    qDeleteAll(deletedEntries);
+    qDeleteAll(deletedGroups);
+    updateLastTopVisibleEntries(m_rootGroup, other->rootGroup());
+
+    m_data = other->m_data;
+    m_deletedObjects = other->m_deletedObjects;
+
+    const QString name = m_metadata->name();
+    m_metadata->updateFrom(other->metadata(), m_rootGroup);
+    if (m_metadata->name() != name) {
+        emit nameTextChanged();
+    }
+
+    const QList<Group*> updatedGroups = m_rootGroup->groupsRecursive(true);
+    for (Group* group : updatedGroups) {
+        group->setUpdateTimeinfo(true);
+    }
+    const QList<Entry*> updatedEntries = m_rootGroup->entriesRecursive(true);
+    for (Entry* entry : updatedEntries) {
+        entry->setUpdateTimeinfo(true);
+    }
+
+    emit modifiedImmediate();
+}
+
 void Database::setEmitModified(bool value)
 {
     if (m_emitModified && !value) {
@@ -413,8 +629,14 @@ const QUuid& Database::uuid()
     return m_uuid;
 }
 
+quint64 Database::generation() const
+{
+    return m_generation;
+}
+
 Database* Database::databaseByUuid(const QUuid& uuid)
 {
+    QMutexLocker locker(&m_uuidMapMutex);
     return m_uuidMap.value(uuid, 0);
 }
 
@@ -430,6 +652,11 @@ void Database::startModifiedTimer()
     m_timer->start(150);
 }
 
+void Database::incrementGeneration()
+{
+    ++m_generation;
+}
+
 const CompositeKey& Database::key() const
 {
     return m_data.key;
@@ -462,11 +689,11 @@ Database* Database::openDatabaseFile(QString fileName, CompositeKey key)
 Database* Database::unlockFromStdin(QString databaseFilename, QString keyFilename)
 {
     CompositeKey compositeKey;
-    QTextStream outputTextStream(stdout);
     QTextStream errorTextStream(stderr);
 
-    outputTextStream << QObject::tr("Insert password to unlock %1: ").arg(databaseFilename);
-    outputTextStream.flush();
+    // Keep the output of commands free of prompts, it may be parsed
+    errorTextStream << QObject::tr("Insert password to unlock %1: ").arg(databaseFilename);
+    errorTextStream.flush();
 
     QString line = Utils::getPassword();
     PasswordKey passwordKey;
@@ -487,6 +714,115 @@ Database* Database::unlockFromStdin(QString databaseFilename, QString keyFilenam
     return Database::openDatabaseFile(databaseFilename, compositeKey);
 }
 
+namespace
+{
+    Group* snapshotGroup(const Group* group)
+    {
+        Group* copy = group->clone(Entry::CloneNoFlags, Group::CloneNoFlags);
+        // keep the location changed times of the copies
+        copy->setUpdateTimeinfo(false);
+
+        for (const Entry* entry : group->entries()) {
+            Entry* entryCopy = entry->clone(Entry::CloneIncludeHistory);
+            entryCopy->setUpdateTimeinfo(false);
+            entryCopy->setGroup(copy);
+            entryCopy->setUpdateTimeinfo(true);
+            if (entry == group->lastTopVisibleEntry()) {
+                copy->setLastTopVisibleEntry(entryCopy);
+            }
+        }
+
+        for (const Group* child : group->children()) {
+            Group* childCopy = snapshotGroup(child);
+            childCopy->setParent(copy);
+            childCopy->setUpdateTimeinfo(true);
+        }
+
+        return copy;
+    }
+} // namespace
+
+/**
+ * Apply what saving changes on a snapshot: an implicit upgrade to KDBX 4
+ * and a new KDF seed. The key is transformed here, which is slow, so call
+ * this from the thread writing the snapshot. Its KDF is not shared with
+ * the database the snapshot was taken from.
+ *
+ * @return error string, if any
+ */
+QString Database::prepareSnapshot()
+{
+    Q_ASSERT(m_snapshot);
+
+    KeePass2Writer writer;
+    setEmitModified(false);
+    writer.prepareDatabase(this);
+    setEmitModified(true);
+
+    if (writer.hasError()) {
+        return writer.errorString();
+    }
+    return {};
+}
+
+/**
+ * Create a copy of everything that is written to a file, which can be
+ * saved from another thread while this database is edited further.
+ * Strings and attachments are implicitly shared with this database, so
+ * taking a snapshot does not copy their data.
+ *
+ * Call prepareSnapshot() on the snapshot before writing it, and
+ * applySnapshotKey() once it is written. The snapshot is not connected
+ * to this database and owned by the caller.
+ */
+Database* Database::snapshot() const
+{
+    auto* db = new Database();
+    db->m_data = m_data;
+    // the next save randomizes the seed of this database while the snapshot may still be written
+    db->m_data.kdf = m_data.kdf->clone();
+    db->m_snapshot = true;
+
+    Group* rootGroup = snapshotGroup(m_rootGroup);
+    delete db->m_rootGroup;
+    db->setRootGroup(rootGroup);
+    rootGroup->setUpdateTimeinfo(true);
+
+    db->m_deletedObjects = m_deletedObjects;
+    db->m_metadata->copySnapshotFrom(m_metadata, rootGroup);
+
+    return db;
+}
+
+/**
+ * Take over the KDF seed and transformed key a snapshot of this database
+ * was written with, unless the key was changed since it was taken.
+ *
+ * @param snapshot snapshot prepared by prepareSnapshot()
+ * @param transformedMasterKey transformed key of this database when the snapshot was taken
+ */
+void Database::applySnapshotKey(const Database* snapshot, const QByteArray& transformedMasterKey)
+{
+    Q_ASSERT(snapshot->m_snapshot);
+
+    if (m_data.transformedMasterKey != transformedMasterKey) {
+        return;
+    }
+
+    // writing a file does not modify the database
+    m_data.kdf = snapshot->m_data.kdf->clone();
+    m_data.transformedMasterKey = snapshot->m_data.transformedMasterKey;
+}
+
+/**
+ * Report the memory used by the groups, entries and metadata, by category
+ * and per group, together with the largestEntryCount biggest entries.
+ */
+DatabaseMemoryStats Database::memoryStats(int largestEntryCount) const
+{
+    return DatabaseMemoryStats(this, largestEntryCount);
+}
+
 /**
  * Save the database to a file.
  *
@@ -566,7 +902,11 @@ QString Database::writeDatabase(QIODevice* device)
 {
     KeePass2Writer writer;
     setEmitModified(false);
-    writer.writeDatabase(device, this);
+    if (m_snapshot) {
+        writer.writePreparedDatabase(device, this);
+    } else {
+        writer.writeDatabase(device, this);
+    }
     setEmitModified(true);
 
     if (writer.hasError()) {
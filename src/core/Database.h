@@ -21,11 +21,13 @@
 
 #include <QDateTime>
 #include <QHash>
+#include <QMutex>
 #include <QObject>
 
 #include "crypto/kdf/Kdf.h"
 #include "keys/CompositeKey.h"
 
+class DatabaseMemoryStats;
 class Entry;
 enum class EntryReferenceType;
 class Group;
@@ -52,6 +54,7 @@ public:
         CompressionGZip = 1
     };
     static const quint32 CompressionAlgorithmMax = CompressionGZip;
+    static const int DefaultCompressionLevel = 6;
 
     struct DatabaseData
     {
@@ -85,12 +88,13 @@ public:
     Entry* resolveEntry(const QUuid& uuid);
     Entry* resolveEntry(const QString& text, EntryReferenceType referenceType);
     Group* resolveGroup(const QUuid& uuid);
-    QList<DeletedObject> deletedObjects();
+    QList<DeletedObject> deletedObjects() const;
     void addDeletedObject(const DeletedObject& delObj);
     void addDeletedObject(const QUuid& uuid);
 
     const QUuid& cipher() const;
     Database::CompressionAlgorithm compressionAlgo() const;
+    int compressionLevel() const;
     QSharedPointer<Kdf> kdf() const;
     QByteArray transformedMasterKey() const;
     const CompositeKey& key() const;
@@ -99,6 +103,7 @@ public:
 
     void setCipher(const QUuid& cipher);
     void setCompressionAlgo(Database::CompressionAlgorithm algo);
+    void setCompressionLevel(int level);
     void setKdf(QSharedPointer<Kdf> kdf);
     bool setKey(const CompositeKey& key, bool updateChangedTime = true, bool updateTransformSalt = false);
     bool hasKey() const;
@@ -111,12 +116,23 @@ public:
     void emptyRecycleBin();
     void setEmitModified(bool value);
     void merge(const Database* other);
+    void updateFrom(const Database* other);
     QString saveToFile(QString filePath, bool atomic = true, bool backup = false);
+    QString prepareSnapshot();
+    Database* snapshot() const;
+    void applySnapshotKey(const Database* snapshot, const QByteArray& transformedMasterKey);
+    DatabaseMemoryStats memoryStats(int largestEntryCount = 10) const;
 
     /**
      * Returns a unique id that is only valid as long as the Database exists.
      */
     const QUuid& uuid();
+
+    /**
+     * Returns a counter that is incremented on every modification of the
+     * database. It can be used to invalidate data derived from its contents.
+     */
+    quint64 generation() const;
     bool changeKdf(QSharedPointer<Kdf> kdf);
 
     static Database* databaseByUuid(const QUuid& uuid);
@@ -131,12 +147,21 @@ signals:
     void groupRemoved();
     void groupAboutToMove(Group* group, Group* toGroup, int index);
     void groupMoved();
+    /**
+     * Entry signals of all groups in the database.
+     */
+    void entryAboutToAdd(Entry* entry);
+    void entryAdded(Entry* entry);
+    void entryAboutToRemove(Entry* entry);
+    void entryRemoved(Entry* entry);
+    void entryDataChanged(Entry* entry);
     void nameTextChanged();
     void modified();
     void modifiedImmediate();
 
 private slots:
     void startModifiedTimer();
+    void incrementGeneration();
 
 private:
     Entry* findEntryRecursive(const QUuid& uuid, Group* group);
@@ -153,9 +178,13 @@ private:
     QTimer* m_timer;
     DatabaseData m_data;
     bool m_emitModified;
+    quint64 m_generation;
+    bool m_snapshot;
 
     QUuid m_uuid;
     static QHash<QUuid, Database*> m_uuidMap;
+    // databases are also created by threads unlocking them
+    static QMutex m_uuidMapMutex;
 };
 
 #endif // KEEPASSX_DATABASE_H
@@ -122,11 +122,9 @@ QPixmap DatabaseIcons::iconPixmap(int index)
         return QPixmap();
     }
 
-    QPixmap pixmap;
-
-    if (!QPixmapCache::find(m_pixmapCacheKeys[index], &pixmap)) {
+    QPixmap& pixmap = m_pixmapCache[index];
+    if (pixmap.isNull()) {
         pixmap = QPixmap::fromImage(icon(index));
-        m_pixmapCacheKeys[index] = QPixmapCache::insert(pixmap);
     }
 
     return pixmap;
@@ -138,8 +136,8 @@ DatabaseIcons::DatabaseIcons()
 
     m_iconCache.reserve(IconCount);
     m_iconCache.resize(IconCount);
-    m_pixmapCacheKeys.reserve(IconCount);
-    m_pixmapCacheKeys.resize(IconCount);
+    m_pixmapCache.reserve(IconCount);
+    m_pixmapCache.resize(IconCount);
 }
 
 DatabaseIcons* DatabaseIcons::instance()
@@ -20,7 +20,6 @@
 
 #include <QImage>
 #include <QPixmap>
-#include <QPixmapCache>
 #include <QVector>
 
 class DatabaseIcons
@@ -41,7 +40,8 @@ private:
 
     static const char* const m_indexToName[];
     QVector<QImage> m_iconCache;
-    QVector<QPixmapCache::Key> m_pixmapCacheKeys;
+    // The built-in icons are few and small, they are never evicted
+    QVector<QPixmap> m_pixmapCache;
 
     Q_DISABLE_COPY(DatabaseIcons)
 };
@@ -0,0 +1,267 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseMemoryStats.h"
+
+#include <QImage>
+#include <QJsonArray>
+#include <QSet>
+
+#include <algorithm>
+
+#include "core/CustomData.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "core/Metadata.h"
+
+namespace
+{
+    /**
+     * Counts every piece of data once, no matter how many strings or byte
+     * arrays refer to it.
+     */
+    class Collector
+    {
+    public:
+        qint64 string(const QString& value)
+        {
+            if (value.isEmpty() || !markSeen(value.constData())) {
+                return 0;
+            }
+            return value.size() * static_cast<qint64>(sizeof(QChar));
+        }
+
+        qint64 customData(const CustomData* customData)
+        {
+            qint64 size = 0;
+            for (const QString& key : customData->keys()) {
+                size += string(key) + string(customData->value(key));
+            }
+            return size;
+        }
+
+        DatabaseMemoryStats::Usage entry(const Entry* entry)
+        {
+            DatabaseMemoryStats::Usage usage;
+
+            const EntryAttributes* attributes = entry->attributes();
+            for (const QString& key : attributes->keys()) {
+                const qint64 size = string(key) + string(attributes->value(key));
+                if (attributes->isProtected(key)) {
+                    usage.protectedValues += size;
+                } else {
+                    usage.attributes += size;
+                }
+            }
+            usage.attributes += string(entry->tags());
+
+            const EntryAttachments* attachments = entry->attachments();
+            for (const QString& key : attachments->keys()) {
+                const QByteArray data = attachments->value(key);
+                usage.attachments += string(key);
+                if (data.isEmpty()) {
+                    continue;
+                }
+                if (markSeen(data.constData())) {
+                    usage.attachments += data.size();
+                } else {
+                    usage.sharedAttachments += data.size();
+                }
+            }
+
+            usage.customData += customData(entry->customData());
+            return usage;
+        }
+
+    private:
+        bool markSeen(const void* data)
+        {
+            if (m_seen.contains(data)) {
+                return false;
+            }
+            m_seen.insert(data);
+            return true;
+        }
+
+        QSet<const void*> m_seen;
+    };
+
+    void collectGroup(Collector& collector,
+                      const Group* group,
+                      const QString& path,
+                      DatabaseMemoryStats& stats,
+                      QList<DatabaseMemoryStats::EntryUsage>& entries)
+    {
+        DatabaseMemoryStats::GroupUsage groupUsage;
+        groupUsage.uuid = group->uuid();
+        groupUsage.path = path;
+
+        DatabaseMemoryStats::Usage& usage = groupUsage.usage;
+        usage.attributes += collector.string(group->name()) + collector.string(group->notes());
+        usage.customData += collector.customData(group->customData());
+
+        for (const Entry* entry : group->entries()) {
+            // The entry comes first, so data shared with its history counts as the entry's
+            DatabaseMemoryStats::Usage entryUsage = collector.entry(entry);
+            for (const Entry* historyItem : entry->historyItems()) {
+                const DatabaseMemoryStats::Usage historyUsage = collector.entry(historyItem);
+                entryUsage.history += historyUsage.total();
+                entryUsage.sharedAttachments += historyUsage.sharedAttachments;
+                ++entryUsage.historyItems;
+            }
+            entryUsage.entries = 1;
+            usage.add(entryUsage);
+
+            DatabaseMemoryStats::EntryUsage entryInfo;
+            entryInfo.uuid = entry->uuid();
+            entryInfo.title = entry->title();
+            entryInfo.groupPath = path;
+            entryInfo.bytes = entryUsage.total();
+            entryInfo.historyBytes = entryUsage.history;
+            entryInfo.historyItems = entryUsage.historyItems;
+            entries.append(entryInfo);
+        }
+
+        stats.total.add(usage);
+        stats.groups.append(groupUsage);
+
+        const QString childPrefix = path.endsWith('/') ? path : path + '/';
+        for (const Group* child : group->children()) {
+            collectGroup(collector, child, childPrefix + child->name(), stats, entries);
+        }
+    }
+
+    QJsonValue bytesValue(qint64 bytes)
+    {
+        return QJsonValue(static_cast<double>(bytes));
+    }
+} // namespace
+
+DatabaseMemoryStats::Usage::Usage()
+    : attributes(0)
+    , protectedValues(0)
+    , attachments(0)
+    , sharedAttachments(0)
+    , customData(0)
+    , history(0)
+    , entries(0)
+    , historyItems(0)
+{
+}
+
+qint64 DatabaseMemoryStats::Usage::total() const
+{
+    return attributes + protectedValues + attachments + customData + history;
+}
+
+void DatabaseMemoryStats::Usage::add(const Usage& other)
+{
+    attributes += other.attributes;
+    protectedValues += other.protectedValues;
+    attachments += other.attachments;
+    sharedAttachments += other.sharedAttachments;
+    customData += other.customData;
+    history += other.history;
+    entries += other.entries;
+    historyItems += other.historyItems;
+}
+
+QJsonObject DatabaseMemoryStats::Usage::toJson() const
+{
+    QJsonObject object;
+    object.insert("total", bytesValue(total()));
+    object.insert("attributes", bytesValue(attributes));
+    object.insert("protectedValues", bytesValue(protectedValues));
+    object.insert("attachments", bytesValue(attachments));
+    object.insert("sharedAttachments", bytesValue(sharedAttachments));
+    object.insert("customData", bytesValue(customData));
+    object.insert("history", bytesValue(history));
+    object.insert("entries", entries);
+    object.insert("historyItems", historyItems);
+    return object;
+}
+
+DatabaseMemoryStats::DatabaseMemoryStats()
+    : customIcons(0)
+    , metadataCustomData(0)
+    , deletedObjects(0)
+{
+}
+
+DatabaseMemoryStats::DatabaseMemoryStats(const Database* db, int largestEntryCount)
+    : DatabaseMemoryStats()
+{
+    Collector collector;
+
+    const Metadata* metadata = db->metadata();
+    const QHash<QUuid, QImage> icons = metadata->customIcons();
+    for (const QImage& icon : icons) {
+        customIcons += static_cast<qint64>(icon.bytesPerLine()) * icon.height();
+    }
+    metadataCustomData = collector.customData(metadata->customData());
+    deletedObjects = static_cast<qint64>(db->deletedObjects().size()) * sizeof(DeletedObject);
+
+    QList<EntryUsage> entries;
+    if (db->rootGroup()) {
+        collectGroup(collector, db->rootGroup(), QStringLiteral("/"), *this, entries);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const EntryUsage& lhs, const EntryUsage& rhs) {
+        return lhs.bytes > rhs.bytes;
+    });
+    largestEntries = entries.mid(0, largestEntryCount);
+}
+
+qint64 DatabaseMemoryStats::totalBytes() const
+{
+    return total.total() + customIcons + metadataCustomData + deletedObjects;
+}
+
+QJsonObject DatabaseMemoryStats::toJson() const
+{
+    QJsonObject object;
+    object.insert("total", bytesValue(totalBytes()));
+    object.insert("entries", total.toJson());
+    object.insert("customIcons", bytesValue(customIcons));
+    object.insert("metadataCustomData", bytesValue(metadataCustomData));
+    object.insert("deletedObjects", bytesValue(deletedObjects));
+
+    QJsonArray groupArray;
+    for (const GroupUsage& group : groups) {
+        QJsonObject groupObject = group.usage.toJson();
+        groupObject.insert("uuid", QString::fromLatin1(group.uuid.toRfc4122().toHex()));
+        groupObject.insert("path", group.path);
+        groupArray.append(groupObject);
+    }
+    object.insert("groups", groupArray);
+
+    QJsonArray entryArray;
+    for (const EntryUsage& entry : largestEntries) {
+        QJsonObject entryObject;
+        entryObject.insert("uuid", QString::fromLatin1(entry.uuid.toRfc4122().toHex()));
+        entryObject.insert("title", entry.title);
+        entryObject.insert("group", entry.groupPath);
+        entryObject.insert("total", bytesValue(entry.bytes));
+        entryObject.insert("history", bytesValue(entry.historyBytes));
+        entryObject.insert("historyItems", entry.historyItems);
+        entryArray.append(entryObject);
+    }
+    object.insert("largestEntries", entryArray);
+
+    return object;
+}
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_DATABASEMEMORYSTATS_H
+#define KEEPASSXC_DATABASEMEMORYSTATS_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QUuid>
+
+class Database;
+
+/**
+ * Approximate memory used by the contents of a database, in bytes.
+ *
+ * Strings are counted with their in-memory UTF-16 size and data that is
+ * implicitly shared, e.g. between an entry and its history, only once.
+ * Container overhead is not included.
+ */
+class DatabaseMemoryStats
+{
+public:
+    struct Usage
+    {
+        Usage();
+
+        qint64 attributes;
+        qint64 protectedValues;
+        qint64 attachments;
+        qint64 sharedAttachments;
+        qint64 customData;
+        qint64 history;
+        int entries;
+        int historyItems;
+
+        /**
+         * Shared attachments use no additional memory and are not included.
+         */
+        qint64 total() const;
+        void add(const Usage& other);
+        QJsonObject toJson() const;
+    };
+
+    struct GroupUsage
+    {
+        QUuid uuid;
+        QString path;
+        // Only the entries directly in the group
+        Usage usage;
+    };
+
+    struct EntryUsage
+    {
+        QUuid uuid;
+        QString title;
+        QString groupPath;
+        qint64 bytes;
+        qint64 historyBytes;
+        int historyItems;
+    };
+
+    DatabaseMemoryStats();
+    explicit DatabaseMemoryStats(const Database* db, int largestEntryCount = 10);
+
+    Usage total;
+    qint64 customIcons;
+    qint64 metadataCustomData;
+    qint64 deletedObjects;
+    QList<GroupUsage> groups;
+    QList<EntryUsage> largestEntries;
+
+    qint64 totalBytes() const;
+    QJsonObject toJson() const;
+};
+
+#endif // KEEPASSXC_DATABASEMEMORYSTATS_H
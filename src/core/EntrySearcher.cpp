@@ -19,9 +19,12 @@
 #include "EntrySearcher.h"
 
 #include "core/Group.h"
+#include "core/Trace.h"
 
 QList<Entry*> EntrySearcher::search(const QString& searchTerm, const Group* group, Qt::CaseSensitivity caseSensitivity)
 {
+    TRACE_SPAN("core", "EntrySearcher::search");
+
     if (!group->resolveSearchingEnabled()) {
         return QList<Entry*>();
     }
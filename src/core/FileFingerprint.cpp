@@ -0,0 +1,78 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FileFingerprint.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+
+namespace
+{
+    // Large enough for the outer header and the final HMAC or hashed blocks
+    const qint64 SampleSize = 4096;
+
+    QByteArray hashRange(QFile& file, qint64 offset, qint64 length)
+    {
+        if (!file.seek(offset)) {
+            return QByteArray();
+        }
+        QByteArray data = file.read(length);
+        if (data.size() != length) {
+            return QByteArray();
+        }
+        return QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+    }
+} // namespace
+
+FileFingerprint::FileFingerprint()
+    : m_size(-1)
+{
+}
+
+FileFingerprint::FileFingerprint(const QString& filePath)
+    : m_size(-1)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const qint64 size = file.size();
+    const qint64 sampleSize = qMin(size, SampleSize);
+    m_headerHash = hashRange(file, 0, sampleSize);
+    m_trailerHash = hashRange(file, size - sampleSize, sampleSize);
+    if (m_headerHash.isEmpty() || m_trailerHash.isEmpty()) {
+        return;
+    }
+
+    m_size = size;
+}
+
+bool FileFingerprint::isValid() const
+{
+    return m_size >= 0;
+}
+
+/**
+ * The modification time is not compared, sync clients and some editors touch
+ * or rewrite files without changing them.
+ */
+bool FileFingerprint::hasSameContent(const FileFingerprint& other) const
+{
+    return isValid() && other.isValid() && m_size == other.m_size && m_headerHash == other.m_headerHash
+           && m_trailerHash == other.m_trailerHash;
+}
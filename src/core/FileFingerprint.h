@@ -0,0 +1,46 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_FILEFINGERPRINT_H
+#define KEEPASSXC_FILEFINGERPRINT_H
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * Cheap fingerprint of a database file, taken without decrypting it.
+ *
+ * Every save writes a fresh master seed and IV into the header and the
+ * payload ends with its HMAC or hashed blocks, so hashing the beginning and
+ * the end of the file is enough to tell whether the content was rewritten.
+ */
+class FileFingerprint
+{
+public:
+    FileFingerprint();
+    explicit FileFingerprint(const QString& filePath);
+
+    bool isValid() const;
+    bool hasSameContent(const FileFingerprint& other) const;
+
+private:
+    qint64 m_size;
+    QByteArray m_headerHash;
+    QByteArray m_trailerHash;
+};
+
+#endif // KEEPASSXC_FILEFINGERPRINT_H
@@ -22,6 +22,7 @@
 #include "core/DatabaseIcons.h"
 #include "core/Global.h"
 #include "core/Metadata.h"
+#include "core/Trace.h"
 
 const int Group::DefaultIconNumber = 48;
 const int Group::RecycleBinIconNumber = 43;
@@ -34,6 +35,7 @@ Entry::CloneFlags Group::DefaultEntryCloneFlags =
 
 Group::Group()
     : m_customData(new CustomData(this))
+    , m_row(-1)
     , m_updateTimeinfo(true)
 {
     m_data.iconNumber = DefaultIconNumber;
@@ -385,7 +387,7 @@ void Group::setParent(Group* parent, int index)
         }
     }
 
-    if (m_parent == parent && parent->children().indexOf(this) == index) {
+    if (m_parent == parent && m_row == index) {
         return;
     }
 
@@ -406,15 +408,13 @@ void Group::setParent(Group* parent, int index)
         }
         QObject::setParent(parent);
         emit aboutToAdd(this, index);
-        Q_ASSERT(index <= parent->m_children.size());
-        parent->m_children.insert(index, this);
+        parent->insertChild(this, index);
     } else {
         emit aboutToMove(this, parent, index);
-        m_parent->m_children.removeAll(this);
+        m_parent->takeChild(this);
         m_parent = parent;
         QObject::setParent(parent);
-        Q_ASSERT(index <= parent->m_children.size());
-        parent->m_children.insert(index, this);
+        parent->insertChild(this, index);
     }
 
     if (m_updateTimeinfo) {
@@ -430,6 +430,14 @@ void Group::setParent(Group* parent, int index)
     }
 }
 
+/**
+ * Position of the group in the children of its parent, -1 if it has no parent
+ */
+int Group::row() const
+{
+    return m_row;
+}
+
 void Group::setParent(Database* db)
 {
     Q_ASSERT(db);
@@ -679,6 +687,7 @@ QSet<QUuid> Group::customIconsRecursive() const
 
 void Group::merge(const Group* other)
 {
+    TRACE_SPAN("core", "Group::merge");
 
     Group* rootGroup = this;
     while (rootGroup->parentGroup()) {
@@ -846,6 +855,11 @@ void Group::recSetDatabase(Database* db)
         disconnect(SIGNAL(aboutToMove(Group*, Group*, int)), m_db);
         disconnect(SIGNAL(moved()), m_db);
         disconnect(SIGNAL(modified()), m_db);
+        disconnect(SIGNAL(entryAboutToAdd(Entry*)), m_db);
+        disconnect(SIGNAL(entryAdded(Entry*)), m_db);
+        disconnect(SIGNAL(entryAboutToRemove(Entry*)), m_db);
+        disconnect(SIGNAL(entryRemoved(Entry*)), m_db);
+        disconnect(SIGNAL(entryDataChanged(Entry*)), m_db);
     }
 
     for (Entry* entry : asConst(m_entries)) {
@@ -866,6 +880,11 @@ void Group::recSetDatabase(Database* db)
         connect(this, SIGNAL(aboutToMove(Group*, Group*, int)), db, SIGNAL(groupAboutToMove(Group*, Group*, int)));
         connect(this, SIGNAL(moved()), db, SIGNAL(groupMoved()));
         connect(this, SIGNAL(modified()), db, SIGNAL(modifiedImmediate()));
+        connect(this, SIGNAL(entryAboutToAdd(Entry*)), db, SIGNAL(entryAboutToAdd(Entry*)));
+        connect(this, SIGNAL(entryAdded(Entry*)), db, SIGNAL(entryAdded(Entry*)));
+        connect(this, SIGNAL(entryAboutToRemove(Entry*)), db, SIGNAL(entryAboutToRemove(Entry*)));
+        connect(this, SIGNAL(entryRemoved(Entry*)), db, SIGNAL(entryRemoved(Entry*)));
+        connect(this, SIGNAL(entryDataChanged(Entry*)), db, SIGNAL(entryDataChanged(Entry*)));
     }
 
     m_db = db;
@@ -879,12 +898,35 @@ void Group::cleanupParent()
 {
     if (m_parent) {
         emit aboutToRemove(this);
-        m_parent->m_children.removeAll(this);
+        m_parent->takeChild(this);
         emit modified();
         emit removed();
     }
 }
 
+void Group::insertChild(Group* group, int index)
+{
+    Q_ASSERT(index <= m_children.size());
+    m_children.insert(index, group);
+    updateChildRows(index);
+}
+
+void Group::takeChild(Group* group)
+{
+    Q_ASSERT(m_children.value(group->m_row) == group);
+    const int row = group->m_row;
+    m_children.removeAt(row);
+    group->m_row = -1;
+    updateChildRows(row);
+}
+
+void Group::updateChildRows(int from)
+{
+    for (int i = from; i < m_children.size(); ++i) {
+        m_children.at(i)->m_row = i;
+    }
+}
+
 void Group::recCreateDelObjects()
 {
     if (m_db) {
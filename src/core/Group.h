@@ -132,6 +132,7 @@ public:
     Group* parentGroup();
     const Group* parentGroup() const;
     void setParent(Group* parent, int index = -1);
+    int row() const;
     QStringList hierarchy() const;
 
     Database* database();
@@ -194,6 +195,9 @@ private:
     void recSetDatabase(Database* db);
     void cleanupParent();
     void recCreateDelObjects();
+    void insertChild(Group* group, int index);
+    void takeChild(Group* group);
+    void updateChildRows(int from);
 
     QPointer<Database> m_db;
     QUuid m_uuid;
@@ -205,6 +209,7 @@ private:
     QPointer<CustomData> m_customData;
 
     QPointer<Group> m_parent;
+    int m_row;
 
     bool m_updateTimeinfo;
 
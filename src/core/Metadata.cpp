@@ -16,6 +16,8 @@
  */
 
 #include "Metadata.h"
+#include <QGuiApplication>
+#include <QtConcurrentRun>
 #include <QtCore/QCryptographicHash>
 
 #include "core/Entry.h"
@@ -25,8 +27,15 @@
 const int Metadata::DefaultHistoryMaxItems = 10;
 const int Metadata::DefaultHistoryMaxSize = 6 * 1024 * 1024;
 
+namespace
+{
+    const int ScaledIconSize = 16;
+}
+
 Metadata::Metadata(QObject* parent)
     : QObject(parent)
+    , m_customIconDevicePixelRatio(0)
+    , m_customIconScaleWatcher(new QFutureWatcher<QVector<ScaledIcon>>(this))
     , m_customData(new CustomData(this))
     , m_updateDatetime(true)
 {
@@ -53,6 +62,7 @@ Metadata::Metadata(QObject* parent)
     m_settingsChanged = now;
 
     connect(m_customData, SIGNAL(modified()), this, SIGNAL(modified()));
+    connect(m_customIconScaleWatcher, SIGNAL(finished()), SLOT(customIconsScaled()));
 }
 
 template <class P, class V> bool Metadata::set(P& property, const V& value)
@@ -90,6 +100,53 @@ void Metadata::copyAttributesFrom(const Metadata* other)
     m_data = other->m_data;
 }
 
+void Metadata::copySnapshotFrom(const Metadata* other, Group* rootGroup)
+{
+    m_customIcons = other->m_customIcons;
+    m_customIconsOrder = other->m_customIconsOrder;
+    m_customIconsHashes = other->m_customIconsHashes;
+    copyFieldsFrom(other, rootGroup);
+}
+
+void Metadata::updateFrom(const Metadata* other, Group* rootGroup)
+{
+    const QList<QUuid> iconUuids = m_customIconsOrder;
+    for (const QUuid& uuid : iconUuids) {
+        if (!other->m_customIcons.contains(uuid) || other->m_customIcons.value(uuid) != m_customIcons.value(uuid)) {
+            removeCustomIcon(uuid);
+        }
+    }
+    for (const QUuid& uuid : other->m_customIconsOrder) {
+        if (!m_customIcons.contains(uuid)) {
+            addCustomIcon(uuid, other->m_customIcons.value(uuid));
+        }
+    }
+
+    copyFieldsFrom(other, rootGroup);
+    emit modified();
+}
+
+/**
+ * Copy everything but the custom icons from other.
+ */
+void Metadata::copyFieldsFrom(const Metadata* other, Group* rootGroup)
+{
+    m_data = other->m_data;
+    m_customData->copyDataFrom(other->m_customData);
+
+    auto resolveGroup = [rootGroup](const Group* group) -> Group* {
+        return group ? rootGroup->findChildByUuid(group->uuid()) : nullptr;
+    };
+    m_recycleBin = resolveGroup(other->m_recycleBin);
+    m_recycleBinChanged = other->m_recycleBinChanged;
+    m_entryTemplatesGroup = resolveGroup(other->m_entryTemplatesGroup);
+    m_entryTemplatesGroupChanged = other->m_entryTemplatesGroupChanged;
+    m_lastSelectedGroup = resolveGroup(other->m_lastSelectedGroup);
+    m_lastTopVisibleGroup = resolveGroup(other->m_lastTopVisibleGroup);
+    m_masterKeyChanged = other->m_masterKeyChanged;
+    m_settingsChanged = other->m_settingsChanged;
+}
+
 QString Metadata::generator() const
 {
     return m_data.generator;
@@ -185,21 +242,100 @@ QPixmap Metadata::customIconPixmap(const QUuid& uuid) const
 
 QPixmap Metadata::customIconScaledPixmap(const QUuid& uuid) const
 {
-    QPixmap pixmap;
+    auto it = m_customIconScaledPixmaps.constFind(uuid);
+    if (it != m_customIconScaledPixmaps.constEnd()) {
+        return it.value();
+    }
 
     if (!m_customIcons.contains(uuid)) {
-        return pixmap;
+        return QPixmap();
     }
 
-    QPixmapCache::Key& cacheKey = m_customIconScaledCacheKeys[uuid];
+    QPixmap pixmap = QPixmap::fromImage(scaleCustomIcon(m_customIcons.value(uuid), iconDevicePixelRatio()));
+    m_customIconScaledPixmaps.insert(uuid, pixmap);
+    return pixmap;
+}
 
-    if (!QPixmapCache::find(cacheKey, &pixmap)) {
-        QImage image = m_customIcons.value(uuid).scaled(16, 16, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        pixmap = QPixmap::fromImage(image);
-        cacheKey = QPixmapCache::insert(pixmap);
+/**
+ * Scale all custom icons for the current device pixel ratio in a worker
+ * thread, so views don't have to scale them while painting.
+ */
+void Metadata::scaleCustomIcons()
+{
+    const qreal devicePixelRatio = currentDevicePixelRatio();
+    if (devicePixelRatio != m_customIconDevicePixelRatio) {
+        m_customIconDevicePixelRatio = devicePixelRatio;
+        m_customIconScaledPixmaps.clear();
     }
 
-    return pixmap;
+    QHash<QUuid, QImage> icons;
+    for (auto it = m_customIcons.constBegin(); it != m_customIcons.constEnd(); ++it) {
+        if (!m_customIconScaledPixmaps.contains(it.key())) {
+            icons.insert(it.key(), it.value());
+        }
+    }
+
+    if (!icons.isEmpty()) {
+        m_customIconScaleWatcher->setFuture(QtConcurrent::run(scaleCustomIconImages, icons, devicePixelRatio));
+    }
+}
+
+void Metadata::customIconsScaled()
+{
+    const QVector<ScaledIcon> scaledIcons = m_customIconScaleWatcher->result();
+    for (const ScaledIcon& scaledIcon : scaledIcons) {
+        // The icon may have been replaced or the ratio changed while scaling
+        auto icon = m_customIcons.constFind(scaledIcon.uuid);
+        if (icon == m_customIcons.constEnd() || icon.value().cacheKey() != scaledIcon.sourceKey
+            || scaledIcon.image.devicePixelRatio() != m_customIconDevicePixelRatio
+            || m_customIconScaledPixmaps.contains(scaledIcon.uuid)) {
+            continue;
+        }
+
+        m_customIconScaledPixmaps.insert(scaledIcon.uuid, QPixmap::fromImage(scaledIcon.image));
+    }
+}
+
+QImage Metadata::scaleCustomIcon(const QImage& icon, qreal devicePixelRatio)
+{
+    const int size = qRound(ScaledIconSize * devicePixelRatio);
+    QImage image = icon.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    image.setDevicePixelRatio(devicePixelRatio);
+    return image;
+}
+
+// Runs in a worker thread, QPixmap can only be created in the GUI thread
+QVector<Metadata::ScaledIcon> Metadata::scaleCustomIconImages(const QHash<QUuid, QImage>& icons,
+                                                              qreal devicePixelRatio)
+{
+    QVector<ScaledIcon> scaledIcons;
+    scaledIcons.reserve(icons.size());
+
+    for (auto it = icons.constBegin(); it != icons.constEnd(); ++it) {
+        ScaledIcon scaledIcon;
+        scaledIcon.uuid = it.key();
+        scaledIcon.sourceKey = it.value().cacheKey();
+        scaledIcon.image = scaleCustomIcon(it.value(), devicePixelRatio);
+        scaledIcons.append(scaledIcon);
+    }
+
+    return scaledIcons;
+}
+
+qreal Metadata::iconDevicePixelRatio() const
+{
+    if (m_customIconDevicePixelRatio <= 0) {
+        m_customIconDevicePixelRatio = currentDevicePixelRatio();
+    }
+
+    return m_customIconDevicePixelRatio;
+}
+
+qreal Metadata::currentDevicePixelRatio()
+{
+    // keepassxc-cli has no QGuiApplication
+    auto* app = qobject_cast<QGuiApplication*>(QCoreApplication::instance());
+    return app ? app->devicePixelRatio() : 1.0;
 }
 
 bool Metadata::containsCustomIcon(const QUuid& uuid) const
@@ -386,7 +522,7 @@ void Metadata::addCustomIcon(const QUuid& uuid, const QImage& icon)
     m_customIcons.insert(uuid, icon);
     // reset cache in case there is also an icon with that uuid
     m_customIconCacheKeys[uuid] = QPixmapCache::Key();
-    m_customIconScaledCacheKeys[uuid] = QPixmapCache::Key();
+    m_customIconScaledPixmaps.remove(uuid);
     m_customIconsOrder.append(uuid);
     // Associate image hash to uuid
     QByteArray hash = hashImage(icon);
@@ -423,8 +559,7 @@ void Metadata::removeCustomIcon(const QUuid& uuid)
     m_customIcons.remove(uuid);
     QPixmapCache::remove(m_customIconCacheKeys.value(uuid));
     m_customIconCacheKeys.remove(uuid);
-    QPixmapCache::remove(m_customIconScaledCacheKeys.value(uuid));
-    m_customIconScaledCacheKeys.remove(uuid);
+    m_customIconScaledPixmaps.remove(uuid);
     m_customIconsOrder.removeAll(uuid);
     Q_ASSERT(m_customIcons.count() == m_customIconsOrder.count());
     emit modified();
@@ -20,12 +20,14 @@
 
 #include <QColor>
 #include <QDateTime>
+#include <QFutureWatcher>
 #include <QHash>
 #include <QImage>
 #include <QPixmap>
 #include <QPixmapCache>
 #include <QPointer>
 #include <QUuid>
+#include <QVector>
 
 #include "core/CustomData.h"
 
@@ -81,6 +83,7 @@ public:
     QImage customIcon(const QUuid& uuid) const;
     QPixmap customIconPixmap(const QUuid& uuid) const;
     QPixmap customIconScaledPixmap(const QUuid& uuid) const;
+    void scaleCustomIcons();
     bool containsCustomIcon(const QUuid& uuid) const;
     QHash<QUuid, QImage> customIcons() const;
     QList<QUuid> customIconsOrder() const;
@@ -146,25 +149,55 @@ public:
      * - Settings changed date
      */
     void copyAttributesFrom(const Metadata* other);
+    /*
+     * Copy everything that is written to a file from other, for a snapshot
+     * of its database. Group pointers are resolved by uuid below rootGroup.
+     */
+    void copySnapshotFrom(const Metadata* other, Group* rootGroup);
+    /*
+     * Like copySnapshotFrom, but custom icons are added and removed one by
+     * one, so views showing them are updated.
+     */
+    void updateFrom(const Metadata* other, Group* rootGroup);
 
 signals:
     void nameTextChanged();
     void modified();
 
+private slots:
+    void customIconsScaled();
+
 private:
+    struct ScaledIcon
+    {
+        QUuid uuid;
+        qint64 sourceKey;
+        QImage image;
+    };
+
+    static QImage scaleCustomIcon(const QImage& icon, qreal devicePixelRatio);
+    static QVector<ScaledIcon> scaleCustomIconImages(const QHash<QUuid, QImage>& icons, qreal devicePixelRatio);
+    static qreal currentDevicePixelRatio();
+    qreal iconDevicePixelRatio() const;
+
     template <class P, class V> bool set(P& property, const V& value);
     template <class P, class V> bool set(P& property, const V& value, QDateTime& dateTime);
 
     QByteArray hashImage(const QImage& image);
+    void copyFieldsFrom(const Metadata* other, Group* rootGroup);
 
     MetadataData m_data;
 
     QHash<QUuid, QImage> m_customIcons;
     mutable QHash<QUuid, QPixmapCache::Key> m_customIconCacheKeys;
-    mutable QHash<QUuid, QPixmapCache::Key> m_customIconScaledCacheKeys;
     QList<QUuid> m_customIconsOrder;
     QHash<QByteArray, QUuid> m_customIconsHashes;
 
+    // Scaled icons for the views, kept as long as the database is open
+    mutable QHash<QUuid, QPixmap> m_customIconScaledPixmaps;
+    mutable qreal m_customIconDevicePixelRatio;
+    QFutureWatcher<QVector<ScaledIcon>>* m_customIconScaleWatcher;
+
     QPointer<Group> m_recycleBin;
     QDateTime m_recycleBinChanged;
     QPointer<Group> m_entryTemplatesGroup;
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThreadStorage>
+#include <QVector>
+
+namespace
+{
+    // Bounds the memory use of long sessions, later events are dropped
+    const int MaxEvents = 1 << 20;
+
+    struct Event
+    {
+        const char* category;
+        const char* name;
+        qint64 start;
+        // Negative for instant events
+        qint64 duration;
+        int thread;
+    };
+
+    QAtomicInt s_enabled;
+    QMutex s_mutex;
+    QElapsedTimer s_timer;
+    QVector<Event> s_events;
+    QString s_filePath;
+    int s_droppedEvents = 0;
+
+    QAtomicInt s_nextThread;
+    QThreadStorage<int> s_thread;
+
+    int currentThread()
+    {
+        if (!s_thread.hasLocalData()) {
+            s_thread.setLocalData(s_nextThread.fetchAndAddRelaxed(1) + 1);
+        }
+        return s_thread.localData();
+    }
+
+    void addEvent(const Event& event)
+    {
+        QMutexLocker locker(&s_mutex);
+        if (s_events.size() < MaxEvents) {
+            s_events.append(event);
+        } else {
+            ++s_droppedEvents;
+        }
+    }
+} // namespace
+
+Trace::Span::Span(const char* category, const char* name)
+    : m_category(category)
+    , m_name(name)
+    , m_start(Trace::isEnabled() ? s_timer.nsecsElapsed() : -1)
+{
+}
+
+Trace::Span::~Span()
+{
+    if (m_start < 0 || !Trace::isEnabled()) {
+        return;
+    }
+
+    const Event event = {m_category, m_name, m_start, s_timer.nsecsElapsed() - m_start, currentThread()};
+    addEvent(event);
+}
+
+/**
+ * Records a point in time, such as the end of a startup phase.
+ * Category and name must be string literals.
+ */
+void Trace::mark(const char* category, const char* name)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    const Event event = {category, name, s_timer.nsecsElapsed(), -1, currentThread()};
+    addEvent(event);
+}
+
+bool Trace::isEnabled()
+{
+    return s_enabled.loadAcquire() != 0;
+}
+
+void Trace::start(const QString& filePath)
+{
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&s_mutex);
+    s_filePath = filePath;
+    s_events.clear();
+    s_droppedEvents = 0;
+    s_timer.start();
+    // The thread enabling the trace is named "main" in the output
+    currentThread();
+    s_enabled.storeRelease(1);
+}
+
+void Trace::startFromEnvironment()
+{
+    start(QString::fromLocal8Bit(qgetenv("KEEPASSXC_TRACE")));
+}
+
+/**
+ * Stops tracing and writes the recorded events.
+ *
+ * @return false if the trace file could not be written
+ */
+bool Trace::finish()
+{
+    if (!s_enabled.testAndSetOrdered(1, 0)) {
+        return true;
+    }
+
+    QMutexLocker locker(&s_mutex);
+    QFile file(s_filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Unable to write the trace to %s: %s", qPrintable(s_filePath), qPrintable(file.errorString()));
+        return false;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QTextStream out(&file);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":1,\"args\":{\"name\":\"main\"}}";
+    for (const Event& event : s_events) {
+        out << ",\n{\"cat\":\"" << event.category << "\",\"name\":\"" << event.name << "\",\"pid\":" << pid
+            << ",\"tid\":" << event.thread << ",\"ts\":" << event.start / 1000.0;
+        if (event.duration < 0) {
+            out << ",\"ph\":\"i\",\"s\":\"g\"}";
+        } else {
+            out << ",\"ph\":\"X\",\"dur\":" << event.duration / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+    out.flush();
+
+    if (s_droppedEvents > 0) {
+        qWarning("The trace was truncated, %d events were dropped.", s_droppedEvents);
+    }
+
+    s_events.clear();
+    s_events.squeeze();
+    return file.error() == QFile::NoError;
+}
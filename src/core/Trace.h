@@ -0,0 +1,65 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_TRACE_H
+#define KEEPASSXC_TRACE_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * Records the duration of hot code paths and writes them as Chrome trace
+ * events, which can be opened in chrome://tracing or Perfetto.
+ *
+ * Tracing is off by default and a disabled span only costs one atomic load.
+ * It is enabled with the --trace option of keepassxc or by setting the
+ * KEEPASSXC_TRACE environment variable to the output file. Only the latter
+ * covers the startup phases before the command line is parsed.
+ */
+class Trace
+{
+public:
+    /**
+     * Measures the time from its construction to the end of the scope.
+     * Category and name must be string literals.
+     */
+    class Span
+    {
+    public:
+        Span(const char* category, const char* name);
+        ~Span();
+
+    private:
+        Q_DISABLE_COPY(Span)
+
+        const char* const m_category;
+        const char* const m_name;
+        qint64 m_start;
+    };
+
+    static void mark(const char* category, const char* name);
+    static bool isEnabled();
+    static void start(const QString& filePath);
+    static void startFromEnvironment();
+    static bool finish();
+};
+
+#define KEEPASSXC_TRACE_CONCAT_(a, b) a##b
+#define KEEPASSXC_TRACE_CONCAT(a, b) KEEPASSXC_TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(category, name) const Trace::Span KEEPASSXC_TRACE_CONCAT(traceSpan, __LINE__)(category, name)
+
+#endif // KEEPASSXC_TRACE_H
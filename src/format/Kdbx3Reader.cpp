@@ -48,6 +48,10 @@ Database* Kdbx3Reader::readDatabaseImpl(QIODevice* device,
         return nullptr;
     }
 
+    if (!reportProgress(ProgressObserver::KeyTransformation)) {
+        return nullptr;
+    }
+
     if (!m_db->setKey(key, false)) {
         raiseError(tr("Unable to calculate master key"));
         return nullptr;
@@ -58,6 +62,10 @@ Database* Kdbx3Reader::readDatabaseImpl(QIODevice* device,
         return nullptr;
     }
 
+    if (!reportProgress(ProgressObserver::Decryption, device)) {
+        return nullptr;
+    }
+
     CryptoHash hash(CryptoHash::Sha256);
     hash.addData(m_masterSeed);
     hash.addData(m_db->challengeResponseKey());
@@ -120,7 +128,12 @@ Database* Kdbx3Reader::readDatabaseImpl(QIODevice* device,
 
     Q_ASSERT(xmlDevice);
 
+    if (!reportProgress(ProgressObserver::Parsing, device)) {
+        return nullptr;
+    }
+
     KdbxXmlReader xmlReader(KeePass2::FILE_VERSION_3_1);
+    xmlReader.setProgressCallback(parsingProgress(device));
     xmlReader.readDatabase(xmlDevice, m_db.data(), &randomStream);
 
     if (xmlReader.hasError()) {
@@ -27,7 +27,7 @@
 #include "format/KeePass2.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/HashedBlockStream.h"
-#include "streams/QtIOCompressor"
+#include "streams/ParallelGzipStream.h"
 #include "streams/SymmetricCipherStream.h"
 
 bool Kdbx3Writer::writeDatabase(QIODevice* device, Database* db)
@@ -46,11 +46,6 @@ bool Kdbx3Writer::writeDatabase(QIODevice* device, Database* db)
         return false;
     }
 
-    if (!db->setKey(db->key(), false, true)) {
-        raiseError(tr("Unable to calculate master key"));
-        return false;
-    }
-
     // generate transformed master key
     CryptoHash hash(CryptoHash::Sha256);
     hash.addData(masterSeed);
@@ -110,18 +105,17 @@ bool Kdbx3Writer::writeDatabase(QIODevice* device, Database* db)
     }
 
     QIODevice* outputDevice = nullptr;
-    QScopedPointer<QtIOCompressor> ioCompressor;
+    QScopedPointer<ParallelGzipStream> gzipStream;
 
     if (db->compressionAlgo() == Database::CompressionNone) {
         outputDevice = &hashedStream;
     } else {
-        ioCompressor.reset(new QtIOCompressor(&hashedStream));
-        ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
-        if (!ioCompressor->open(QIODevice::WriteOnly)) {
-            raiseError(ioCompressor->errorString());
+        gzipStream.reset(new ParallelGzipStream(&hashedStream, db->compressionLevel()));
+        if (!gzipStream->open(QIODevice::WriteOnly)) {
+            raiseError(gzipStream->errorString());
             return false;
         }
-        outputDevice = ioCompressor.data();
+        outputDevice = gzipStream.data();
     }
 
     Q_ASSERT(outputDevice);
@@ -137,8 +131,9 @@ bool Kdbx3Writer::writeDatabase(QIODevice* device, Database* db)
 
     // Explicitly close/reset streams so they are flushed and we can detect
     // errors. QIODevice::close() resets errorString() etc.
-    if (ioCompressor) {
-        ioCompressor->close();
+    if (gzipStream && !gzipStream->reset()) {
+        raiseError(gzipStream->errorString());
+        return false;
     }
     if (!hashedStream.reset()) {
         raiseError(hashedStream.errorString());
@@ -21,6 +21,7 @@
 
 #include "core/Endian.h"
 #include "core/Group.h"
+#include "core/Trace.h"
 #include "crypto/CryptoHash.h"
 #include "format/KdbxXmlReader.h"
 #include "format/KeePass2RandomStream.h"
@@ -34,6 +35,7 @@ Database* Kdbx4Reader::readDatabaseImpl(QIODevice* device,
                                         bool keepDatabase)
 {
     Q_ASSERT(m_kdbxVersion == KeePass2::FILE_VERSION_4);
+    TRACE_SPAN("format", "Kdbx4Reader::readDatabase");
 
     m_binaryPoolInverse.clear();
 
@@ -47,8 +49,19 @@ Database* Kdbx4Reader::readDatabaseImpl(QIODevice* device,
         return nullptr;
     }
 
-    if (!m_db->setKey(key, false, false)) {
-        raiseError(tr("Unable to calculate master key"));
+    if (!reportProgress(ProgressObserver::KeyTransformation)) {
+        return nullptr;
+    }
+
+    {
+        TRACE_SPAN("format", "Kdbx4Reader::transformKey");
+        if (!m_db->setKey(key, false, false)) {
+            raiseError(tr("Unable to calculate master key"));
+            return nullptr;
+        }
+    }
+
+    if (!reportProgress(ProgressObserver::Decryption, device)) {
         return nullptr;
     }
 
@@ -111,7 +124,10 @@ Database* Kdbx4Reader::readDatabaseImpl(QIODevice* device,
         xmlDevice = ioCompressor.data();
     }
 
-    while (readInnerHeaderField(xmlDevice) && !hasError()) {
+    {
+        TRACE_SPAN("format", "Kdbx4Reader::readInnerHeader");
+        while (readInnerHeaderField(xmlDevice) && !hasError()) {
+        }
     }
 
     if (hasError()) {
@@ -134,7 +150,12 @@ Database* Kdbx4Reader::readDatabaseImpl(QIODevice* device,
 
     Q_ASSERT(xmlDevice);
 
+    if (!reportProgress(ProgressObserver::Parsing, device)) {
+        return nullptr;
+    }
+
     KdbxXmlReader xmlReader(KeePass2::FILE_VERSION_4, binaryPool());
+    xmlReader.setProgressCallback(parsingProgress(device));
     xmlReader.readDatabase(xmlDevice, m_db.data(), &randomStream);
 
     if (xmlReader.hasError()) {
@@ -28,7 +28,7 @@
 #include "format/KdbxXmlWriter.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/HmacBlockStream.h"
-#include "streams/QtIOCompressor"
+#include "streams/ParallelGzipStream.h"
 #include "streams/SymmetricCipherStream.h"
 
 bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
@@ -53,11 +53,6 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
     QByteArray startBytes;
     QByteArray endOfHeader = "\r\n\r\n";
 
-    if (!db->setKey(db->key(), false, true)) {
-        raiseError(tr("Unable to calculate master key"));
-        return false;
-    }
-
     // generate transformed master key
     CryptoHash hash(CryptoHash::Sha256);
     hash.addData(masterSeed);
@@ -136,18 +131,17 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
     }
 
     QIODevice* outputDevice = nullptr;
-    QScopedPointer<QtIOCompressor> ioCompressor;
+    QScopedPointer<ParallelGzipStream> gzipStream;
 
     if (db->compressionAlgo() == Database::CompressionNone) {
         outputDevice = cipherStream.data();
     } else {
-        ioCompressor.reset(new QtIOCompressor(cipherStream.data()));
-        ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
-        if (!ioCompressor->open(QIODevice::WriteOnly)) {
-            raiseError(ioCompressor->errorString());
+        gzipStream.reset(new ParallelGzipStream(cipherStream.data(), db->compressionLevel()));
+        if (!gzipStream->open(QIODevice::WriteOnly)) {
+            raiseError(gzipStream->errorString());
             return false;
         }
-        outputDevice = ioCompressor.data();
+        outputDevice = gzipStream.data();
     }
 
     Q_ASSERT(outputDevice);
@@ -175,8 +169,9 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
 
     // Explicitly close/reset streams so they are flushed and we can detect
     // errors. QIODevice::close() resets errorString() etc.
-    if (ioCompressor) {
-        ioCompressor->close();
+    if (gzipStream && !gzipStream->reset()) {
+        raiseError(gzipStream->errorString());
+        return false;
     }
     if (!cipherStream->reset()) {
         raiseError(cipherStream->errorString());
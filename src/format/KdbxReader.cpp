@@ -130,6 +130,53 @@ KeePass2::ProtectedStreamAlgo KdbxReader::protectedStreamAlgo() const
     return m_irsAlgo;
 }
 
+/**
+ * Set an observer to report the progress of the next reads to.
+ * It is called from the reading thread.
+ *
+ * @param observer progress observer, nullptr to report nothing
+ */
+void KdbxReader::setProgressObserver(ProgressObserver* observer)
+{
+    m_progressObserver = observer;
+}
+
+/**
+ * Report the progress of a stage to the observer, if any.
+ *
+ * @param stage current stage
+ * @param device input file, the position of which gives the progress
+ * @return false if reading was cancelled, an error is raised then
+ */
+bool KdbxReader::reportProgress(ProgressObserver::Stage stage, QIODevice* device)
+{
+    if (!m_progressObserver) {
+        return true;
+    }
+
+    int percent = -1;
+    if (device && device->size() > 0) {
+        percent = static_cast<int>(device->pos() * 100 / device->size());
+    }
+    if (!m_progressObserver->readProgress(stage, percent)) {
+        raiseError(tr("Reading the database was cancelled."));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @param device input file, the position of which gives the progress
+ * @return callback for the XML reader reporting the parsing progress
+ */
+std::function<bool()> KdbxReader::parsingProgress(QIODevice* device)
+{
+    if (!m_progressObserver) {
+        return nullptr;
+    }
+    return [this, device]() { return reportProgress(ProgressObserver::Parsing, device); };
+}
+
 /**
  * @param data stream cipher UUID as bytes
  */
@@ -25,6 +25,8 @@
 #include <QCoreApplication>
 #include <QPointer>
 
+#include <functional>
+
 class Database;
 class QIODevice;
 
@@ -36,6 +38,29 @@ class KdbxReader
     Q_DECLARE_TR_FUNCTIONS(KdbxReader)
 
 public:
+    /**
+     * Receives the progress of a read from the reading thread.
+     */
+    class ProgressObserver
+    {
+    public:
+        enum Stage
+        {
+            KeyTransformation,
+            Decryption,
+            Parsing
+        };
+
+        virtual ~ProgressObserver() = default;
+
+        /**
+         * @param stage stage the reader is in
+         * @param percent progress within the stage, -1 if unknown
+         * @return false to cancel reading
+         */
+        virtual bool readProgress(Stage stage, int percent) = 0;
+    };
+
     KdbxReader() = default;
     virtual ~KdbxReader() = default;
 
@@ -51,6 +76,8 @@ public:
     QByteArray streamKey() const;
     KeePass2::ProtectedStreamAlgo protectedStreamAlgo() const;
 
+    void setProgressObserver(ProgressObserver* observer);
+
 protected:
     /**
      * Concrete reader implementation for reading database from device.
@@ -84,6 +111,9 @@ protected:
 
     void raiseError(const QString& errorMessage);
 
+    bool reportProgress(ProgressObserver::Stage stage, QIODevice* device = nullptr);
+    std::function<bool()> parsingProgress(QIODevice* device);
+
     QScopedPointer<Database> m_db;
 
     QPair<quint32, quint32> m_kdbxSignature;
@@ -99,6 +129,7 @@ protected:
 
 private:
     bool m_saveXml = false;
+    ProgressObserver* m_progressObserver = nullptr;
     bool m_error = false;
     QString m_errorStr = "";
 };
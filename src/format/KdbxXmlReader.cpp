@@ -17,19 +17,218 @@
 
 #include "KdbxXmlReader.h"
 #include "KeePass2RandomStream.h"
+#include "core/Base64.h"
 #include "core/DatabaseIcons.h"
-#include "core/Endian.h"
 #include "core/Entry.h"
 #include "core/Global.h"
 #include "core/Group.h"
 #include "core/Tools.h"
+#include "core/Trace.h"
 #include "streams/QtIOCompressor"
 
 #include <QBuffer>
 #include <QFile>
 
+#include <algorithm>
+
 #define UUID_LENGTH 16
 
+namespace
+{
+    struct TagName
+    {
+        QLatin1String name;
+        int tag;
+    };
+
+    /**
+     * Open addressing table from element names to tags, built once. The
+     * names are hashed straight from the reader's UTF-16 buffer, so mapping
+     * a start element to its tag neither allocates nor converts strings.
+     */
+    class TagTable
+    {
+    public:
+        TagTable(const TagName* names, int count)
+            : m_names(names)
+        {
+            Q_ASSERT(count < Size / 2);
+            std::fill(m_slots, m_slots + Size, -1);
+            for (int i = 0; i < count; ++i) {
+                const QLatin1String name = names[i].name;
+                quint32 slot = hash(name.data(), name.size()) & (Size - 1);
+                while (m_slots[slot] >= 0) {
+                    slot = (slot + 1) & (Size - 1);
+                }
+                m_slots[slot] = i;
+            }
+        }
+
+        int lookup(const QStringRef& name) const
+        {
+            const QChar* data = name.unicode();
+            quint32 slot = hash(data, name.size()) & (Size - 1);
+            while (m_slots[slot] >= 0) {
+                const TagName& candidate = m_names[m_slots[slot]];
+                if (name == candidate.name) {
+                    return candidate.tag;
+                }
+                slot = (slot + 1) & (Size - 1);
+            }
+            return -1;
+        }
+
+    private:
+        // FNV-1a, element names are ASCII so both overloads agree
+        template <typename Char> static quint32 hash(const Char* data, int size)
+        {
+            quint32 h = 2166136261u;
+            for (int i = 0; i < size; ++i) {
+                h = (h ^ static_cast<quint32>(toCode(data[i]))) * 16777619u;
+            }
+            return h;
+        }
+
+        static ushort toCode(QChar c)
+        {
+            return c.unicode();
+        }
+
+        static ushort toCode(char c)
+        {
+            return static_cast<uchar>(c);
+        }
+
+        static const int Size = 256;
+        const TagName* const m_names;
+        int m_slots[Size];
+    };
+
+    // Seconds from 0001-01-01T00:00:00Z, the KDBX 4 time base, to the Unix epoch
+    const qint64 KdbxEpochOffset = Q_INT64_C(62135596800);
+    // Seconds from the KDBX 4 time base to 9999-12-31T23:59:59Z
+    const qint64 KdbxMaxSeconds = Q_INT64_C(315537897599);
+
+    inline int base64Value(ushort c)
+    {
+        if (c >= 'A' && c <= 'Z') {
+            return c - 'A';
+        }
+        if (c >= 'a' && c <= 'z') {
+            return c - 'a' + 26;
+        }
+        if (c >= '0' && c <= '9') {
+            return c - '0' + 52;
+        }
+        if (c == '+') {
+            return 62;
+        }
+        if (c == '/') {
+            return 63;
+        }
+        return -1;
+    }
+
+    /**
+     * Parses the KDBX 4 form, the Base64 encoded little endian seconds since
+     * 0001-01-01. Accepts what the former regex did: whole quanta of the
+     * standard alphabet with padding only in the last one. Only the first
+     * eight bytes are used, shorter values are zero extended.
+     *
+     * @return false if str is not in that form
+     */
+    bool parseBase64Seconds(const QString& str, qint64& secs)
+    {
+        const QChar* data = str.constData();
+        int size = str.size();
+        // QRegularExpression's $ also matched in front of a final newline
+        if (size > 0 && data[size - 1] == '\n') {
+            --size;
+        }
+        if (size % 4 != 0) {
+            return false;
+        }
+
+        int padding = 0;
+        if (size > 0 && data[size - 1] == '=') {
+            padding = data[size - 2] == '=' ? 2 : 1;
+        }
+
+        quint64 value = 0;
+        quint32 buffer = 0;
+        int bits = 0;
+        int bytes = 0;
+        for (int i = 0; i < size - padding; ++i) {
+            const int digit = base64Value(data[i].unicode());
+            if (digit < 0) {
+                return false;
+            }
+            buffer = (buffer << 6) | static_cast<quint32>(digit);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                if (bytes < 8) {
+                    value |= static_cast<quint64>((buffer >> bits) & 0xff) << (8 * bytes);
+                    ++bytes;
+                }
+                buffer &= (1u << bits) - 1;
+            }
+        }
+
+        secs = static_cast<qint64>(value);
+        return true;
+    }
+
+    inline bool parseDigits(const QChar* data, int count, int& value)
+    {
+        value = 0;
+        for (int i = 0; i < count; ++i) {
+            const ushort c = data[i].unicode();
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    }
+
+    /**
+     * Parses the plain UTC form "yyyy-MM-ddTHH:mm:ssZ" written by KDBX 3
+     * databases. Anything else, including invalid dates, is left to
+     * QDateTime::fromString() so its ISO 8601 handling stays the same.
+     *
+     * @return false if str is not in that form
+     */
+    bool parseIsoUtc(const QString& str, QDateTime& dateTime)
+    {
+        if (str.size() != 20) {
+            return false;
+        }
+
+        const QChar* data = str.constData();
+        if (data[4] != '-' || data[7] != '-' || data[10] != 'T' || data[13] != ':' || data[16] != ':'
+            || data[19] != 'Z') {
+            return false;
+        }
+
+        int year, month, day, hour, minute, second;
+        if (!parseDigits(data, 4, year) || !parseDigits(data + 5, 2, month) || !parseDigits(data + 8, 2, day)
+            || !parseDigits(data + 11, 2, hour) || !parseDigits(data + 14, 2, minute)
+            || !parseDigits(data + 17, 2, second)) {
+            return false;
+        }
+
+        const QDate date(year, month, day);
+        const QTime time(hour, minute, second);
+        if (!date.isValid() || !time.isValid()) {
+            return false;
+        }
+
+        dateTime = QDateTime(date, time, Qt::UTC);
+        return true;
+    }
+} // namespace
+
 /**
  * @param version KDBX version
  */
@@ -84,8 +283,11 @@ Database* KdbxXmlReader::readDatabase(QIODevice* device)
 #include "QDebug"
 void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2RandomStream* randomStream)
 {
+    TRACE_SPAN("format", "KdbxXmlReader::readDatabase");
+
     m_error = false;
     m_errorStr.clear();
+    m_cancelled = false;
 
     m_xml.clear();
     m_xml.setDevice(device);
@@ -106,10 +308,14 @@ void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2Random
         return;
     }
 
-    if (m_xml.readNextStartElement() && m_xml.name() == "KeePassFile") {
+    if (m_xml.readNextStartElement() && currentTag() == Tag::KeePassFile) {
         rootGroupParsed = parseKeePassFile();
     }
 
+    if (m_cancelled) {
+        return;
+    }
+
     if (!rootGroupParsed) {
         raiseError(tr("No root group"));
         return;
@@ -170,6 +376,17 @@ void KdbxXmlReader::setStrictMode(bool strictMode)
     m_strictMode = strictMode;
 }
 
+/**
+ * Set a callback which is called for every group and entry read.
+ * Returning false from it cancels reading.
+ *
+ * @param callback progress callback
+ */
+void KdbxXmlReader::setProgressCallback(std::function<bool()> callback)
+{
+    m_progressCallback = std::move(callback);
+}
+
 bool KdbxXmlReader::hasError() const
 {
     return m_error || m_xml.hasError();
@@ -189,6 +406,20 @@ QString KdbxXmlReader::errorString() const
     return QString();
 }
 
+/**
+ * @return false if reading was cancelled by the progress callback
+ */
+bool KdbxXmlReader::checkProgress()
+{
+    if (!m_cancelled && m_progressCallback && !m_progressCallback()) {
+        m_cancelled = true;
+        raiseError(tr("Reading the database was cancelled."));
+        // stops all parse loops
+        m_xml.raiseError(m_errorStr);
+    }
+    return !m_cancelled;
+}
+
 bool KdbxXmlReader::isTrueValue(const QStringRef& value)
 {
     return value.compare(QLatin1String("true"), Qt::CaseInsensitive) == 0 || value == "1";
@@ -205,6 +436,98 @@ QByteArray KdbxXmlReader::headerHash() const
     return m_headerHash;
 }
 
+/**
+ * @return tag of the current start element, Tag::Unknown for unexpected names
+ */
+KdbxXmlReader::Tag KdbxXmlReader::currentTag() const
+{
+#define KDBX_XML_TAG(name) {QLatin1String(#name), static_cast<int>(Tag::name)}
+    static const TagName names[] = {
+        KDBX_XML_TAG(Association),
+        KDBX_XML_TAG(AutoType),
+        KDBX_XML_TAG(BackgroundColor),
+        KDBX_XML_TAG(Binaries),
+        KDBX_XML_TAG(Binary),
+        KDBX_XML_TAG(Color),
+        KDBX_XML_TAG(CreationTime),
+        KDBX_XML_TAG(CustomData),
+        KDBX_XML_TAG(CustomIconUUID),
+        KDBX_XML_TAG(CustomIcons),
+        KDBX_XML_TAG(Data),
+        KDBX_XML_TAG(DataTransferObfuscation),
+        KDBX_XML_TAG(DatabaseDescription),
+        KDBX_XML_TAG(DatabaseDescriptionChanged),
+        KDBX_XML_TAG(DatabaseName),
+        KDBX_XML_TAG(DatabaseNameChanged),
+        KDBX_XML_TAG(DefaultAutoTypeSequence),
+        KDBX_XML_TAG(DefaultSequence),
+        KDBX_XML_TAG(DefaultUserName),
+        KDBX_XML_TAG(DefaultUserNameChanged),
+        KDBX_XML_TAG(DeletedObject),
+        KDBX_XML_TAG(DeletedObjects),
+        KDBX_XML_TAG(DeletionTime),
+        KDBX_XML_TAG(EnableAutoType),
+        KDBX_XML_TAG(EnableSearching),
+        KDBX_XML_TAG(Enabled),
+        KDBX_XML_TAG(Entry),
+        KDBX_XML_TAG(EntryTemplatesGroup),
+        KDBX_XML_TAG(EntryTemplatesGroupChanged),
+        KDBX_XML_TAG(Expires),
+        KDBX_XML_TAG(ExpiryTime),
+        KDBX_XML_TAG(ForegroundColor),
+        KDBX_XML_TAG(Generator),
+        KDBX_XML_TAG(Group),
+        KDBX_XML_TAG(HeaderHash),
+        KDBX_XML_TAG(History),
+        KDBX_XML_TAG(HistoryMaxItems),
+        KDBX_XML_TAG(HistoryMaxSize),
+        KDBX_XML_TAG(Icon),
+        KDBX_XML_TAG(IconID),
+        KDBX_XML_TAG(IsExpanded),
+        KDBX_XML_TAG(Item),
+        KDBX_XML_TAG(KeePassFile),
+        KDBX_XML_TAG(Key),
+        KDBX_XML_TAG(KeystrokeSequence),
+        KDBX_XML_TAG(LastAccessTime),
+        KDBX_XML_TAG(LastModificationTime),
+        KDBX_XML_TAG(LastSelectedGroup),
+        KDBX_XML_TAG(LastTopVisibleEntry),
+        KDBX_XML_TAG(LastTopVisibleGroup),
+        KDBX_XML_TAG(LocationChanged),
+        KDBX_XML_TAG(MaintenanceHistoryDays),
+        KDBX_XML_TAG(MasterKeyChangeForce),
+        KDBX_XML_TAG(MasterKeyChangeRec),
+        KDBX_XML_TAG(MasterKeyChanged),
+        KDBX_XML_TAG(MemoryProtection),
+        KDBX_XML_TAG(Meta),
+        KDBX_XML_TAG(Name),
+        KDBX_XML_TAG(Notes),
+        KDBX_XML_TAG(OverrideURL),
+        KDBX_XML_TAG(ProtectNotes),
+        KDBX_XML_TAG(ProtectPassword),
+        KDBX_XML_TAG(ProtectTitle),
+        KDBX_XML_TAG(ProtectURL),
+        KDBX_XML_TAG(ProtectUserName),
+        KDBX_XML_TAG(RecycleBinChanged),
+        KDBX_XML_TAG(RecycleBinEnabled),
+        KDBX_XML_TAG(RecycleBinUUID),
+        KDBX_XML_TAG(Root),
+        KDBX_XML_TAG(SettingsChanged),
+        KDBX_XML_TAG(String),
+        KDBX_XML_TAG(Tags),
+        KDBX_XML_TAG(Times),
+        KDBX_XML_TAG(UUID),
+        KDBX_XML_TAG(UsageCount),
+        KDBX_XML_TAG(Value),
+        KDBX_XML_TAG(Window),
+    };
+#undef KDBX_XML_TAG
+    static const TagTable table(names, sizeof(names) / sizeof(names[0]));
+
+    const int tag = table.lookup(m_xml.name());
+    return tag < 0 ? Tag::Unknown : static_cast<Tag>(tag);
+}
+
 bool KdbxXmlReader::parseKeePassFile()
 {
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "KeePassFile");
@@ -213,12 +536,11 @@ bool KdbxXmlReader::parseKeePassFile()
     bool rootParsedSuccessfully = false;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Meta") {
+        switch (currentTag()) {
+        case Tag::Meta:
             parseMeta();
-            continue;
-        }
-
-        if (m_xml.name() == "Root") {
+            break;
+        case Tag::Root:
             if (rootElementFound) {
                 rootParsedSuccessfully = false;
                 qWarning("Multiple root elements");
@@ -226,10 +548,10 @@ bool KdbxXmlReader::parseKeePassFile()
                 rootParsedSuccessfully = parseRoot();
                 rootElementFound = true;
             }
-            continue;
+            break;
+        default:
+            skipCurrentElement();
         }
-
-        skipCurrentElement();
     }
 
     return rootParsedSuccessfully;
@@ -240,71 +562,101 @@ void KdbxXmlReader::parseMeta()
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Meta");
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Generator") {
+        switch (currentTag()) {
+        case Tag::Generator:
             m_meta->setGenerator(readString());
-        } else if (m_xml.name() == "HeaderHash") {
+            break;
+        case Tag::HeaderHash:
             m_headerHash = readBinary();
-        } else if (m_xml.name() == "DatabaseName") {
+            break;
+        case Tag::DatabaseName:
             m_meta->setName(readString());
-        } else if (m_xml.name() == "DatabaseNameChanged") {
+            break;
+        case Tag::DatabaseNameChanged:
             m_meta->setNameChanged(readDateTime());
-        } else if (m_xml.name() == "DatabaseDescription") {
+            break;
+        case Tag::DatabaseDescription:
             m_meta->setDescription(readString());
-        } else if (m_xml.name() == "DatabaseDescriptionChanged") {
+            break;
+        case Tag::DatabaseDescriptionChanged:
             m_meta->setDescriptionChanged(readDateTime());
-        } else if (m_xml.name() == "DefaultUserName") {
+            break;
+        case Tag::DefaultUserName:
             m_meta->setDefaultUserName(readString());
-        } else if (m_xml.name() == "DefaultUserNameChanged") {
+            break;
+        case Tag::DefaultUserNameChanged:
             m_meta->setDefaultUserNameChanged(readDateTime());
-        } else if (m_xml.name() == "MaintenanceHistoryDays") {
+            break;
+        case Tag::MaintenanceHistoryDays:
             m_meta->setMaintenanceHistoryDays(readNumber());
-        } else if (m_xml.name() == "Color") {
+            break;
+        case Tag::Color:
             m_meta->setColor(readColor());
-        } else if (m_xml.name() == "MasterKeyChanged") {
+            break;
+        case Tag::MasterKeyChanged:
             m_meta->setMasterKeyChanged(readDateTime());
-        } else if (m_xml.name() == "MasterKeyChangeRec") {
+            break;
+        case Tag::MasterKeyChangeRec:
             m_meta->setMasterKeyChangeRec(readNumber());
-        } else if (m_xml.name() == "MasterKeyChangeForce") {
+            break;
+        case Tag::MasterKeyChangeForce:
             m_meta->setMasterKeyChangeForce(readNumber());
-        } else if (m_xml.name() == "MemoryProtection") {
+            break;
+        case Tag::MemoryProtection:
             parseMemoryProtection();
-        } else if (m_xml.name() == "CustomIcons") {
+            break;
+        case Tag::CustomIcons:
             parseCustomIcons();
-        } else if (m_xml.name() == "RecycleBinEnabled") {
+            break;
+        case Tag::RecycleBinEnabled:
             m_meta->setRecycleBinEnabled(readBool());
-        } else if (m_xml.name() == "RecycleBinUUID") {
+            break;
+        case Tag::RecycleBinUUID:
             m_meta->setRecycleBin(getGroup(readUuid()));
-        } else if (m_xml.name() == "RecycleBinChanged") {
+            break;
+        case Tag::RecycleBinChanged:
             m_meta->setRecycleBinChanged(readDateTime());
-        } else if (m_xml.name() == "EntryTemplatesGroup") {
+            break;
+        case Tag::EntryTemplatesGroup:
             m_meta->setEntryTemplatesGroup(getGroup(readUuid()));
-        } else if (m_xml.name() == "EntryTemplatesGroupChanged") {
+            break;
+        case Tag::EntryTemplatesGroupChanged:
             m_meta->setEntryTemplatesGroupChanged(readDateTime());
-        } else if (m_xml.name() == "LastSelectedGroup") {
+            break;
+        case Tag::LastSelectedGroup:
             m_meta->setLastSelectedGroup(getGroup(readUuid()));
-        } else if (m_xml.name() == "LastTopVisibleGroup") {
+            break;
+        case Tag::LastTopVisibleGroup:
             m_meta->setLastTopVisibleGroup(getGroup(readUuid()));
-        } else if (m_xml.name() == "HistoryMaxItems") {
+            break;
+        case Tag::HistoryMaxItems: {
             int value = readNumber();
             if (value >= -1) {
                 m_meta->setHistoryMaxItems(value);
             } else {
                 qWarning("HistoryMaxItems invalid number");
             }
-        } else if (m_xml.name() == "HistoryMaxSize") {
+            break;
+        }
+        case Tag::HistoryMaxSize: {
             int value = readNumber();
             if (value >= -1) {
                 m_meta->setHistoryMaxSize(value);
             } else {
                 qWarning("HistoryMaxSize invalid number");
             }
-        } else if (m_xml.name() == "Binaries") {
+            break;
+        }
+        case Tag::Binaries:
             parseBinaries();
-        } else if (m_xml.name() == "CustomData") {
+            break;
+        case Tag::CustomData:
             parseCustomData(m_meta->customData());
-        } else if (m_xml.name() == "SettingsChanged") {
+            break;
+        case Tag::SettingsChanged:
             m_meta->setSettingsChanged(readDateTime());
-        } else {
+            break;
+        default:
             skipCurrentElement();
         }
     }
@@ -315,17 +667,23 @@ void KdbxXmlReader::parseMemoryProtection()
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "MemoryProtection");
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "ProtectTitle") {
+        switch (currentTag()) {
+        case Tag::ProtectTitle:
             m_meta->setProtectTitle(readBool());
-        } else if (m_xml.name() == "ProtectUserName") {
+            break;
+        case Tag::ProtectUserName:
             m_meta->setProtectUsername(readBool());
-        } else if (m_xml.name() == "ProtectPassword") {
+            break;
+        case Tag::ProtectPassword:
             m_meta->setProtectPassword(readBool());
-        } else if (m_xml.name() == "ProtectURL") {
+            break;
+        case Tag::ProtectURL:
             m_meta->setProtectUrl(readBool());
-        } else if (m_xml.name() == "ProtectNotes") {
+            break;
+        case Tag::ProtectNotes:
             m_meta->setProtectNotes(readBool());
-        } else {
+            break;
+        default:
             skipCurrentElement();
         }
     }
@@ -336,7 +694,7 @@ void KdbxXmlReader::parseCustomIcons()
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "CustomIcons");
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Icon") {
+        if (currentTag() == Tag::Icon) {
             parseIcon();
         } else {
             skipCurrentElement();
@@ -354,13 +712,16 @@ void KdbxXmlReader::parseIcon()
     bool iconSet = false;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "UUID") {
+        switch (currentTag()) {
+        case Tag::UUID:
             uuid = readUuid();
             uuidSet = !uuid.isNull();
-        } else if (m_xml.name() == "Data") {
+            break;
+        case Tag::Data:
             icon.loadFromData(readBinary());
             iconSet = true;
-        } else {
+            break;
+        default:
             skipCurrentElement();
         }
     }
@@ -378,7 +739,7 @@ void KdbxXmlReader::parseBinaries()
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Binaries");
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() != "Binary") {
+        if (currentTag() != Tag::Binary) {
             skipCurrentElement();
             continue;
         }
@@ -400,7 +761,7 @@ void KdbxXmlReader::parseCustomData(CustomData* customData)
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "CustomData");
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Item") {
+        if (currentTag() == Tag::Item) {
             parseCustomDataItem(customData);
             continue;
         }
@@ -418,13 +779,16 @@ void KdbxXmlReader::parseCustomDataItem(CustomData* customData)
     bool valueSet = false;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Key") {
+        switch (currentTag()) {
+        case Tag::Key:
             key = readString();
             keySet = true;
-        } else if (m_xml.name() == "Value") {
+            break;
+        case Tag::Value:
             value = readString();
             valueSet = true;
-        } else {
+            break;
+        default:
             skipCurrentElement();
         }
     }
@@ -445,7 +809,8 @@ bool KdbxXmlReader::parseRoot()
     bool groupParsedSuccessfully = false;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Group") {
+        switch (currentTag()) {
+        case Tag::Group: {
             if (groupElementFound) {
                 groupParsedSuccessfully = false;
                 raiseError(tr("Multiple group elements"));
@@ -461,9 +826,12 @@ bool KdbxXmlReader::parseRoot()
             }
 
             groupElementFound = true;
-        } else if (m_xml.name() == "DeletedObjects") {
+            break;
+        }
+        case Tag::DeletedObjects:
             parseDeletedObjects();
-        } else {
+            break;
+        default:
             skipCurrentElement();
         }
     }
@@ -475,12 +843,15 @@ Group* KdbxXmlReader::parseGroup()
 {
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Group");
 
+    checkProgress();
+
     auto group = new Group();
     group->setUpdateTimeinfo(false);
     QList<Group*> children;
     QList<Entry*> entries;
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "UUID") {
+        switch (currentTag()) {
+        case Tag::UUID: {
             QUuid uuid = readUuid();
             if (uuid.isNull()) {
                 if (m_strictMode) {
@@ -491,17 +862,15 @@ Group* KdbxXmlReader::parseGroup()
             } else {
                 group->setUuid(uuid);
             }
-            continue;
+            break;
         }
-        if (m_xml.name() == "Name") {
+        case Tag::Name:
             group->setName(readString());
-            continue;
-        }
-        if (m_xml.name() == "Notes") {
+            break;
+        case Tag::Notes:
             group->setNotes(readString());
-            continue;
-        }
-        if (m_xml.name() == "IconID") {
+            break;
+        case Tag::IconID: {
             int iconId = readNumber();
             if (iconId < 0) {
                 if (m_strictMode) {
@@ -514,28 +883,25 @@ Group* KdbxXmlReader::parseGroup()
             }
 
             group->setIcon(iconId);
-            continue;
+            break;
         }
-        if (m_xml.name() == "CustomIconUUID") {
+        case Tag::CustomIconUUID: {
             QUuid uuid = readUuid();
             if (!uuid.isNull()) {
                 group->setIcon(uuid);
             }
-            continue;
+            break;
         }
-        if (m_xml.name() == "Times") {
+        case Tag::Times:
             group->setTimeInfo(parseTimes());
-            continue;
-        }
-        if (m_xml.name() == "IsExpanded") {
+            break;
+        case Tag::IsExpanded:
             group->setExpanded(readBool());
-            continue;
-        }
-        if (m_xml.name() == "DefaultAutoTypeSequence") {
+            break;
+        case Tag::DefaultAutoTypeSequence:
             group->setDefaultAutoTypeSequence(readString());
-            continue;
-        }
-        if (m_xml.name() == "EnableAutoType") {
+            break;
+        case Tag::EnableAutoType: {
             QString str = readString();
 
             if (str.compare("null", Qt::CaseInsensitive) == 0) {
@@ -547,9 +913,9 @@ Group* KdbxXmlReader::parseGroup()
             } else {
                 raiseError(tr("Invalid EnableAutoType value"));
             }
-            continue;
+            break;
         }
-        if (m_xml.name() == "EnableSearching") {
+        case Tag::EnableSearching: {
             QString str = readString();
 
             if (str.compare("null", Qt::CaseInsensitive) == 0) {
@@ -561,32 +927,31 @@ Group* KdbxXmlReader::parseGroup()
             } else {
                 raiseError(tr("Invalid EnableSearching value"));
             }
-            continue;
+            break;
         }
-        if (m_xml.name() == "LastTopVisibleEntry") {
+        case Tag::LastTopVisibleEntry:
             group->setLastTopVisibleEntry(getEntry(readUuid()));
-            continue;
-        }
-        if (m_xml.name() == "Group") {
+            break;
+        case Tag::Group: {
             Group* newGroup = parseGroup();
             if (newGroup) {
                 children.append(newGroup);
             }
-            continue;
+            break;
         }
-        if (m_xml.name() == "Entry") {
+        case Tag::Entry: {
             Entry* newEntry = parseEntry(false);
             if (newEntry) {
                 entries.append(newEntry);
             }
-            continue;
+            break;
         }
-        if (m_xml.name() == "CustomData") {
+        case Tag::CustomData:
             parseCustomData(group->customData());
-            continue;
+            break;
+        default:
+            skipCurrentElement();
         }
-
-        skipCurrentElement();
     }
 
     if (group->uuid().isNull() && !m_strictMode) {
@@ -619,7 +984,7 @@ void KdbxXmlReader::parseDeletedObjects()
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "DeletedObjects");
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "DeletedObject") {
+        if (currentTag() == Tag::DeletedObject) {
             parseDeletedObject();
         } else {
             skipCurrentElement();
@@ -634,7 +999,8 @@ void KdbxXmlReader::parseDeletedObject()
     DeletedObject delObj{{}, {}};
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "UUID") {
+        switch (currentTag()) {
+        case Tag::UUID: {
             QUuid uuid = readUuid();
             if (uuid.isNull()) {
                 if (m_strictMode) {
@@ -644,13 +1010,14 @@ void KdbxXmlReader::parseDeletedObject()
                 continue;
             }
             delObj.uuid = uuid;
-            continue;
+            break;
         }
-        if (m_xml.name() == "DeletionTime") {
+        case Tag::DeletionTime:
             delObj.deletionTime = readDateTime();
-            continue;
+            break;
+        default:
+            skipCurrentElement();
         }
-        skipCurrentElement();
     }
 
     if (!delObj.uuid.isNull() && !delObj.deletionTime.isNull()) {
@@ -667,13 +1034,18 @@ Entry* KdbxXmlReader::parseEntry(bool history)
 {
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Entry");
 
+    if (!history) {
+        checkProgress();
+    }
+
     auto entry = new Entry();
     entry->setUpdateTimeinfo(false);
     QList<Entry*> historyItems;
     QList<StringPair> binaryRefs;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "UUID") {
+        switch (currentTag()) {
+        case Tag::UUID: {
             QUuid uuid = readUuid();
             if (uuid.isNull()) {
                 if (m_strictMode) {
@@ -684,9 +1056,9 @@ Entry* KdbxXmlReader::parseEntry(bool history)
             } else {
                 entry->setUuid(uuid);
             }
-            continue;
+            break;
         }
-        if (m_xml.name() == "IconID") {
+        case Tag::IconID: {
             int iconId = readNumber();
             if (iconId < 0) {
                 if (m_strictMode) {
@@ -695,63 +1067,56 @@ Entry* KdbxXmlReader::parseEntry(bool history)
                 iconId = 0;
             }
             entry->setIcon(iconId);
-            continue;
+            break;
         }
-        if (m_xml.name() == "CustomIconUUID") {
+        case Tag::CustomIconUUID: {
             QUuid uuid = readUuid();
             if (!uuid.isNull()) {
                 entry->setIcon(uuid);
             }
-            continue;
+            break;
         }
-        if (m_xml.name() == "ForegroundColor") {
+        case Tag::ForegroundColor:
             entry->setForegroundColor(readColor());
-            continue;
-        }
-        if (m_xml.name() == "BackgroundColor") {
+            break;
+        case Tag::BackgroundColor:
             entry->setBackgroundColor(readColor());
-            continue;
-        }
-        if (m_xml.name() == "OverrideURL") {
+            break;
+        case Tag::OverrideURL:
             entry->setOverrideUrl(readString());
-            continue;
-        }
-        if (m_xml.name() == "Tags") {
+            break;
+        case Tag::Tags:
             entry->setTags(readString());
-            continue;
-        }
-        if (m_xml.name() == "Times") {
+            break;
+        case Tag::Times:
             entry->setTimeInfo(parseTimes());
-            continue;
-        }
-        if (m_xml.name() == "String") {
+            break;
+        case Tag::String:
             parseEntryString(entry);
-            continue;
-        }
-        if (m_xml.name() == "Binary") {
+            break;
+        case Tag::Binary: {
             QPair<QString, QString> ref = parseEntryBinary(entry);
             if (!ref.first.isNull() && !ref.second.isNull()) {
                 binaryRefs.append(ref);
             }
-            continue;
+            break;
         }
-        if (m_xml.name() == "AutoType") {
+        case Tag::AutoType:
             parseAutoType(entry);
-            continue;
-        }
-        if (m_xml.name() == "History") {
+            break;
+        case Tag::History:
             if (history) {
                 raiseError(tr("History element in history entry"));
             } else {
                 historyItems = parseEntryHistory();
             }
-            continue;
-        }
-        if (m_xml.name() == "CustomData") {
+            break;
+        case Tag::CustomData:
             parseCustomData(entry->customData());
-            continue;
+            break;
+        default:
+            skipCurrentElement();
         }
-        skipCurrentElement();
     }
 
     if (entry->uuid().isNull() && !m_strictMode) {
@@ -803,23 +1168,23 @@ void KdbxXmlReader::parseEntryString(Entry* entry)
     bool valueSet = false;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Key") {
+        switch (currentTag()) {
+        case Tag::Key:
             key = readString();
             keySet = true;
-            continue;
-        }
-
-        if (m_xml.name() == "Value") {
+            break;
+        case Tag::Value: {
             QXmlStreamAttributes attr = m_xml.attributes();
             bool isProtected;
             bool protectInMemory;
             value = readString(isProtected, protectInMemory);
             protect = isProtected || protectInMemory;
             valueSet = true;
-            continue;
+            break;
+        }
+        default:
+            skipCurrentElement();
         }
-
-        skipCurrentElement();
     }
 
     if (keySet && valueSet) {
@@ -847,12 +1212,12 @@ QPair<QString, QString> KdbxXmlReader::parseEntryBinary(Entry* entry)
     bool valueSet = false;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Key") {
+        switch (currentTag()) {
+        case Tag::Key:
             key = readString();
             keySet = true;
-            continue;
-        }
-        if (m_xml.name() == "Value") {
+            break;
+        case Tag::Value: {
             QXmlStreamAttributes attr = m_xml.attributes();
 
             if (attr.hasAttribute("Ref")) {
@@ -864,9 +1229,11 @@ QPair<QString, QString> KdbxXmlReader::parseEntryBinary(Entry* entry)
             }
 
             valueSet = true;
-            continue;
+            break;
+        }
+        default:
+            skipCurrentElement();
         }
-        skipCurrentElement();
     }
 
     if (keySet && valueSet) {
@@ -887,15 +1254,20 @@ void KdbxXmlReader::parseAutoType(Entry* entry)
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "AutoType");
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Enabled") {
+        switch (currentTag()) {
+        case Tag::Enabled:
             entry->setAutoTypeEnabled(readBool());
-        } else if (m_xml.name() == "DataTransferObfuscation") {
+            break;
+        case Tag::DataTransferObfuscation:
             entry->setAutoTypeObfuscation(readNumber());
-        } else if (m_xml.name() == "DefaultSequence") {
+            break;
+        case Tag::DefaultSequence:
             entry->setDefaultAutoTypeSequence(readString());
-        } else if (m_xml.name() == "Association") {
+            break;
+        case Tag::Association:
             parseAutoTypeAssoc(entry);
-        } else {
+            break;
+        default:
             skipCurrentElement();
         }
     }
@@ -910,13 +1282,16 @@ void KdbxXmlReader::parseAutoTypeAssoc(Entry* entry)
     bool sequenceSet = false;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Window") {
+        switch (currentTag()) {
+        case Tag::Window:
             assoc.window = readString();
             windowSet = true;
-        } else if (m_xml.name() == "KeystrokeSequence") {
+            break;
+        case Tag::KeystrokeSequence:
             assoc.sequence = readString();
             sequenceSet = true;
-        } else {
+            break;
+        default:
             skipCurrentElement();
         }
     }
@@ -935,7 +1310,7 @@ QList<Entry*> KdbxXmlReader::parseEntryHistory()
     QList<Entry*> historyItems;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "Entry") {
+        if (currentTag() == Tag::Entry) {
             historyItems.append(parseEntry(true));
         } else {
             skipCurrentElement();
@@ -951,21 +1326,29 @@ TimeInfo KdbxXmlReader::parseTimes()
 
     TimeInfo timeInfo;
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
-        if (m_xml.name() == "LastModificationTime") {
+        switch (currentTag()) {
+        case Tag::LastModificationTime:
             timeInfo.setLastModificationTime(readDateTime());
-        } else if (m_xml.name() == "CreationTime") {
+            break;
+        case Tag::CreationTime:
             timeInfo.setCreationTime(readDateTime());
-        } else if (m_xml.name() == "LastAccessTime") {
+            break;
+        case Tag::LastAccessTime:
             timeInfo.setLastAccessTime(readDateTime());
-        } else if (m_xml.name() == "ExpiryTime") {
+            break;
+        case Tag::ExpiryTime:
             timeInfo.setExpiryTime(readDateTime());
-        } else if (m_xml.name() == "Expires") {
+            break;
+        case Tag::Expires:
             timeInfo.setExpires(readBool());
-        } else if (m_xml.name() == "UsageCount") {
+            break;
+        case Tag::UsageCount:
             timeInfo.setUsageCount(readNumber());
-        } else if (m_xml.name() == "LocationChanged") {
+            break;
+        case Tag::LocationChanged:
             timeInfo.setLocationChanged(readDateTime());
-        } else {
+            break;
+        default:
             skipCurrentElement();
         }
     }
@@ -989,7 +1372,7 @@ QString KdbxXmlReader::readString(bool& isProtected, bool& protectInMemory)
     QString value = m_xml.readElementText();
 
     if (isProtected && !value.isEmpty()) {
-        QByteArray ciphertext = QByteArray::fromBase64(value.toLatin1());
+        QByteArray ciphertext = Base64::decode(value);
         bool ok;
         QByteArray plaintext = m_randomStream->process(ciphertext, &ok);
         if (!ok) {
@@ -1023,16 +1406,25 @@ bool KdbxXmlReader::readBool()
 
 QDateTime KdbxXmlReader::readDateTime()
 {
-    static QRegularExpression b64regex("^(?:[A-Za-z0-9+/]{4})*(?:[A-Za-z0-9+/]{2}==|[A-Za-z0-9+/]{3}=)?$");
     QString str = readString();
 
-    if (b64regex.match(str).hasMatch()) {
-        QByteArray secsBytes = QByteArray::fromBase64(str.toUtf8()).leftJustified(8, '\0', true).left(8);
-        qint64 secs = Endian::bytesToSizedInt<quint64>(secsBytes, KeePass2::BYTEORDER);
-        return QDateTime(QDate(1, 1, 1), QTime(0, 0, 0, 0), Qt::UTC).addSecs(secs);
+    qint64 secs;
+    if (parseBase64Seconds(str, secs)) {
+        if (secs < 0 || secs > KdbxMaxSeconds) {
+            if (m_strictMode) {
+                raiseError(tr("Invalid date time value"));
+            }
+            return QDateTime::currentDateTimeUtc();
+        }
+        return QDateTime::fromMSecsSinceEpoch((secs - KdbxEpochOffset) * 1000, Qt::UTC);
+    }
+
+    QDateTime dt;
+    if (parseIsoUtc(str, dt)) {
+        return dt;
     }
 
-    QDateTime dt = QDateTime::fromString(str, Qt::ISODate);
+    dt = QDateTime::fromString(str, Qt::ISODate);
     if (dt.isValid()) {
         return dt;
     }
@@ -1113,7 +1505,7 @@ QByteArray KdbxXmlReader::readBinary()
     QXmlStreamAttributes attr = m_xml.attributes();
     bool isProtected = isTrueValue(attr.value("Protected"));
     QString value = m_xml.readElementText();
-    QByteArray data = QByteArray::fromBase64(value.toLatin1());
+    QByteArray data = Base64::decode(value);
 
     if (isProtected && !data.isEmpty()) {
         bool ok;
@@ -28,6 +28,8 @@
 #include <QString>
 #include <QXmlStreamReader>
 
+#include <functional>
+
 class QIODevice;
 class Group;
 class Entry;
@@ -56,10 +58,98 @@ public:
 
     bool strictMode() const;
     void setStrictMode(bool strictMode);
+    void setProgressCallback(std::function<bool()> callback);
 
 protected:
     typedef QPair<QString, QString> StringPair;
 
+    /**
+     * Elements known to the parser, looked up once per start element.
+     */
+    enum class Tag : quint8
+    {
+        Unknown,
+        Association,
+        AutoType,
+        BackgroundColor,
+        Binaries,
+        Binary,
+        Color,
+        CreationTime,
+        CustomData,
+        CustomIconUUID,
+        CustomIcons,
+        Data,
+        DataTransferObfuscation,
+        DatabaseDescription,
+        DatabaseDescriptionChanged,
+        DatabaseName,
+        DatabaseNameChanged,
+        DefaultAutoTypeSequence,
+        DefaultSequence,
+        DefaultUserName,
+        DefaultUserNameChanged,
+        DeletedObject,
+        DeletedObjects,
+        DeletionTime,
+        EnableAutoType,
+        EnableSearching,
+        Enabled,
+        Entry,
+        EntryTemplatesGroup,
+        EntryTemplatesGroupChanged,
+        Expires,
+        ExpiryTime,
+        ForegroundColor,
+        Generator,
+        Group,
+        HeaderHash,
+        History,
+        HistoryMaxItems,
+        HistoryMaxSize,
+        Icon,
+        IconID,
+        IsExpanded,
+        Item,
+        KeePassFile,
+        Key,
+        KeystrokeSequence,
+        LastAccessTime,
+        LastModificationTime,
+        LastSelectedGroup,
+        LastTopVisibleEntry,
+        LastTopVisibleGroup,
+        LocationChanged,
+        MaintenanceHistoryDays,
+        MasterKeyChangeForce,
+        MasterKeyChangeRec,
+        MasterKeyChanged,
+        MemoryProtection,
+        Meta,
+        Name,
+        Notes,
+        OverrideURL,
+        ProtectNotes,
+        ProtectPassword,
+        ProtectTitle,
+        ProtectURL,
+        ProtectUserName,
+        RecycleBinChanged,
+        RecycleBinEnabled,
+        RecycleBinUUID,
+        Root,
+        SettingsChanged,
+        String,
+        Tags,
+        Times,
+        UUID,
+        UsageCount,
+        Value,
+        Window
+    };
+
+    Tag currentTag() const;
+
     virtual bool parseKeePassFile();
     virtual void parseMeta();
     virtual void parseMemoryProtection();
@@ -95,12 +185,15 @@ protected:
     virtual Group* getGroup(const QUuid& uuid);
     virtual Entry* getEntry(const QUuid& uuid);
 
+    virtual bool checkProgress();
     virtual bool isTrueValue(const QStringRef& value);
     virtual void raiseError(const QString& errorMessage);
 
     const quint32 m_kdbxVersion;
 
     bool m_strictMode = false;
+    std::function<bool()> m_progressCallback;
+    bool m_cancelled = false;
 
     QPointer<Database> m_db;
     QPointer<Metadata> m_meta;
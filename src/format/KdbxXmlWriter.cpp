@@ -19,11 +19,50 @@
 
 #include <QBuffer>
 #include <QFile>
+#include <QtEndian>
 
-#include "core/Endian.h"
+#include "core/Base64.h"
 #include "core/Metadata.h"
+#include "core/Trace.h"
 #include "format/KeePass2RandomStream.h"
-#include "streams/QtIOCompressor"
+#include "streams/ParallelGzipStream.h"
+
+namespace
+{
+    // Seconds from 0001-01-01T00:00:00Z, the KDBX 4 time base, to the Unix epoch
+    const qint64 KdbxEpochOffset = Q_INT64_C(62135596800);
+
+    inline void putDigits(QChar* data, int count, int value)
+    {
+        for (int i = count - 1; i >= 0; --i) {
+            data[i] = QLatin1Char(static_cast<char>('0' + value % 10));
+            value /= 10;
+        }
+    }
+
+    /**
+     * Formats "yyyy-MM-ddTHH:mm:ssZ" in place, the same text
+     * QDateTime::toString(Qt::ISODate) gives for UTC times in years 1 to 9999.
+     */
+    QString formatIsoUtc(const QDate& date, const QTime& time)
+    {
+        QString str(20, Qt::Uninitialized);
+        QChar* data = str.data();
+        putDigits(data, 4, date.year());
+        data[4] = QLatin1Char('-');
+        putDigits(data + 5, 2, date.month());
+        data[7] = QLatin1Char('-');
+        putDigits(data + 8, 2, date.day());
+        data[10] = QLatin1Char('T');
+        putDigits(data + 11, 2, time.hour());
+        data[13] = QLatin1Char(':');
+        putDigits(data + 14, 2, time.minute());
+        data[16] = QLatin1Char(':');
+        putDigits(data + 17, 2, time.second());
+        data[19] = QLatin1Char('Z');
+        return str;
+    }
+} // namespace
 
 /**
  * @param version KDBX version
@@ -38,6 +77,8 @@ void KdbxXmlWriter::writeDatabase(QIODevice* device,
                                   KeePass2RandomStream* randomStream,
                                   const QByteArray& headerHash)
 {
+    TRACE_SPAN("format", "KdbxXmlWriter::writeDatabase");
+
     m_db = db;
     m_meta = db->metadata();
     m_randomStream = randomStream;
@@ -196,8 +237,7 @@ void KdbxXmlWriter::writeBinaries()
             QBuffer buffer;
             buffer.open(QIODevice::ReadWrite);
 
-            QtIOCompressor compressor(&buffer);
-            compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+            ParallelGzipStream compressor(&buffer, m_db->compressionLevel());
             compressor.open(QIODevice::WriteOnly);
 
             qint64 bytesWritten = compressor.write(i.key());
@@ -212,7 +252,7 @@ void KdbxXmlWriter::writeBinaries()
         }
 
         if (!data.isEmpty()) {
-            m_xml.writeCharacters(QString::fromLatin1(data.toBase64()));
+            m_xml.writeCharacters(Base64::encodeToString(data));
         }
         m_xml.writeEndElement();
     }
@@ -376,7 +416,7 @@ void KdbxXmlWriter::writeEntry(const Entry* entry)
                 if (!ok) {
                     raiseError(m_randomStream->errorString());
                 }
-                value = QString::fromLatin1(rawData.toBase64());
+                value = Base64::encodeToString(rawData);
             } else {
                 m_xml.writeAttribute("ProtectInMemory", "True");
                 value = entry->attributes()->value(key);
@@ -488,23 +528,31 @@ void KdbxXmlWriter::writeDateTime(const QString& qualifiedName, const QDateTime&
 
     QString dateTimeStr;
     if (m_kdbxVersion < KeePass2::FILE_VERSION_4) {
-        dateTimeStr = dateTime.toString(Qt::ISODate);
+        const QDate date = dateTime.date();
+        if (date.year() >= 1 && date.year() <= 9999) {
+            dateTimeStr = formatIsoUtc(date, dateTime.time());
+        } else {
+            dateTimeStr = dateTime.toString(Qt::ISODate);
 
-        // Qt < 4.8 doesn't append a 'Z' at the end
-        if (!dateTimeStr.isEmpty() && dateTimeStr[dateTimeStr.size() - 1] != 'Z') {
-            dateTimeStr.append('Z');
+            // Qt < 4.8 doesn't append a 'Z' at the end
+            if (!dateTimeStr.isEmpty() && dateTimeStr[dateTimeStr.size() - 1] != 'Z') {
+                dateTimeStr.append('Z');
+            }
         }
     } else {
-        qint64 secs = QDateTime(QDate(1, 1, 1), QTime(0, 0, 0, 0), Qt::UTC).secsTo(dateTime);
-        QByteArray secsBytes = Endian::sizedIntToBytes(secs, KeePass2::BYTEORDER);
-        dateTimeStr = QString::fromLatin1(secsBytes.toBase64());
+        // same rounding as secsTo() from 0001-01-01
+        const qint64 secs = (dateTime.toMSecsSinceEpoch() + KdbxEpochOffset * 1000) / 1000;
+        uchar secsBytes[8];
+        qToLittleEndian<qint64>(secs, secsBytes);
+        dateTimeStr = Base64::encodeToString(
+            QByteArray::fromRawData(reinterpret_cast<const char*>(secsBytes), sizeof(secsBytes)));
     }
     writeString(qualifiedName, dateTimeStr);
 }
 
 void KdbxXmlWriter::writeUuid(const QString& qualifiedName, const QUuid& uuid)
 {
-    writeString(qualifiedName, uuid.toRfc4122().toBase64());
+    writeString(qualifiedName, Base64::encodeToString(uuid.toRfc4122()));
 }
 
 void KdbxXmlWriter::writeUuid(const QString& qualifiedName, const Group* group)
@@ -527,7 +575,7 @@ void KdbxXmlWriter::writeUuid(const QString& qualifiedName, const Entry* entry)
 
 void KdbxXmlWriter::writeBinary(const QString& qualifiedName, const QByteArray& ba)
 {
-    writeString(qualifiedName, QString::fromLatin1(ba.toBase64()));
+    writeString(qualifiedName, Base64::encodeToString(ba));
 }
 
 void KdbxXmlWriter::writeColor(const QString& qualifiedName, const QColor& color)
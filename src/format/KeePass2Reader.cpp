@@ -16,6 +16,7 @@
  */
 
 #include "format/KeePass2Reader.h"
+#include "core/Trace.h"
 #include "format/Kdbx3Reader.h"
 #include "format/Kdbx4Reader.h"
 #include "format/KeePass1.h"
@@ -57,6 +58,8 @@ Database* KeePass2Reader::readDatabase(const QString& filename, const CompositeK
  */
 Database* KeePass2Reader::readDatabase(QIODevice* device, const CompositeKey& key, bool keepDatabase)
 {
+    TRACE_SPAN("format", "KeePass2Reader::readDatabase");
+
     m_error = false;
     m_errorStr.clear();
 
@@ -93,6 +96,7 @@ Database* KeePass2Reader::readDatabase(QIODevice* device, const CompositeKey& ke
     }
 
     m_reader->setSaveXml(m_saveXml);
+    m_reader->setProgressObserver(m_progressObserver);
     return m_reader->readDatabase(device, key, keepDatabase);
 }
 
@@ -116,6 +120,14 @@ void KeePass2Reader::setSaveXml(bool save)
     m_saveXml = save;
 }
 
+/**
+ * @param observer observer of the read progress, called from the reading thread
+ */
+void KeePass2Reader::setProgressObserver(KdbxReader::ProgressObserver* observer)
+{
+    m_progressObserver = observer;
+}
+
 /**
  * @return detected KDBX version
  */
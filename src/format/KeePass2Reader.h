@@ -43,6 +43,7 @@ public:
 
     bool saveXml() const;
     void setSaveXml(bool save);
+    void setProgressObserver(KdbxReader::ProgressObserver* observer);
 
     QSharedPointer<KdbxReader> reader() const;
     quint32 version() const;
@@ -51,6 +52,7 @@ private:
     void raiseError(const QString& errorMessage);
 
     bool m_saveXml = false;
+    KdbxReader::ProgressObserver* m_progressObserver = nullptr;
     bool m_error = false;
     QString m_errorStr = "";
 
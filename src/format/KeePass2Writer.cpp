@@ -21,6 +21,7 @@
 #include "core/Database.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
+#include "core/Trace.h"
 #include "crypto/kdf/AesKdf.h"
 #include "format/Kdbx3Writer.h"
 #include "format/Kdbx4Writer.h"
@@ -82,19 +83,54 @@ bool KeePass2Writer::implicitUpgradeNeeded(Database const* db) const
  */
 
 bool KeePass2Writer::writeDatabase(QIODevice* device, Database* db)
+{
+    return prepareDatabase(db) && writePreparedDatabase(device, db);
+}
+
+/**
+ * Apply the changes writing makes to the database itself: an implicit
+ * upgrade to KDBX 4 and a new KDF seed with the transformed key.
+ *
+ * @param db database to be written
+ * @return true on success
+ */
+bool KeePass2Writer::prepareDatabase(Database* db)
 {
     m_error = false;
     m_errorStr.clear();
+    m_writer.reset();
 
-    bool upgradeNeeded = implicitUpgradeNeeded(db);
-    if (upgradeNeeded) {
+    if (implicitUpgradeNeeded(db)) {
         // We MUST re-transform the key, because challenge-response hashing has changed in KDBX 4.
         // If we forget to re-transform, the database will be saved WITHOUT a challenge-response key component!
         db->changeKdf(KeePass2::uuidToKdf(KeePass2::KDF_AES_KDBX4));
     }
 
+    if (!db->setKey(db->key(), false, true)) {
+        raiseError(tr("Unable to calculate master key"));
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Write a database prepared by prepareDatabase() to a device in KDBX
+ * format, without changing its key.
+ *
+ * @param device output device
+ * @param db source database
+ * @return true on success
+ */
+bool KeePass2Writer::writePreparedDatabase(QIODevice* device, Database* db)
+{
+    TRACE_SPAN("format", "KeePass2Writer::writeDatabase");
+
+    m_error = false;
+    m_errorStr.clear();
+
     if (db->kdf()->uuid() == KeePass2::KDF_AES_KDBX3) {
-        Q_ASSERT(!upgradeNeeded);
+        Q_ASSERT(!implicitUpgradeNeeded(db));
         m_version = KeePass2::FILE_VERSION_3_1;
         m_writer.reset(new Kdbx3Writer());
     } else {
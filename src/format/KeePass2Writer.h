@@ -33,6 +33,8 @@ class KeePass2Writer
 public:
     bool writeDatabase(const QString& filename, Database* db);
     bool writeDatabase(QIODevice* device, Database* db);
+    bool prepareDatabase(Database* db);
+    bool writePreparedDatabase(QIODevice* device, Database* db);
 
     QSharedPointer<KdbxWriter> writer() const;
     quint32 version() const;
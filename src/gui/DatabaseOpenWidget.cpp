@@ -22,6 +22,7 @@
 #include "core/Config.h"
 #include "core/Database.h"
 #include "core/FilePath.h"
+#include "core/Group.h"
 #include "crypto/Random.h"
 #include "format/KeePass2Reader.h"
 #include "gui/FileDialog.h"
@@ -33,17 +34,63 @@
 
 #include "config-keepassx.h"
 
+#include <QPushButton>
 #include <QSharedPointer>
+#include <QThread>
+#include <QTimer>
 #include <QtConcurrentRun>
 
+/**
+ * Progress of an unlock, written by the reading thread and polled by the widget.
+ */
+class DatabaseOpenWidget::UnlockProgress : public KdbxReader::ProgressObserver
+{
+public:
+    bool readProgress(Stage stage, int percent) override
+    {
+        m_stage.store(stage);
+        m_percent.store(percent);
+        return !isCancelled();
+    }
+
+    Stage stage() const
+    {
+        return static_cast<Stage>(m_stage.load());
+    }
+
+    int percent() const
+    {
+        return m_percent.load();
+    }
+
+    void cancel()
+    {
+        m_cancelled.store(1);
+    }
+
+    bool isCancelled() const
+    {
+        return m_cancelled.load() != 0;
+    }
+
+private:
+    QAtomicInt m_stage{KeyTransformation};
+    QAtomicInt m_percent{-1};
+    QAtomicInt m_cancelled{0};
+};
+
 DatabaseOpenWidget::DatabaseOpenWidget(QWidget* parent)
     : DialogyWidget(parent)
     , m_ui(new Ui::DatabaseOpenWidget())
     , m_db(nullptr)
+    , m_unlockProgressTimer(new QTimer(this))
 {
     m_ui->setupUi(this);
 
     m_ui->messageWidget->setHidden(true);
+    m_ui->unlockProgress->setVisible(false);
+    m_unlockProgressTimer->setInterval(100);
+    connect(m_unlockProgressTimer, SIGNAL(timeout()), SLOT(updateUnlockProgress()));
     m_ui->checkPassword->setChecked(true);
 
     QFont font = m_ui->labelHeadline->font();
@@ -86,6 +133,7 @@ DatabaseOpenWidget::DatabaseOpenWidget(QWidget* parent)
 
 DatabaseOpenWidget::~DatabaseOpenWidget()
 {
+    abandonUnlock();
 }
 
 void DatabaseOpenWidget::showEvent(QShowEvent* event)
@@ -143,6 +191,7 @@ void DatabaseOpenWidget::clearForms()
     m_ui->checkKeyFile->setChecked(false);
     m_ui->checkChallengeResponse->setChecked(false);
     m_ui->buttonTogglePassword->setChecked(false);
+    abandonUnlock();
     m_db = nullptr;
 }
 
@@ -165,37 +214,150 @@ void DatabaseOpenWidget::enterKey(const QString& pw, const QString& keyFile)
 
 void DatabaseOpenWidget::openDatabase()
 {
-    KeePass2Reader reader;
+    if (m_unlockWatcher) {
+        return;
+    }
+
     QSharedPointer<CompositeKey> masterKey = databaseKey();
     if (masterKey.isNull()) {
         return;
     }
 
     m_ui->editPassword->setShowPassword(false);
-    QCoreApplication::processEvents();
 
-    QFile file(m_filename);
-    if (!file.open(QIODevice::ReadOnly)) {
-        m_ui->messageWidget->showMessage(tr("Unable to open the database.").append("\n").append(file.errorString()),
-                                         MessageWidget::Error);
-        return;
-    }
     if (m_db) {
         delete m_db;
+        m_db = nullptr;
     }
-    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-    m_db = reader.readDatabase(&file, *masterKey);
-    QApplication::restoreOverrideCursor();
 
+    // The key transformation can take several seconds, read the database
+    // in a worker thread so the window stays responsive meanwhile
+    m_unlockProgress.reset(new UnlockProgress());
+    m_unlockWatcher = new QFutureWatcher<UnlockResult>(this);
+    connect(m_unlockWatcher, SIGNAL(finished()), SLOT(unlockFinished()));
+    m_unlockWatcher->setFuture(
+        QtConcurrent::run(&DatabaseOpenWidget::readDatabaseFile, m_filename, masterKey, m_unlockProgress, thread()));
+    setUnlocking(true);
+}
+
+DatabaseOpenWidget::UnlockResult DatabaseOpenWidget::readDatabaseFile(const QString& filename,
+                                                                      QSharedPointer<CompositeKey> key,
+                                                                      QSharedPointer<UnlockProgress> progress,
+                                                                      QThread* targetThread)
+{
+    KeePass2Reader reader;
+    reader.setProgressObserver(progress.data());
+    Database* db = reader.readDatabase(filename, *key);
+
+    if (db && progress->isCancelled()) {
+        delete db;
+        db = nullptr;
+    }
+    if (db) {
+        db->moveToThread(targetThread);
+        // history items have no parent object, so they don't move along
+        const QList<Entry*> entries = db->rootGroup()->entriesRecursive(true);
+        for (Entry* entry : entries) {
+            if (!entry->parent()) {
+                entry->moveToThread(targetThread);
+            }
+        }
+    }
+
+    return {db, reader.errorString()};
+}
+
+void DatabaseOpenWidget::unlockFinished()
+{
+    UnlockResult result = m_unlockWatcher->result();
+    m_unlockWatcher->deleteLater();
+    m_unlockWatcher = nullptr;
+    m_unlockProgress.reset();
+    setUnlocking(false);
+
+    m_db = result.db;
     if (m_db) {
         if (m_ui->messageWidget->isVisible()) {
             m_ui->messageWidget->animatedHide();
         }
         emit editFinished(true);
     } else {
-        m_ui->messageWidget->showMessage(tr("Unable to open the database.").append("\n").append(reader.errorString()),
+        m_ui->messageWidget->showMessage(tr("Unable to open the database.").append("\n").append(result.errorString),
                                          MessageWidget::Error);
         m_ui->editPassword->clear();
+        m_ui->editPassword->setFocus();
+    }
+}
+
+/**
+ * Stop waiting for a running unlock. The worker stops at its next progress
+ * report and a database it still returns is deleted.
+ */
+void DatabaseOpenWidget::abandonUnlock()
+{
+    if (!m_unlockWatcher) {
+        return;
+    }
+
+    m_unlockProgress->cancel();
+    m_unlockProgress.reset();
+
+    QFutureWatcher<UnlockResult>* watcher = m_unlockWatcher;
+    m_unlockWatcher = nullptr;
+    watcher->disconnect(this);
+    watcher->setParent(nullptr);
+    connect(watcher, &QFutureWatcher<UnlockResult>::finished, watcher, [watcher]() {
+        delete watcher->result().db;
+        watcher->deleteLater();
+    });
+
+    setUnlocking(false);
+}
+
+void DatabaseOpenWidget::setUnlocking(bool unlocking)
+{
+    m_ui->checkPassword->setEnabled(!unlocking);
+    m_ui->editPassword->setEnabled(!unlocking);
+    m_ui->buttonTogglePassword->setEnabled(!unlocking);
+    m_ui->checkKeyFile->setEnabled(!unlocking);
+    m_ui->comboKeyFile->setEnabled(!unlocking);
+    m_ui->buttonBrowseFile->setEnabled(!unlocking);
+    m_ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(!unlocking);
+
+    m_ui->unlockProgress->setVisible(unlocking);
+    if (unlocking) {
+        updateUnlockProgress();
+        m_unlockProgressTimer->start();
+    } else {
+        m_unlockProgressTimer->stop();
+    }
+}
+
+void DatabaseOpenWidget::updateUnlockProgress()
+{
+    if (!m_unlockProgress) {
+        return;
+    }
+
+    switch (m_unlockProgress->stage()) {
+    case KdbxReader::ProgressObserver::KeyTransformation:
+        m_ui->unlockProgress->setFormat(tr("Transforming key..."));
+        break;
+    case KdbxReader::ProgressObserver::Decryption:
+        m_ui->unlockProgress->setFormat(tr("Decrypting database..."));
+        break;
+    case KdbxReader::ProgressObserver::Parsing:
+        m_ui->unlockProgress->setFormat(tr("Reading database... %p%"));
+        break;
+    }
+
+    int percent = m_unlockProgress->percent();
+    if (percent < 0) {
+        // busy indicator
+        m_ui->unlockProgress->setRange(0, 0);
+    } else {
+        m_ui->unlockProgress->setRange(0, 100);
+        m_ui->unlockProgress->setValue(percent);
     }
 }
 
@@ -273,6 +435,11 @@ QSharedPointer<CompositeKey> DatabaseOpenWidget::databaseKey()
 
 void DatabaseOpenWidget::reject()
 {
+    if (m_unlockWatcher) {
+        abandonUnlock();
+        return;
+    }
+
     emit editFinished(false);
 }
 
@@ -19,6 +19,7 @@
 #ifndef KEEPASSX_DATABASEOPENWIDGET_H
 #define KEEPASSX_DATABASEOPENWIDGET_H
 
+#include <QFutureWatcher>
 #include <QScopedPointer>
 
 #include "gui/DialogyWidget.h"
@@ -26,6 +27,8 @@
 
 class Database;
 class QFile;
+class QThread;
+class QTimer;
 
 namespace Ui
 {
@@ -67,6 +70,8 @@ private slots:
     void yubikeyDetected(int slot, bool blocking);
     void yubikeyDetectComplete();
     void noYubikeyFound();
+    void updateUnlockProgress();
+    void unlockFinished();
 
 protected:
     const QScopedPointer<Ui::DatabaseOpenWidget> m_ui;
@@ -74,7 +79,24 @@ protected:
     QString m_filename;
 
 private:
+    class UnlockProgress;
+    struct UnlockResult
+    {
+        Database* db;
+        QString errorString;
+    };
+
+    static UnlockResult readDatabaseFile(const QString& filename,
+                                         QSharedPointer<CompositeKey> key,
+                                         QSharedPointer<UnlockProgress> progress,
+                                         QThread* targetThread);
+    void setUnlocking(bool unlocking);
+    void abandonUnlock();
+
     bool m_yubiKeyBeingPolled = false;
+    QFutureWatcher<UnlockResult>* m_unlockWatcher = nullptr;
+    QSharedPointer<UnlockProgress> m_unlockProgress;
+    QTimer* m_unlockProgressTimer;
     Q_DISABLE_COPY(DatabaseOpenWidget)
 };
 
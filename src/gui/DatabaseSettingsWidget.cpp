@@ -20,6 +20,7 @@
 #include "ui_DatabaseSettingsWidget.h"
 #include "ui_DatabaseSettingsWidgetEncryption.h"
 #include "ui_DatabaseSettingsWidgetGeneral.h"
+#include "ui_DatabaseSettingsWidgetStatistics.h"
 
 #include <QMessageBox>
 #include <QPushButton>
@@ -28,10 +29,12 @@
 #include "MessageBox.h"
 #include "core/AsyncTask.h"
 #include "core/Database.h"
+#include "core/DatabaseMemoryStats.h"
 #include "core/FilePath.h"
 #include "core/Global.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
+#include "core/Tools.h"
 #include "crypto/SymmetricCipher.h"
 #include "crypto/kdf/Argon2Kdf.h"
 
@@ -40,13 +43,16 @@ DatabaseSettingsWidget::DatabaseSettingsWidget(QWidget* parent)
     , m_ui(new Ui::DatabaseSettingsWidget())
     , m_uiGeneral(new Ui::DatabaseSettingsWidgetGeneral())
     , m_uiEncryption(new Ui::DatabaseSettingsWidgetEncryption())
+    , m_uiStatistics(new Ui::DatabaseSettingsWidgetStatistics())
     , m_uiGeneralPage(new QWidget())
     , m_uiEncryptionPage(new QWidget())
+    , m_uiStatisticsPage(new QWidget())
     , m_db(nullptr)
 {
     m_ui->setupUi(this);
     m_uiGeneral->setupUi(m_uiGeneralPage);
     m_uiEncryption->setupUi(m_uiEncryptionPage);
+    m_uiStatistics->setupUi(m_uiStatisticsPage);
 
     connect(m_ui->buttonBox, SIGNAL(accepted()), SLOT(save()));
     connect(m_ui->buttonBox, SIGNAL(rejected()), SLOT(reject()));
@@ -58,6 +64,10 @@ DatabaseSettingsWidget::DatabaseSettingsWidget(QWidget* parent)
             SIGNAL(toggled(bool)),
             m_uiGeneral->historyMaxSizeSpinBox,
             SLOT(setEnabled(bool)));
+    connect(m_uiGeneral->compressionCheckbox,
+            SIGNAL(toggled(bool)),
+            m_uiGeneral->compressionLevelSpinBox,
+            SLOT(setEnabled(bool)));
     connect(m_uiEncryption->transformBenchmarkButton, SIGNAL(clicked()), SLOT(transformRoundsBenchmark()));
     connect(m_uiEncryption->kdfComboBox, SIGNAL(currentIndexChanged(int)), SLOT(kdfChanged(int)));
 
@@ -66,8 +76,10 @@ DatabaseSettingsWidget::DatabaseSettingsWidget(QWidget* parent)
 
     m_ui->categoryList->addCategory(tr("General"), FilePath::instance()->icon("categories", "preferences-other"));
     m_ui->categoryList->addCategory(tr("Encryption"), FilePath::instance()->icon("actions", "document-encrypt"));
+    m_ui->categoryList->addCategory(tr("Statistics"), FilePath::instance()->icon("actions", "document-properties"));
     m_ui->stackedWidget->addWidget(m_uiGeneralPage);
     m_ui->stackedWidget->addWidget(m_uiEncryptionPage);
+    m_ui->stackedWidget->addWidget(m_uiStatisticsPage);
 
     connect(m_ui->categoryList, SIGNAL(categoryChanged(int)), m_ui->stackedWidget, SLOT(setCurrentIndex(int)));
 }
@@ -87,6 +99,8 @@ void DatabaseSettingsWidget::load(Database* db)
     m_uiGeneral->recycleBinEnabledCheckBox->setChecked(meta->recycleBinEnabled());
     m_uiGeneral->defaultUsernameEdit->setText(meta->defaultUserName());
     m_uiGeneral->compressionCheckbox->setChecked(m_db->compressionAlgo() != Database::CompressionNone);
+    m_uiGeneral->compressionLevelSpinBox->setValue(m_db->compressionLevel());
+    m_uiGeneral->compressionLevelSpinBox->setEnabled(m_uiGeneral->compressionCheckbox->isChecked());
 
     if (meta->historyMaxItems() > -1) {
         m_uiGeneral->historyMaxItemsSpinBox->setValue(meta->historyMaxItems());
@@ -140,10 +154,49 @@ void DatabaseSettingsWidget::load(Database* db)
         m_uiEncryption->parallelismSpinBox->setValue(argon2Kdf->parallelism());
     }
 
+    loadStatistics();
+
     m_uiGeneral->dbNameEdit->setFocus();
     m_ui->categoryList->setCurrentCategory(0);
 }
 
+void DatabaseSettingsWidget::loadStatistics()
+{
+    QTreeWidget* tree = m_uiStatistics->statisticsTree;
+    tree->clear();
+
+    const DatabaseMemoryStats stats = m_db->memoryStats();
+    auto addItem = [](QTreeWidgetItem* parent, const QString& name, qint64 bytes) {
+        auto* item = new QTreeWidgetItem(parent, QStringList() << name << Tools::humanReadableFileSize(bytes));
+        item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+        return item;
+    };
+
+    auto* totalItem = new QTreeWidgetItem(
+        tree, QStringList() << tr("Total") << Tools::humanReadableFileSize(stats.totalBytes()));
+    totalItem->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+    addItem(totalItem, tr("Attributes"), stats.total.attributes);
+    addItem(totalItem, tr("Protected values"), stats.total.protectedValues);
+    addItem(totalItem, tr("Attachments"), stats.total.attachments);
+    addItem(totalItem, tr("History (%n item(s))", "", stats.total.historyItems), stats.total.history);
+    addItem(totalItem, tr("Custom data"), stats.total.customData + stats.metadataCustomData);
+    addItem(totalItem, tr("Custom icons"), stats.customIcons);
+    addItem(totalItem, tr("Deleted objects"), stats.deletedObjects);
+    addItem(totalItem, tr("Shared attachments (not included)"), stats.total.sharedAttachments);
+    totalItem->setExpanded(true);
+
+    auto* groupsItem = new QTreeWidgetItem(tree, QStringList() << tr("Groups"));
+    for (const DatabaseMemoryStats::GroupUsage& group : stats.groups) {
+        addItem(groupsItem, group.path, group.usage.total());
+    }
+
+    auto* entriesItem = new QTreeWidgetItem(tree, QStringList() << tr("Largest entries"));
+    for (const DatabaseMemoryStats::EntryUsage& entry : stats.largestEntries) {
+        addItem(entriesItem, QString("%1 (%2)").arg(entry.title, entry.groupPath), entry.bytes);
+    }
+    entriesItem->setExpanded(true);
+}
+
 void DatabaseSettingsWidget::save()
 {
     // first perform safety check for KDF rounds
@@ -179,6 +232,9 @@ void DatabaseSettingsWidget::save()
 
     m_db->setCompressionAlgo(m_uiGeneral->compressionCheckbox->isChecked() ? Database::CompressionGZip
                                                                            : Database::CompressionNone);
+    if (m_uiGeneral->compressionLevelSpinBox->value() != m_db->compressionLevel()) {
+        m_db->setCompressionLevel(m_uiGeneral->compressionLevelSpinBox->value());
+    }
 
     Metadata* meta = m_db->metadata();
 
@@ -33,6 +33,7 @@ namespace Ui
     class DatabaseSettingsWidget;
     class DatabaseSettingsWidgetGeneral;
     class DatabaseSettingsWidgetEncryption;
+    class DatabaseSettingsWidgetStatistics;
 }
 
 class DatabaseSettingsWidget : public DialogyWidget
@@ -59,12 +60,15 @@ private slots:
 
 private:
     void truncateHistories();
+    void loadStatistics();
 
     const QScopedPointer<Ui::DatabaseSettingsWidget> m_ui;
     const QScopedPointer<Ui::DatabaseSettingsWidgetGeneral> m_uiGeneral;
     const QScopedPointer<Ui::DatabaseSettingsWidgetEncryption> m_uiEncryption;
+    const QScopedPointer<Ui::DatabaseSettingsWidgetStatistics> m_uiStatistics;
     QWidget* m_uiGeneralPage;
     QWidget* m_uiEncryptionPage;
+    QWidget* m_uiStatisticsPage;
     Database* m_db;
 };
 
@@ -19,8 +19,10 @@
 #include "DatabaseTabWidget.h"
 
 #include <QFileInfo>
+#include <QPointer>
 #include <QPushButton>
 #include <QTabWidget>
+#include <QTimer>
 
 #include "autotype/AutoType.h"
 #include "core/AsyncTask.h"
@@ -45,6 +47,10 @@ DatabaseManagerStruct::DatabaseManagerStruct()
     , modified(false)
     , readOnly(false)
     , saveAttempts(0)
+    , saving(false)
+    , saveQueued(false)
+    , closePending(false)
+    , lockPending(false)
 {
 }
 
@@ -54,6 +60,7 @@ DatabaseTabWidget::DatabaseTabWidget(QWidget* parent)
     : QTabWidget(parent)
     , m_dbWidgetStateSync(new DatabaseWidgetStateSync(this))
     , m_dbPendingLock(nullptr)
+    , m_closeAllPending(false)
 {
     DragTabBar* tabBar = new DragTabBar(this);
     setTabBar(tabBar);
@@ -234,6 +241,12 @@ bool DatabaseTabWidget::closeDatabase(Database* db)
 {
     Q_ASSERT(db);
 
+    if (m_dbList[db].saving) {
+        // closed once the running save is done
+        m_dbList[db].closePending = true;
+        return false;
+    }
+
     const DatabaseManagerStruct& dbStruct = m_dbList.value(db);
     int index = databaseIndex(db);
     Q_ASSERT(index != -1);
@@ -302,6 +315,13 @@ void DatabaseTabWidget::deleteDatabase(Database* db)
 
 bool DatabaseTabWidget::closeAllDatabases()
 {
+    if (isSaving()) {
+        // closed once the running saves are done, see resumeCloseAllDatabases()
+        m_closeAllPending = true;
+        return false;
+    }
+
+    m_closeAllPending = false;
     while (!m_dbList.isEmpty()) {
         if (!closeDatabase()) {
             return false;
@@ -323,30 +343,87 @@ bool DatabaseTabWidget::saveDatabase(Database* db, QString filePath)
     }
 
     if (!dbStruct.readOnly) {
+        if (dbStruct.saving) {
+            // saved again once the running save is done, including everything changed meanwhile
+            dbStruct.saveQueued = true;
+            if (!filePath.isEmpty()) {
+                dbStruct.queuedSavePath = filePath;
+            }
+            return true;
+        }
+
         if (filePath.isEmpty()) {
             filePath = dbStruct.fileInfo.canonicalFilePath();
         }
 
         dbStruct.dbWidget->blockAutoReload(true);
-        // TODO: Make this async, but lock out the database widget to prevent re-entrance
+        dbStruct.saving = true;
         bool useAtomicSaves = config()->get("UseAtomicSaves", true).toBool();
-        QString errorMessage = db->saveToFile(filePath, useAtomicSaves, config()->get("BackupBeforeSave").toBool());
-        dbStruct.dbWidget->blockAutoReload(false);
+        bool backup = config()->get("BackupBeforeSave").toBool();
+
+        // Transform the key and write a snapshot from a worker thread,
+        // so the database can be edited while it is saved
+        const quint64 generation = db->generation();
+        const QByteArray transformedMasterKey = db->transformedMasterKey();
+        QScopedPointer<Database> snapshot(db->snapshot());
+        Database* snapshotDb = snapshot.data();
+        QPointer<Database> dbGuard(db);
+        QPointer<DatabaseWidget> dbWidget(dbStruct.dbWidget);
+        QString errorMessage = AsyncTask::runAndWaitForFuture([snapshotDb, filePath, useAtomicSaves, backup]() {
+            QString error = snapshotDb->prepareSnapshot();
+            if (error.isEmpty()) {
+                error = snapshotDb->saveToFile(filePath, useAtomicSaves, backup);
+            }
+            return error;
+        });
+
+        if (dbWidget) {
+            dbWidget->blockAutoReload(false);
+        }
+        // saves, closing and locking requested meanwhile
+        QTimer::singleShot(0, this, [this, dbGuard]() {
+            if (dbGuard) {
+                runPendingActions(dbGuard);
+            }
+            resumeCloseAllDatabases();
+        });
+        if (!dbGuard || !m_dbList.contains(db)) {
+            // the database was replaced meanwhile, the file no longer belongs to it
+            return false;
+        }
+
+        // opening other databases meanwhile invalidates dbStruct
+        DatabaseManagerStruct& savedDbStruct = m_dbList[db];
+        savedDbStruct.saving = false;
 
         if (errorMessage.isEmpty()) {
-            // successfully saved database file
-            dbStruct.modified = false;
-            dbStruct.saveAttempts = 0;
-            dbStruct.fileInfo = QFileInfo(filePath);
-            dbStruct.dbWidget->databaseSaved();
+            db->applySnapshotKey(snapshotDb, transformedMasterKey);
+
+            // successfully saved database file, changes made meanwhile are not part of it
+            const bool newFilePath =
+                savedDbStruct.fileInfo.canonicalFilePath() != QFileInfo(filePath).canonicalFilePath();
+            savedDbStruct.modified = db->generation() != generation;
+            savedDbStruct.saveAttempts = 0;
+            savedDbStruct.fileInfo = QFileInfo(filePath);
+            savedDbStruct.dbWidget->databaseSaved();
+            if (newFilePath) {
+                savedDbStruct.dbWidget->updateFilePath(savedDbStruct.fileInfo.absoluteFilePath());
+                updateLastDatabases(savedDbStruct.fileInfo.absoluteFilePath());
+            }
+            if (savedDbStruct.modified) {
+                savedDbStruct.dbWidget->databaseModified();
+                if (config()->get("AutoSaveAfterEveryChange").toBool()) {
+                    savedDbStruct.saveQueued = true;
+                }
+            }
             updateTabName(db);
             emit messageDismissTab();
             return true;
         } else {
-            dbStruct.modified = true;
+            savedDbStruct.modified = true;
             updateTabName(db);
 
-            if (++dbStruct.saveAttempts > 2 && useAtomicSaves) {
+            if (++savedDbStruct.saveAttempts > 2 && useAtomicSaves) {
                 // Saving failed 3 times, issue a warning and attempt to resolve
                 auto choice = MessageBox::question(this,
                                                    tr("Disable safe saves?"),
@@ -360,7 +437,7 @@ bool DatabaseTabWidget::saveDatabase(Database* db, QString filePath)
                     return saveDatabase(db, filePath);
                 }
                 // Reset save attempts without changing anything
-                dbStruct.saveAttempts = 0;
+                savedDbStruct.saveAttempts = 0;
             }
 
             emit messageTab(tr("Writing the database failed.").append("\n").append(errorMessage), MessageWidget::Error);
@@ -397,8 +474,6 @@ bool DatabaseTabWidget::saveDatabaseAs(Database* db)
                 continue;
             }
 
-            dbStruct.dbWidget->updateFilePath(dbStruct.fileInfo.absoluteFilePath());
-            updateLastDatabases(dbStruct.fileInfo.absoluteFilePath());
             return true;
         }
 
@@ -690,54 +765,122 @@ void DatabaseTabWidget::lockDatabases()
     clipboard()->clearCopiedText();
 
     for (int i = 0; i < count(); i++) {
-        DatabaseWidget* dbWidget = static_cast<DatabaseWidget*>(widget(i));
-        Database* db = databaseFromDatabaseWidget(dbWidget);
+        lockDatabase(static_cast<DatabaseWidget*>(widget(i)));
+    }
+}
 
-        if (dbWidget->currentMode() == DatabaseWidget::LockedMode || !dbWidget->dbHasKey()) {
-            continue;
-        }
+void DatabaseTabWidget::lockDatabase(DatabaseWidget* dbWidget)
+{
+    Database* db = databaseFromDatabaseWidget(dbWidget);
 
-        // show the correct tab widget before we are asking questions about it
-        setCurrentWidget(dbWidget);
+    if (dbWidget->currentMode() == DatabaseWidget::LockedMode || !dbWidget->dbHasKey()) {
+        return;
+    }
 
-        if (dbWidget->currentMode() == DatabaseWidget::EditMode && dbWidget->isEditWidgetModified()) {
-            QMessageBox::StandardButton result =
-                MessageBox::question(this,
-                                     tr("Lock database"),
-                                     tr("Can't lock the database as you are currently editing it.\nPlease press cancel "
-                                        "to finish your changes or discard them."),
-                                     QMessageBox::Discard | QMessageBox::Cancel,
-                                     QMessageBox::Cancel);
-            if (result == QMessageBox::Cancel) {
-                continue;
-            }
+    if (m_dbList[db].saving) {
+        // locked once the running save is done
+        m_dbList[db].lockPending = true;
+        return;
+    }
+
+    // show the correct tab widget before we are asking questions about it
+    setCurrentWidget(dbWidget);
+
+    if (dbWidget->currentMode() == DatabaseWidget::EditMode && dbWidget->isEditWidgetModified()) {
+        QMessageBox::StandardButton result =
+            MessageBox::question(this,
+                                 tr("Lock database"),
+                                 tr("Can't lock the database as you are currently editing it.\nPlease press cancel "
+                                    "to finish your changes or discard them."),
+                                 QMessageBox::Discard | QMessageBox::Cancel,
+                                 QMessageBox::Cancel);
+        if (result == QMessageBox::Cancel) {
+            return;
         }
+    }
 
-        if (m_dbList[db].modified) {
-            QMessageBox::StandardButton result =
-                MessageBox::question(this,
-                                     tr("Lock database"),
-                                     tr("This database has been modified.\nDo you want to save the database before "
-                                        "locking it?\nOtherwise your changes are lost."),
-                                     QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel,
-                                     QMessageBox::Cancel);
-            if (result == QMessageBox::Save) {
-                if (!saveDatabase(db)) {
-                    continue;
-                }
-            } else if (result == QMessageBox::Discard) {
-                m_dbList[db].modified = false;
-                m_dbList[db].dbWidget->databaseSaved();
-            } else if (result == QMessageBox::Cancel) {
-                continue;
+    if (m_dbList[db].modified) {
+        QMessageBox::StandardButton result =
+            MessageBox::question(this,
+                                 tr("Lock database"),
+                                 tr("This database has been modified.\nDo you want to save the database before "
+                                    "locking it?\nOtherwise your changes are lost."),
+                                 QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel,
+                                 QMessageBox::Cancel);
+        if (result == QMessageBox::Save) {
+            if (!saveDatabase(db)) {
+                return;
             }
+        } else if (result == QMessageBox::Discard) {
+            m_dbList[db].modified = false;
+            m_dbList[db].dbWidget->databaseSaved();
+        } else if (result == QMessageBox::Cancel) {
+            return;
         }
+    }
+
+    dbWidget->lock();
+    // database has changed so we can't use the db variable anymore
+    updateTabName(dbWidget->database());
+
+    emit databaseLocked(dbWidget);
+}
+
+/**
+ * Run what was requested for a database while it was saved: another save
+ * first, then closing or locking it.
+ */
+void DatabaseTabWidget::runPendingActions(Database* db)
+{
+    if (!m_dbList.contains(db)) {
+        return;
+    }
 
-        dbWidget->lock();
-        // database has changed so we can't use the db variable anymore
-        updateTabName(dbWidget->database());
+    DatabaseManagerStruct& dbStruct = m_dbList[db];
+    if (dbStruct.saving) {
+        return;
+    }
 
-        emit databaseLocked(dbWidget);
+    if (dbStruct.saveQueued) {
+        const QString filePath = dbStruct.queuedSavePath;
+        dbStruct.saveQueued = false;
+        dbStruct.queuedSavePath.clear();
+        if (dbStruct.modified || !filePath.isEmpty()) {
+            // runs the pending actions again once it is done
+            saveDatabase(db, filePath);
+            return;
+        }
+    }
+
+    if (dbStruct.closePending) {
+        dbStruct.closePending = false;
+        dbStruct.lockPending = false;
+        closeDatabase(db);
+    } else if (dbStruct.lockPending) {
+        dbStruct.lockPending = false;
+        lockDatabase(dbStruct.dbWidget);
+    }
+}
+
+bool DatabaseTabWidget::isSaving() const
+{
+    for (const DatabaseManagerStruct& dbStruct : m_dbList) {
+        if (dbStruct.saving) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Let a refused closeAllDatabases() be requested again once no database
+ * is saved any longer.
+ */
+void DatabaseTabWidget::resumeCloseAllDatabases()
+{
+    if (m_closeAllPending && !isSaving()) {
+        m_closeAllPending = false;
+        emit readyToCloseAllDatabases();
     }
 }
 
@@ -756,6 +899,13 @@ void DatabaseTabWidget::relockPendingDatabase()
         return;
     }
 
+    Database* db = databaseFromDatabaseWidget(m_dbPendingLock);
+    if (m_dbList[db].saving) {
+        m_dbList[db].lockPending = true;
+        m_dbPendingLock = nullptr;
+        return;
+    }
+
     m_dbPendingLock->lock();
 
     emit databaseLocked(m_dbPendingLock);
@@ -769,7 +919,7 @@ void DatabaseTabWidget::modified()
     Database* db = static_cast<Database*>(sender());
     DatabaseManagerStruct& dbStruct = m_dbList[db];
 
-    if (config()->get("AutoSaveAfterEveryChange").toBool() && !dbStruct.readOnly) {
+    if (config()->get("AutoSaveAfterEveryChange").toBool() && !dbStruct.readOnly && !dbStruct.saving) {
         saveDatabase(db);
         return;
     }
@@ -800,12 +950,21 @@ void DatabaseTabWidget::updateLastDatabases(const QString& filename)
 void DatabaseTabWidget::changeDatabase(Database* newDb, bool unsavedChanges)
 {
     Q_ASSERT(sender());
-    Q_ASSERT(!m_dbList.contains(newDb));
 
     DatabaseWidget* dbWidget = static_cast<DatabaseWidget*>(sender());
     Database* oldDb = databaseFromDatabaseWidget(dbWidget);
+    if (newDb == oldDb) {
+        // the database was reloaded in place
+        m_dbList[oldDb].modified = unsavedChanges;
+        updateTabName(oldDb);
+        return;
+    }
+
+    Q_ASSERT(!m_dbList.contains(newDb));
     DatabaseManagerStruct dbStruct = m_dbList[oldDb];
     dbStruct.modified = unsavedChanges;
+    // a save still running belongs to the old database
+    dbStruct.saving = false;
     m_dbList.remove(oldDb);
     m_dbList.insert(newDb, dbStruct);
 
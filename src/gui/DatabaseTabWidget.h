@@ -41,6 +41,11 @@ struct DatabaseManagerStruct
     bool modified;
     bool readOnly;
     int saveAttempts;
+    bool saving;
+    bool saveQueued;
+    QString queuedSavePath;
+    bool closePending;
+    bool lockPending;
 };
 
 Q_DECLARE_TYPEINFO(DatabaseManagerStruct, Q_MOVABLE_TYPE);
@@ -91,6 +96,7 @@ signals:
     void messageTab(const QString&, MessageWidget::MessageType type);
     void messageDismissGlobal();
     void messageDismissTab();
+    void readyToCloseAllDatabases();
 
 private slots:
     void updateTabName(Database* db);
@@ -107,6 +113,10 @@ private:
     bool saveDatabaseAs(Database* db);
     bool closeDatabase(Database* db);
     void deleteDatabase(Database* db);
+    void lockDatabase(DatabaseWidget* dbWidget);
+    void runPendingActions(Database* db);
+    bool isSaving() const;
+    void resumeCloseAllDatabases();
     int databaseIndex(Database* db);
     Database* indexDatabase(int index);
     DatabaseManagerStruct indexDatabaseManagerStruct(int index);
@@ -118,6 +128,7 @@ private:
     QHash<Database*, DatabaseManagerStruct> m_dbList;
     QPointer<DatabaseWidgetStateSync> m_dbWidgetStateSync;
     QPointer<DatabaseWidget> m_dbPendingLock;
+    bool m_closeAllPending;
 };
 
 #endif // KEEPASSX_DATABASETABWIDGET_H
@@ -397,6 +397,7 @@ void DatabaseWidget::replaceDatabase(Database* db)
 {
     Database* oldDb = m_db;
     m_db = db;
+    m_db->metadata()->scaleCustomIcons();
     m_groupView->changeDatabase(m_db);
     emit databaseChanged(m_db, m_databaseModified);
     delete oldDb;
@@ -854,6 +855,7 @@ void DatabaseWidget::openDatabase(bool accepted)
         m_databaseOpenWidget = nullptr;
         delete m_keepass1OpenWidget;
         m_keepass1OpenWidget = nullptr;
+        m_fileFingerprint = FileFingerprint(m_filePath);
         m_fileWatcher.addPath(m_filePath);
     } else {
         m_fileWatcher.removePath(m_filePath);
@@ -902,6 +904,7 @@ void DatabaseWidget::unlockDatabase(bool accepted)
     }
 
     replaceDatabase(db);
+    m_fileFingerprint = FileFingerprint(m_filePath);
 
     restoreGroupEntryFocus(m_groupBeforeLock, m_entryBeforeLock);
     m_groupBeforeLock = QUuid();
@@ -1046,6 +1049,7 @@ void DatabaseWidget::databaseModified()
 void DatabaseWidget::databaseSaved()
 {
     m_databaseModified = false;
+    m_fileFingerprint = FileFingerprint(m_filePath);
 }
 
 void DatabaseWidget::refreshSearch()
@@ -1201,6 +1205,7 @@ void DatabaseWidget::lock()
 
     endSearch();
     clearAllWidgets();
+    m_entryView->clearCache();
     m_unlockDatabaseWidget->load(m_filePath);
     setCurrentWidget(m_unlockDatabaseWidget);
     Database* newDb = new Database();
@@ -1255,6 +1260,14 @@ void DatabaseWidget::reloadDatabaseFile()
         return;
     }
 
+    // Skip the prompt and the key derivation when the file was only touched or rewritten as is
+    FileFingerprint fingerprint(m_filePath);
+    if (fingerprint.hasSameContent(m_fileFingerprint)) {
+        m_fileFingerprint = fingerprint;
+        m_fileWatcher.addPath(m_filePath);
+        return;
+    }
+
     if (!config()->get("AutoReloadOnChange").toBool()) {
         // Ask if we want to reload the db
         QMessageBox::StandardButton mb =
@@ -1278,6 +1291,7 @@ void DatabaseWidget::reloadDatabaseFile()
     if (file.open(QIODevice::ReadOnly)) {
         Database* db = reader.readDatabase(&file, database()->key());
         if (db != nullptr) {
+            m_db->setEmitModified(false);
             if (m_databaseModified) {
                 // Ask if we want to merge changes into new database
                 QMessageBox::StandardButton mb =
@@ -1289,7 +1303,6 @@ void DatabaseWidget::reloadDatabaseFile()
 
                 if (mb == QMessageBox::Yes) {
                     // Merge the old database into the new one
-                    m_db->setEmitModified(false);
                     db->merge(m_db);
                 } else {
                     // Since we are accepting the new file as-is, internally mark as unmodified
@@ -1298,20 +1311,12 @@ void DatabaseWidget::reloadDatabaseFile()
                 }
             }
 
-            QUuid groupBeforeReload;
-            if (m_groupView && m_groupView->currentGroup()) {
-                groupBeforeReload = m_groupView->currentGroup()->uuid();
-            } else {
-                groupBeforeReload = m_db->rootGroup()->uuid();
-            }
-
-            QUuid entryBeforeReload;
-            if (m_entryView && m_entryView->currentEntry()) {
-                entryBeforeReload = m_entryView->currentEntry()->uuid();
-            }
-
-            replaceDatabase(db);
-            restoreGroupEntryFocus(groupBeforeReload, entryBeforeReload);
+            // Apply only the differences, so the models, selection and search stay as they are
+            m_db->updateFrom(db);
+            m_db->setEmitModified(true);
+            delete db;
+            m_fileFingerprint = fingerprint;
+            emit databaseChanged(m_db, m_databaseModified);
         }
     } else {
         m_messageWidget->showMessage(
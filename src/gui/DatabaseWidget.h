@@ -24,6 +24,7 @@
 #include <QStackedWidget>
 #include <QTimer>
 
+#include "core/FileFingerprint.h"
 #include "gui/entry/EntryModel.h"
 #include "gui/MessageWidget.h"
 #include "gui/csvImport/CsvImportWizard.h"
@@ -250,6 +251,7 @@ private:
     QFileSystemWatcher m_fileWatcher;
     QTimer m_fileWatchTimer;
     QTimer m_fileWatchUnblockTimer;
+    FileFingerprint m_fileFingerprint;
     bool m_ignoreAutoReload;
     bool m_databaseModified;
 };
@@ -32,6 +32,7 @@
 #include "core/FilePath.h"
 #include "core/InactivityTimer.h"
 #include "core/Metadata.h"
+#include "core/Trace.h"
 #include "format/KeePass2Writer.h"
 #include "gui/AboutDialog.h"
 #include "gui/DatabaseRepairWidget.h"
@@ -64,9 +65,19 @@
 class BrowserPlugin : public ISettingsPage
 {
 public:
-    BrowserPlugin(DatabaseTabWidget* tabWidget)
+    BrowserPlugin(DatabaseTabWidget* tabWidget, MainWindow* mainWindow)
     {
         m_nativeMessagingHost = QSharedPointer<NativeMessagingHost>(new NativeMessagingHost(tabWidget, BrowserSettings::isEnabled()));
+
+        // Starting the host initializes libsodium and updates the native messaging
+        // scripts, which can wait until the main window is on screen
+        NativeMessagingHost* host = m_nativeMessagingHost.data();
+        QObject::connect(mainWindow, &MainWindow::startupCompleted, host, [host]() {
+            if (BrowserSettings::isEnabled() && BrowserSettings::supportBrowserProxy()) {
+                TRACE_SPAN("startup", "NativeMessagingHost::run");
+                host->run();
+            }
+        });
     }
 
     ~BrowserPlugin()
@@ -122,7 +133,11 @@ MainWindow::MainWindow()
     , m_trayIcon(nullptr)
     , m_appExitCalled(false)
     , m_appExiting(false)
+    , m_closePending(false)
+    , m_firstPaintDone(false)
+    , m_startupCompleted(false)
 {
+    TRACE_SPAN("startup", "MainWindow::MainWindow");
     m_ui->setupUi(this);
 
 #if defined(Q_OS_UNIX) && !defined(Q_OS_MAC) && !defined(QT_NO_DBUS)
@@ -144,7 +159,7 @@ MainWindow::MainWindow()
 
     restoreGeometry(config()->get("GUI/MainWindowGeometry").toByteArray());
 #ifdef WITH_XC_BROWSER
-    m_ui->settingsWidget->addSettingsPage(new BrowserPlugin(m_ui->tabWidget));
+    m_ui->settingsWidget->addSettingsPage(new BrowserPlugin(m_ui->tabWidget, this));
 #endif
 #ifdef WITH_XC_SSHAGENT
     SSHAgent::init(this);
@@ -171,15 +186,6 @@ MainWindow::MainWindow()
         m_copyAdditionalAttributeActions, SIGNAL(triggered(QAction*)), SLOT(copyAttribute(QAction*)));
     connect(m_ui->menuEntryCopyAttribute, SIGNAL(aboutToShow()), this, SLOT(updateCopyAttributesMenu()));
 
-    Qt::Key globalAutoTypeKey = static_cast<Qt::Key>(config()->get("GlobalAutoTypeKey").toInt());
-    Qt::KeyboardModifiers globalAutoTypeModifiers =
-        static_cast<Qt::KeyboardModifiers>(config()->get("GlobalAutoTypeModifiers").toInt());
-    if (globalAutoTypeKey > 0 && globalAutoTypeModifiers > 0) {
-        autoType()->registerGlobalShortcut(globalAutoTypeKey, globalAutoTypeModifiers);
-    }
-
-    m_ui->actionEntryAutoType->setVisible(autoType()->isAvailable());
-
     m_inactivityTimer = new InactivityTimer(this);
     connect(m_inactivityTimer, SIGNAL(inactivityDetected()), this, SLOT(lockDatabasesAfterInactivity()));
     applySettingsChanges();
@@ -327,6 +333,7 @@ MainWindow::MainWindow()
             this,
             SLOT(displayTabMessage(QString, MessageWidget::MessageType)));
     connect(m_ui->tabWidget, SIGNAL(messageDismissTab()), this, SLOT(hideTabMessage()));
+    connect(m_ui->tabWidget, SIGNAL(readyToCloseAllDatabases()), this, SLOT(resumeClosing()));
 
     m_screenLockListener = new ScreenLockListener(this);
     connect(m_screenLockListener, SIGNAL(screenLocked()), SLOT(handleScreenLock()));
@@ -359,6 +366,43 @@ MainWindow::~MainWindow()
 {
 }
 
+/**
+ * Start the subsystems which are not needed for the first frame, like the
+ * auto-type plugin and browser integration. Called once the main window has
+ * been painted, or directly when it starts hidden.
+ */
+void MainWindow::completeStartup()
+{
+    if (m_startupCompleted) {
+        return;
+    }
+    m_startupCompleted = true;
+
+    TRACE_SPAN("startup", "MainWindow::completeStartup");
+    Qt::Key globalAutoTypeKey = static_cast<Qt::Key>(config()->get("GlobalAutoTypeKey").toInt());
+    Qt::KeyboardModifiers globalAutoTypeModifiers =
+        static_cast<Qt::KeyboardModifiers>(config()->get("GlobalAutoTypeModifiers").toInt());
+    if (globalAutoTypeKey > 0 && globalAutoTypeModifiers > 0) {
+        autoType()->registerGlobalShortcut(globalAutoTypeKey, globalAutoTypeModifiers);
+    }
+
+    m_ui->actionEntryAutoType->setVisible(autoType()->isAvailable());
+
+    emit startupCompleted();
+}
+
+void MainWindow::paintEvent(QPaintEvent* event)
+{
+    QMainWindow::paintEvent(event);
+
+    if (!m_firstPaintDone) {
+        m_firstPaintDone = true;
+        Trace::mark("startup", "first paint");
+        // Queued so the frame is flushed to the screen first
+        QTimer::singleShot(0, this, SLOT(completeStartup()));
+    }
+}
+
 void MainWindow::showErrorMessage(const QString& message)
 {
     m_ui->globalMessageWidget->showMessage(message, MessageWidget::Error);
@@ -735,6 +779,8 @@ void MainWindow::closeEvent(QCloseEvent* event)
         event->accept();
         QApplication::quit();
     } else {
+        // closing again once running saves are done, see resumeClosing()
+        m_closePending = true;
         event->ignore();
     }
 }
@@ -1074,9 +1120,24 @@ void MainWindow::dropEvent(QDropEvent* event)
 
 void MainWindow::closeAllDatabases()
 {
+    m_closePending = false;
     m_ui->tabWidget->closeAllDatabases();
 }
 
+/**
+ * Close the window or all databases again, which was refused while
+ * databases were being saved.
+ */
+void MainWindow::resumeClosing()
+{
+    if (m_closePending) {
+        m_closePending = false;
+        close();
+    } else {
+        m_ui->tabWidget->closeAllDatabases();
+    }
+}
+
 void MainWindow::lockAllDatabases()
 {
     lockDatabasesAfterInactivity();
@@ -72,10 +72,15 @@ public slots:
     void bringToFront();
     void closeAllDatabases();
     void lockAllDatabases();
+    void completeStartup();
+
+signals:
+    void startupCompleted();
 
 protected:
     void closeEvent(QCloseEvent* event) override;
     void changeEvent(QEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
 
 private slots:
     void setMenuActionState(DatabaseWidget::Mode mode = DatabaseWidget::None);
@@ -110,6 +115,7 @@ private slots:
     void hideTabMessage();
     void handleScreenLock();
     void showErrorMessage(const QString& message);
+    void resumeClosing();
 
 private:
     static void setShortcut(QAction* action, QKeySequence::StandardKey standard, int fallback = 0);
@@ -141,6 +147,9 @@ private:
 
     bool m_appExitCalled;
     bool m_appExiting;
+    bool m_closePending;
+    bool m_firstPaintDone;
+    bool m_startupCompleted;
 };
 
 #define KEEPASSXC_MAIN_WINDOW                                                                                          \
@@ -67,10 +67,6 @@ SettingsWidget::SettingsWidget(QWidget* parent)
     addPage(tr("General"), FilePath::instance()->icon("categories", "preferences-other"), m_generalWidget);
     addPage(tr("Security"), FilePath::instance()->icon("status", "security-high"), m_secWidget);
 
-    if (!autoType()->isAvailable()) {
-        m_generalUi->generalSettingsTabWidget->removeTab(1);
-    }
-
     connect(this, SIGNAL(accepted()), SLOT(saveSettings()));
     connect(this, SIGNAL(apply()), SLOT(saveSettings()));
     connect(this, SIGNAL(rejected()), SLOT(reject()));
@@ -148,6 +144,12 @@ void SettingsWidget::loadSettings()
     m_generalUi->systrayMinimizeOnStartup->setChecked(config()->get("GUI/MinimizeOnStartup").toBool());
     m_generalUi->autoTypeAskCheckBox->setChecked(config()->get("security/autotypeask").toBool());
 
+    // Checked here instead of the constructor, this loads the auto-type plugin
+    const int autoTypeTabIndex = m_generalUi->generalSettingsTabWidget->indexOf(m_generalUi->tabAutotype);
+    if (!autoType()->isAvailable() && autoTypeTabIndex >= 0) {
+        m_generalUi->generalSettingsTabWidget->removeTab(autoTypeTabIndex);
+    }
+
     if (autoType()->isAvailable()) {
         m_globalAutoTypeKey = static_cast<Qt::Key>(config()->get("GlobalAutoTypeKey").toInt());
         m_globalAutoTypeModifiers =
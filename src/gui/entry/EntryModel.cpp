@@ -23,6 +23,8 @@
 #include <QMimeData>
 #include <QPainter>
 #include <QPalette>
+#include <QtConcurrentRun>
+#include <algorithm>
 
 #include "core/DatabaseIcons.h"
 #include "core/Entry.h"
@@ -36,12 +38,85 @@ const QString EntryModel::HiddenContentDisplay(QString("\u25cf").repeated(6));
 // Format used to display dates
 const Qt::DateFormat EntryModel::DateFormat = Qt::DefaultLocaleShortDate;
 
+// Search results larger than this are sorted in the background and fetched in batches of this size
+const int EntryModel::FetchBatchSize = 500;
+
+namespace
+{
+    struct SortItem
+    {
+        QVariant key;
+        Entry* entry;
+    };
+
+    /**
+     * Same ordering as the case insensitive, locale aware sorting of
+     * EntryView, string keys are expected to be lower case already.
+     */
+    bool keyLessThan(const QVariant& left, const QVariant& right)
+    {
+        switch (left.userType()) {
+        case QMetaType::QString:
+            return QString::localeAwareCompare(left.toString(), right.toString()) < 0;
+        case QMetaType::QDateTime:
+            return left.toDateTime() < right.toDateTime();
+        default:
+            return left.toLongLong() < right.toLongLong();
+        }
+    }
+
+    /**
+     * Columns resolving placeholders are cached. Entries change the others,
+     * e.g. the times and attachments, without emitting dataChanged().
+     */
+    bool isCachedColumn(int column)
+    {
+        switch (column) {
+        case EntryModel::Title:
+        case EntryModel::Username:
+        case EntryModel::Url:
+        case EntryModel::Notes:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Runs in a worker thread, the entries are never dereferenced
+    QList<Entry*> sortEntries(QVector<SortItem> items, Qt::SortOrder order)
+    {
+        if (order == Qt::AscendingOrder) {
+            std::stable_sort(items.begin(), items.end(), [](const SortItem& left, const SortItem& right) {
+                return keyLessThan(left.key, right.key);
+            });
+        } else {
+            std::stable_sort(items.begin(), items.end(), [](const SortItem& left, const SortItem& right) {
+                return keyLessThan(right.key, left.key);
+            });
+        }
+
+        QList<Entry*> entries;
+        entries.reserve(items.size());
+        for (const SortItem& item : asConst(items)) {
+            entries.append(item.entry);
+        }
+        return entries;
+    }
+} // namespace
+
 EntryModel::EntryModel(QObject* parent)
     : QAbstractTableModel(parent)
     , m_group(nullptr)
+    , m_sortColumn(ParentGroup)
+    , m_sortOrder(Qt::AscendingOrder)
+    , m_sorting(false)
+    , m_sortScheduled(false)
+    , m_removingRow(false)
+    , m_sortWatcher(new QFutureWatcher<QList<Entry*>>(this))
     , m_hideUsernames(false)
     , m_hidePasswords(true)
 {
+    connect(m_sortWatcher, SIGNAL(finished()), SLOT(sortFinished()));
 }
 
 Entry* EntryModel::entryFromIndex(const QModelIndex& index) const
@@ -57,6 +132,22 @@ QModelIndex EntryModel::indexFromEntry(Entry* entry) const
     return index(row, 1);
 }
 
+/**
+ * Whether the entry is shown, or still waiting to be fetched.
+ */
+bool EntryModel::containsEntry(Entry* entry) const
+{
+    return m_entries.contains(entry) || m_pendingEntries.contains(entry);
+}
+
+/**
+ * Whether search results are being sorted, they have no rows until it is done.
+ */
+bool EntryModel::isSorting() const
+{
+    return m_sorting;
+}
+
 void EntryModel::setGroup(Group* group)
 {
     if (!group || group == m_group) {
@@ -68,9 +159,12 @@ void EntryModel::setGroup(Group* group)
     severConnections();
 
     m_group = group;
-    m_allGroups.clear();
+    m_databases.clear();
+    m_cache.clear();
     m_entries = group->entries();
     m_orgEntries.clear();
+    m_pendingEntries.clear();
+    m_sorting = false;
 
     makeConnections(group);
 
@@ -85,36 +179,176 @@ void EntryModel::setEntryList(const QList<Entry*>& entries)
     severConnections();
 
     m_group = nullptr;
-    m_allGroups.clear();
-    m_entries = entries;
-    m_orgEntries = entries;
-
-    QSet<Database*> databases;
+    m_databases.clear();
+    m_cache.clear();
+    m_orgEntries.clear();
 
-    for (Entry* entry : asConst(m_entries)) {
-        databases.insert(entry->group()->database());
-    }
+    for (Entry* entry : entries) {
+        m_orgEntries.insert(entry);
 
-    for (Database* db : asConst(databases)) {
+        Database* db = entry->group()->database();
         Q_ASSERT(db);
-        const QList<Group*> groupList = db->rootGroup()->groupsRecursive(true);
-        for (const Group* group : groupList) {
-            m_allGroups.append(group);
+        if (!m_databases.contains(db)) {
+            m_databases.append(db);
         }
+    }
 
-        if (db->metadata()->recycleBin()) {
-            m_allGroups.removeOne(db->metadata()->recycleBin());
-        }
+    // One connection per database instead of one per group
+    for (const Database* db : asConst(m_databases)) {
+        connect(db, SIGNAL(entryAboutToAdd(Entry*)), SLOT(entryAboutToAdd(Entry*)));
+        connect(db, SIGNAL(entryAdded(Entry*)), SLOT(entryAdded(Entry*)));
+        connect(db, SIGNAL(entryAboutToRemove(Entry*)), SLOT(entryAboutToRemove(Entry*)));
+        connect(db, SIGNAL(entryRemoved(Entry*)), SLOT(entryRemoved()));
+        connect(db, SIGNAL(entryDataChanged(Entry*)), SLOT(entryDataChanged(Entry*)));
+        // The groups of a database are deleted after its signals are disconnected
+        connect(db, SIGNAL(destroyed(QObject*)), SLOT(databaseDestroyed(QObject*)));
     }
 
-    for (const Group* group : asConst(m_allGroups)) {
-        makeConnections(group);
+    if (entries.size() > FetchBatchSize) {
+        // Large result sets are exposed in batches once they are sorted
+        m_entries.clear();
+        m_pendingEntries = entries;
+        scheduleSort();
+    } else {
+        m_entries = entries;
+        m_pendingEntries.clear();
+        m_sorting = false;
     }
 
     endResetModel();
     emit switchedToSearchMode();
 }
 
+bool EntryModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && !m_sorting && !m_pendingEntries.isEmpty();
+}
+
+void EntryModel::fetchMore(const QModelIndex& parent)
+{
+    if (canFetchMore(parent)) {
+        fetchEntries(FetchBatchSize);
+    }
+}
+
+/**
+ * Make sure an entry of the search results has a row, if it is
+ * still waiting to be fetched.
+ */
+void EntryModel::fetchEntry(Entry* entry)
+{
+    if (m_sorting) {
+        return;
+    }
+
+    const int pendingIndex = m_pendingEntries.indexOf(entry);
+    if (pendingIndex != -1) {
+        fetchEntries(pendingIndex + 1);
+    }
+}
+
+/**
+ * Sort order of the view. Partially fetched search results are sorted again
+ * so rows keep being appended in the order of the view.
+ */
+void EntryModel::setSortOrder(int column, Qt::SortOrder order)
+{
+    if (column == m_sortColumn && order == m_sortOrder) {
+        return;
+    }
+
+    m_sortColumn = column;
+    m_sortOrder = order;
+
+    if (m_pendingEntries.isEmpty() && !m_sorting) {
+        return;
+    }
+
+    if (!m_entries.isEmpty()) {
+        beginResetModel();
+        m_pendingEntries = m_entries + m_pendingEntries;
+        m_entries.clear();
+        endResetModel();
+    }
+    scheduleSort();
+}
+
+void EntryModel::fetchEntries(int count)
+{
+    count = qMin(count, m_pendingEntries.size());
+    if (count <= 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_entries.size(), m_entries.size() + count - 1);
+    m_entries.append(m_pendingEntries.mid(0, count));
+    m_pendingEntries.erase(m_pendingEntries.begin(), m_pendingEntries.begin() + count);
+    endInsertRows();
+}
+
+void EntryModel::scheduleSort()
+{
+    m_sorting = true;
+    if (!m_sortScheduled) {
+        m_sortScheduled = true;
+        QMetaObject::invokeMethod(this, "startSort", Qt::QueuedConnection);
+    }
+}
+
+/**
+ * Collect the sort keys, they use the same cache as the view, and sort
+ * them in a worker thread.
+ */
+void EntryModel::startSort()
+{
+    m_sortScheduled = false;
+    if (!m_sorting) {
+        return;
+    }
+
+    QVector<SortItem> items;
+    items.reserve(m_pendingEntries.size());
+    for (Entry* entry : asConst(m_pendingEntries)) {
+        SortItem item;
+        item.key = sortKey(entry, m_sortColumn);
+        if (item.key.userType() == QMetaType::QString) {
+            item.key = item.key.toString().toLower();
+        }
+        item.entry = entry;
+        items.append(item);
+    }
+
+    m_sortWatcher->setFuture(QtConcurrent::run(sortEntries, items, m_sortOrder));
+}
+
+void EntryModel::sortFinished()
+{
+    if (!m_sorting || m_sortScheduled) {
+        return;
+    }
+
+    // Entries may have been added or removed while sorting
+    QSet<Entry*> pending = m_pendingEntries.toSet();
+    const QList<Entry*> result = m_sortWatcher->result();
+    QList<Entry*> sortedEntries;
+    for (Entry* entry : result) {
+        if (pending.remove(entry)) {
+            sortedEntries.append(entry);
+        }
+    }
+    for (Entry* entry : asConst(m_pendingEntries)) {
+        if (pending.contains(entry)) {
+            sortedEntries.append(entry);
+        }
+    }
+
+    m_pendingEntries = sortedEntries;
+    m_sorting = false;
+
+    fetchEntries(FetchBatchSize);
+    emit entriesSorted();
+}
+
 int EntryModel::rowCount(const QModelIndex& parent) const
 {
     if (parent.isValid()) {
@@ -141,106 +375,12 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
     }
 
     Entry* entry = entryFromIndex(index);
-    EntryAttributes* attr = entry->attributes();
+    const int column = index.column();
 
     if (role == Qt::DisplayRole) {
-        QString result;
-        switch (index.column()) {
-        case ParentGroup:
-            if (entry->group()) {
-                return entry->group()->name();
-            }
-            break;
-        case Title:
-            result = entry->resolveMultiplePlaceholders(entry->title());
-            if (attr->isReference(EntryAttributes::TitleKey)) {
-                result.prepend(tr("Ref: ", "Reference abbreviation"));
-            }
-            return result;
-        case Username:
-            if (m_hideUsernames) {
-                result = EntryModel::HiddenContentDisplay;
-            } else {
-                result = entry->resolveMultiplePlaceholders(entry->username());
-            }
-            if (attr->isReference(EntryAttributes::UserNameKey)) {
-                result.prepend(tr("Ref: ", "Reference abbreviation"));
-            }
-            return result;
-        case Password:
-            if (m_hidePasswords) {
-                result = EntryModel::HiddenContentDisplay;
-            } else {
-                result = entry->resolveMultiplePlaceholders(entry->password());
-            }
-            if (attr->isReference(EntryAttributes::PasswordKey)) {
-                result.prepend(tr("Ref: ", "Reference abbreviation"));
-            }
-            return result;
-        case Url:
-            result = entry->resolveMultiplePlaceholders(entry->displayUrl());
-            if (attr->isReference(EntryAttributes::URLKey)) {
-                result.prepend(tr("Ref: ", "Reference abbreviation"));
-            }
-            return result;
-        case Notes:
-            // Display only first line of notes in simplified format
-            result = entry->notes().section("\n", 0, 0).simplified();
-            if (attr->isReference(EntryAttributes::NotesKey)) {
-                result.prepend(tr("Ref: ", "Reference abbreviation"));
-            }
-            return result;
-        case Expires:
-            // Display either date of expiry or 'Never'
-            result = entry->timeInfo().expires()
-                         ? entry->timeInfo().expiryTime().toLocalTime().toString(EntryModel::DateFormat)
-                         : tr("Never");
-            return result;
-        case Created:
-            result = entry->timeInfo().creationTime().toLocalTime().toString(EntryModel::DateFormat);
-            return result;
-        case Modified:
-            result = entry->timeInfo().lastModificationTime().toLocalTime().toString(EntryModel::DateFormat);
-            return result;
-        case Accessed:
-            result = entry->timeInfo().lastAccessTime().toLocalTime().toString(EntryModel::DateFormat);
-            return result;
-        case Attachments:
-            // Display comma-separated list of attachments
-            QList<QString> attachments = entry->attachments()->keys();
-            for (int i = 0; i < attachments.size(); ++i) {
-                if (result.isEmpty()) {
-                    result.append(attachments.at(i));
-                    continue;
-                }
-                result.append(QString(", ") + attachments.at(i));
-            }
-            return result;
-        }
+        return displayValue(entry, column);
     } else if (role == Qt::UserRole) { // Qt::UserRole is used as sort role, see EntryView::EntryView()
-        switch (index.column()) {
-        case Username:
-            return entry->resolveMultiplePlaceholders(entry->username());
-        case Password:
-            return entry->resolveMultiplePlaceholders(entry->password());
-        case Expires:
-            // There seems to be no better way of expressing 'infinity'
-            return entry->timeInfo().expires() ? entry->timeInfo().expiryTime() : QDateTime(QDate(9999, 1, 1));
-        case Created:
-            return entry->timeInfo().creationTime();
-        case Modified:
-            return entry->timeInfo().lastModificationTime();
-        case Accessed:
-            return entry->timeInfo().lastAccessTime();
-        case Paperclip:
-            // Display entries with attachments above those without when
-            // sorting ascendingly (and vice versa when sorting descendingly)
-            return entry->attachments()->isEmpty() ? 1 : 0;
-        default:
-            // For all other columns, simply use data provided by Qt::Display-
-            // Role for sorting
-            return data(index, Qt::DisplayRole);
-        }
+        return sortKey(entry, column);
     } else if (role == Qt::DecorationRole) {
         switch (index.column()) {
         case ParentGroup:
@@ -285,6 +425,167 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
     return QVariant();
 }
 
+EntryModel::CachedEntry& EntryModel::cachedEntry(const Entry* entry) const
+{
+    auto it = m_cache.find(entry);
+    if (it == m_cache.end()) {
+        CachedEntry cached;
+        cached.display.resize(columnCount());
+        cached.sortKey.resize(columnCount());
+        cached.hasReferences = entry->hasReferences();
+        it = m_cache.insert(entry, cached);
+    }
+    return it.value();
+}
+
+QVariant EntryModel::displayValue(const Entry* entry, int column) const
+{
+    if (column == ParentGroup) {
+        // The group name can change without the entry noticing
+        return entry->group() ? entry->group()->name() : QVariant();
+    }
+    if (!isCachedColumn(column)) {
+        // Passwords in particular are never kept in the cache
+        return displayData(entry, column);
+    }
+
+    QVariant& value = cachedEntry(entry).display[column];
+    if (!value.isValid()) {
+        value = displayData(entry, column);
+    }
+    return value;
+}
+
+QVariant EntryModel::sortKey(const Entry* entry, int column) const
+{
+    if (column == ParentGroup) {
+        return displayValue(entry, column);
+    }
+    if (!isCachedColumn(column)) {
+        return sortData(entry, column);
+    }
+
+    QVariant key = cachedEntry(entry).sortKey[column];
+    if (!key.isValid()) {
+        key = sortData(entry, column);
+        cachedEntry(entry).sortKey[column] = key;
+    }
+    return key;
+}
+
+QVariant EntryModel::displayData(const Entry* entry, int column) const
+{
+    const EntryAttributes* attr = entry->attributes();
+
+    QString result;
+    switch (column) {
+    case Title:
+        result = entry->resolveMultiplePlaceholders(entry->title());
+        if (attr->isReference(EntryAttributes::TitleKey)) {
+            result.prepend(tr("Ref: ", "Reference abbreviation"));
+        }
+        return result;
+    case Username:
+        if (m_hideUsernames) {
+            result = EntryModel::HiddenContentDisplay;
+        } else {
+            result = entry->resolveMultiplePlaceholders(entry->username());
+        }
+        if (attr->isReference(EntryAttributes::UserNameKey)) {
+            result.prepend(tr("Ref: ", "Reference abbreviation"));
+        }
+        return result;
+    case Password:
+        if (m_hidePasswords) {
+            result = EntryModel::HiddenContentDisplay;
+        } else {
+            result = entry->resolveMultiplePlaceholders(entry->password());
+        }
+        if (attr->isReference(EntryAttributes::PasswordKey)) {
+            result.prepend(tr("Ref: ", "Reference abbreviation"));
+        }
+        return result;
+    case Url:
+        result = entry->resolveMultiplePlaceholders(entry->displayUrl());
+        if (attr->isReference(EntryAttributes::URLKey)) {
+            result.prepend(tr("Ref: ", "Reference abbreviation"));
+        }
+        return result;
+    case Notes:
+        // Display only first line of notes in simplified format
+        result = entry->notes().section("\n", 0, 0).simplified();
+        if (attr->isReference(EntryAttributes::NotesKey)) {
+            result.prepend(tr("Ref: ", "Reference abbreviation"));
+        }
+        return result;
+    case Expires:
+        // Display either date of expiry or 'Never'
+        result = entry->timeInfo().expires()
+                     ? entry->timeInfo().expiryTime().toLocalTime().toString(EntryModel::DateFormat)
+                     : tr("Never");
+        return result;
+    case Created:
+        result = entry->timeInfo().creationTime().toLocalTime().toString(EntryModel::DateFormat);
+        return result;
+    case Modified:
+        result = entry->timeInfo().lastModificationTime().toLocalTime().toString(EntryModel::DateFormat);
+        return result;
+    case Accessed:
+        result = entry->timeInfo().lastAccessTime().toLocalTime().toString(EntryModel::DateFormat);
+        return result;
+    case Attachments:
+        // Display comma-separated list of attachments
+        result = QStringList(entry->attachments()->keys()).join(", ");
+        return result;
+    }
+
+    return QVariant();
+}
+
+QVariant EntryModel::sortData(const Entry* entry, int column) const
+{
+    switch (column) {
+    case Username:
+        return entry->resolveMultiplePlaceholders(entry->username());
+    case Password:
+        return entry->resolveMultiplePlaceholders(entry->password());
+    case Expires:
+        // There seems to be no better way of expressing 'infinity'
+        return entry->timeInfo().expires() ? entry->timeInfo().expiryTime() : QDateTime(QDate(9999, 1, 1));
+    case Created:
+        return entry->timeInfo().creationTime();
+    case Modified:
+        return entry->timeInfo().lastModificationTime();
+    case Accessed:
+        return entry->timeInfo().lastAccessTime();
+    case Paperclip:
+        // Display entries with attachments above those without when
+        // sorting ascendingly (and vice versa when sorting descendingly)
+        return entry->attachments()->isEmpty() ? 1 : 0;
+    default:
+        // For all other columns, simply use data provided by Qt::Display-
+        // Role for sorting
+        return displayValue(entry, column);
+    }
+}
+
+/**
+ * Drop the cached strings of an entry, and of every entry that may
+ * resolve references to it.
+ */
+void EntryModel::invalidateCache(const Entry* entry)
+{
+    m_cache.remove(entry);
+
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        if (it.value().hasReferences) {
+            it = m_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 QVariant EntryModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     Q_UNUSED(orientation);
@@ -384,9 +685,16 @@ QMimeData* EntryModel::mimeData(const QModelIndexList& indexes) const
     }
 }
 
+bool EntryModel::isSearchResult(const Entry* entry) const
+{
+    // Entries moved to the recycle bin are not shown again
+    const Database* db = entry->group()->database();
+    return m_orgEntries.contains(entry) && (!db || entry->group() != db->metadata()->recycleBin());
+}
+
 void EntryModel::entryAboutToAdd(Entry* entry)
 {
-    if (!m_group && !m_orgEntries.contains(entry)) {
+    if (!m_group && !isSearchResult(entry)) {
         return;
     }
 
@@ -398,7 +706,7 @@ void EntryModel::entryAboutToAdd(Entry* entry)
 
 void EntryModel::entryAdded(Entry* entry)
 {
-    if (!m_group && !m_orgEntries.contains(entry)) {
+    if (!m_group && !isSearchResult(entry)) {
         return;
     }
 
@@ -410,35 +718,95 @@ void EntryModel::entryAdded(Entry* entry)
 
 void EntryModel::entryAboutToRemove(Entry* entry)
 {
-    beginRemoveRows(QModelIndex(), m_entries.indexOf(entry), m_entries.indexOf(entry));
+    invalidateCache(entry);
+
+    const int row = m_entries.indexOf(entry);
+    if (row == -1) {
+        m_pendingEntries.removeOne(entry);
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_removingRow = true;
     if (!m_group) {
-        m_entries.removeAll(entry);
+        m_entries.removeAt(row);
     }
 }
 
 void EntryModel::entryRemoved()
 {
+    if (!m_removingRow) {
+        return;
+    }
+
     if (m_group) {
         m_entries = m_group->entries();
     }
 
+    m_removingRow = false;
     endRemoveRows();
 }
 
+void EntryModel::databaseDestroyed(QObject* object)
+{
+    m_databases.removeAll(static_cast<Database*>(object));
+
+    for (int row = m_entries.size() - 1; row >= 0; --row) {
+        Entry* entry = m_entries.at(row);
+        if (entry->group()->database() == object) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_entries.removeAt(row);
+            m_orgEntries.remove(entry);
+            endRemoveRows();
+        }
+    }
+
+    for (auto it = m_pendingEntries.begin(); it != m_pendingEntries.end();) {
+        if ((*it)->group()->database() == object) {
+            m_orgEntries.remove(*it);
+            it = m_pendingEntries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_cache.clear();
+}
+
 void EntryModel::entryDataChanged(Entry* entry)
 {
+    invalidateCache(entry);
+
     int row = m_entries.indexOf(entry);
+    if (row == -1) {
+        return;
+    }
     emit dataChanged(index(row, 0), index(row, columnCount() - 1));
 }
 
+/**
+ * Drop all cached strings, e.g. before the database is locked.
+ */
+void EntryModel::clearCache()
+{
+    m_cache.clear();
+}
+
+void EntryModel::clearDisplayCache(int column)
+{
+    for (CachedEntry& cached : m_cache) {
+        cached.display[column] = QVariant();
+    }
+}
+
 void EntryModel::severConnections()
 {
     if (m_group) {
         disconnect(m_group, nullptr, this, nullptr);
     }
 
-    for (const Group* group : asConst(m_allGroups)) {
-        disconnect(group, nullptr, this, nullptr);
+    for (const Database* db : asConst(m_databases)) {
+        disconnect(db, nullptr, this, nullptr);
     }
 }
 
@@ -465,6 +833,7 @@ bool EntryModel::isUsernamesHidden() const
 void EntryModel::setUsernamesHidden(const bool hide)
 {
     m_hideUsernames = hide;
+    clearDisplayCache(Username);
     emit usernamesHiddenChanged();
 }
 
@@ -482,6 +851,7 @@ bool EntryModel::isPasswordsHidden() const
 void EntryModel::setPasswordsHidden(const bool hide)
 {
     m_hidePasswords = hide;
+    clearDisplayCache(Password);
     emit passwordsHiddenChanged();
 }
 
@@ -19,8 +19,13 @@
 #define KEEPASSX_ENTRYMODEL_H
 
 #include <QAbstractTableModel>
+#include <QFutureWatcher>
+#include <QHash>
 #include <QPixmap>
+#include <QSet>
+#include <QVector>
 
+class Database;
 class Entry;
 class Group;
 
@@ -48,6 +53,8 @@ public:
     explicit EntryModel(QObject* parent = nullptr);
     Entry* entryFromIndex(const QModelIndex& index) const;
     QModelIndex indexFromEntry(Entry* entry) const;
+    bool containsEntry(Entry* entry) const;
+    bool isSorting() const;
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -58,13 +65,17 @@ public:
     Qt::ItemFlags flags(const QModelIndex& modelIndex) const override;
     QStringList mimeTypes() const override;
     QMimeData* mimeData(const QModelIndexList& indexes) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
 
     void setEntryList(const QList<Entry*>& entries);
+    void fetchEntry(Entry* entry);
 
     bool isUsernamesHidden() const;
     void setUsernamesHidden(const bool hide);
     bool isPasswordsHidden() const;
     void setPasswordsHidden(const bool hide);
+    void clearCache();
 
     void setPaperClipPixmap(const QPixmap& paperclip);
 
@@ -73,11 +84,13 @@ signals:
     void switchedToSearchMode();
     void usernamesHiddenChanged();
     void passwordsHiddenChanged();
+    void entriesSorted();
 
 public slots:
     void setGroup(Group* group);
     void toggleUsernamesHidden(const bool hide);
     void togglePasswordsHidden(const bool hide);
+    void setSortOrder(int column, Qt::SortOrder order);
 
 private slots:
     void entryAboutToAdd(Entry* entry);
@@ -85,15 +98,45 @@ private slots:
     void entryAboutToRemove(Entry* entry);
     void entryRemoved();
     void entryDataChanged(Entry* entry);
+    void databaseDestroyed(QObject* object);
+    void startSort();
+    void sortFinished();
 
 private:
+    // Resolved display strings and sort keys of an entry, filled per cached column on first use
+    struct CachedEntry
+    {
+        QVector<QVariant> display;
+        QVector<QVariant> sortKey;
+        bool hasReferences;
+    };
+
+    CachedEntry& cachedEntry(const Entry* entry) const;
+    QVariant displayValue(const Entry* entry, int column) const;
+    QVariant sortKey(const Entry* entry, int column) const;
+    QVariant displayData(const Entry* entry, int column) const;
+    QVariant sortData(const Entry* entry, int column) const;
+    bool isSearchResult(const Entry* entry) const;
+    void fetchEntries(int count);
+    void scheduleSort();
+    void invalidateCache(const Entry* entry);
+    void clearDisplayCache(int column);
     void severConnections();
     void makeConnections(const Group* group);
 
     Group* m_group;
     QList<Entry*> m_entries;
-    QList<Entry*> m_orgEntries;
-    QList<const Group*> m_allGroups;
+    QList<Entry*> m_pendingEntries;
+    QSet<const Entry*> m_orgEntries;
+    QList<const Database*> m_databases;
+    mutable QHash<const Entry*, CachedEntry> m_cache;
+
+    int m_sortColumn;
+    Qt::SortOrder m_sortOrder;
+    bool m_sorting;
+    bool m_sortScheduled;
+    bool m_removingRow;
+    QFutureWatcher<QList<Entry*>>* m_sortWatcher;
 
     bool m_hideUsernames;
     bool m_hidePasswords;
@@ -102,6 +145,7 @@ private:
 
     static const QString HiddenContentDisplay;
     static const Qt::DateFormat DateFormat;
+    static const int FetchBatchSize;
 };
 
 #endif // KEEPASSX_ENTRYMODEL_H
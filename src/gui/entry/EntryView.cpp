@@ -101,6 +101,9 @@ EntryView::EntryView(QWidget* parent)
     connect(header(), SIGNAL(sectionMoved(int, int, int)), SIGNAL(viewStateChanged()));
     connect(header(), SIGNAL(sectionResized(int, int, int)), SIGNAL(viewStateChanged()));
     connect(header(), SIGNAL(sortIndicatorChanged(int, Qt::SortOrder)), SIGNAL(viewStateChanged()));
+    // Large search results are sorted by the model before they are fetched
+    connect(header(), SIGNAL(sortIndicatorChanged(int, Qt::SortOrder)), SLOT(sortEntries(int, Qt::SortOrder)));
+    connect(m_model, SIGNAL(entriesSorted()), SLOT(restoreCurrentEntry()));
 
     resetFixedColumns();
 
@@ -148,12 +151,14 @@ void EntryView::keyPressEvent(QKeyEvent* event)
 
 void EntryView::setGroup(Group* group)
 {
+    m_entryAfterSort.clear();
     m_model->setGroup(group);
     setFirstEntryActive();
 }
 
 void EntryView::setEntryList(const QList<Entry*>& entries)
 {
+    m_entryAfterSort.clear();
     m_model->setEntryList(entries);
     setFirstEntryActive();
 }
@@ -168,6 +173,29 @@ void EntryView::setFirstEntryActive()
     }
 }
 
+void EntryView::sortEntries(int column, Qt::SortOrder order)
+{
+    // Partially fetched results are reset while the model sorts them again,
+    // there is no current entry anymore until it is done
+    Entry* entry = currentEntry();
+    if (entry) {
+        m_entryAfterSort = entry;
+    }
+    m_model->setSortOrder(column, order);
+}
+
+void EntryView::restoreCurrentEntry()
+{
+    Entry* entry = m_entryAfterSort.data();
+    m_entryAfterSort.clear();
+
+    if (entry && m_model->containsEntry(entry)) {
+        setCurrentEntry(entry);
+    } else {
+        setFirstEntryActive();
+    }
+}
+
 bool EntryView::inSearchMode()
 {
     return m_inSearchMode;
@@ -208,6 +236,13 @@ int EntryView::numberOfSelectedEntries()
 
 void EntryView::setCurrentEntry(Entry* entry)
 {
+    if (m_model->isSorting()) {
+        // the entry has no row yet, it is selected once sorting is done
+        m_entryAfterSort = entry;
+        return;
+    }
+
+    m_model->fetchEntry(entry);
     selectionModel()->setCurrentIndex(m_sortModel->mapFromSource(m_model->indexFromEntry(entry)),
                                       QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
 }
@@ -288,6 +323,14 @@ void EntryView::setPasswordsHidden(const bool hide)
     m_model->setPasswordsHidden(hide);
 }
 
+/**
+ * Drop the cached display strings and sort keys (NOTE: just pass-through for m_model)
+ */
+void EntryView::clearCache()
+{
+    m_model->clearCache();
+}
+
 /**
  * Get current view state
  */
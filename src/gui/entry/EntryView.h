@@ -19,6 +19,7 @@
 #ifndef KEEPASSX_ENTRYVIEW_H
 #define KEEPASSX_ENTRYVIEW_H
 
+#include <QPointer>
 #include <QTreeView>
 
 #include "gui/entry/EntryModel.h"
@@ -42,16 +43,17 @@ public:
     void setEntryList(const QList<Entry*>& entries);
     bool inSearchMode();
     int numberOfSelectedEntries();
-    void setFirstEntryActive();
     bool isUsernamesHidden() const;
     void setUsernamesHidden(const bool hide);
     bool isPasswordsHidden() const;
     void setPasswordsHidden(const bool hide);
+    void clearCache();
     QByteArray viewState() const;
     bool setViewState(const QByteArray& state);
 
 public slots:
     void setGroup(Group* group);
+    void setFirstEntryActive();
 
 signals:
     void entryActivated(Entry* entry, EntryModel::ModelColumn column);
@@ -72,6 +74,8 @@ private slots:
     void fitColumnsToWindow();
     void fitColumnsToContents();
     void resetViewToDefaults();
+    void sortEntries(int column, Qt::SortOrder order);
+    void restoreCurrentEntry();
 
 private:
     void fillRemainingWidth(bool lastColumnOnly);
@@ -80,6 +84,7 @@ private:
     EntryModel* const m_model;
     SortFilterHideProxyModel* const m_sortModel;
     bool m_inSearchMode;
+    QPointer<Entry> m_entryAfterSort;
 
     QByteArray m_defaultListViewState;
     QByteArray m_defaultSearchViewState;
@@ -111,7 +111,7 @@ QModelIndex GroupModel::parent(Group* group) const
             // parent is the root group
             return createIndex(0, 0, parentGroup);
         } else {
-            return createIndex(grandParentGroup->children().indexOf(parentGroup), 0, parentGroup);
+            return createIndex(parentGroup->row(), 0, parentGroup);
         }
     }
 }
@@ -159,7 +159,7 @@ QModelIndex GroupModel::index(Group* group) const
     if (!group->parentGroup()) {
         row = 0;
     } else {
-        row = group->parentGroup()->children().indexOf(group);
+        row = group->row();
     }
 
     return createIndex(row, 0, group);
@@ -242,7 +242,7 @@ bool GroupModel::dropMimeData(const QMimeData* data,
             return false;
         }
 
-        if (parentGroup == dragGroup->parent() && row > parentGroup->children().indexOf(dragGroup)) {
+        if (parentGroup == dragGroup->parent() && row > dragGroup->row()) {
             row--;
         }
 
@@ -359,7 +359,7 @@ void GroupModel::groupAboutToRemove(Group* group)
 
     QModelIndex parentIndex = parent(group);
     Q_ASSERT(parentIndex.isValid());
-    int pos = group->parentGroup()->children().indexOf(group);
+    int pos = group->row();
     Q_ASSERT(pos != -1);
 
     beginRemoveRows(parentIndex, pos, pos);
@@ -390,7 +390,7 @@ void GroupModel::groupAboutToMove(Group* group, Group* toGroup, int pos)
 
     QModelIndex oldParentIndex = parent(group);
     QModelIndex newParentIndex = index(toGroup);
-    int oldPos = group->parentGroup()->children().indexOf(group);
+    int oldPos = group->row();
     if (group->parentGroup() == toGroup && pos > oldPos) {
         // beginMoveRows() has a bit different semantics than Group::setParent() and
         // QList::move() when the new position is greater than the old
@@ -19,10 +19,12 @@
 #include <QCommandLineParser>
 #include <QFile>
 #include <QTextStream>
+#include <QTimer>
 
 #include "config-keepassx.h"
 #include "core/Config.h"
 #include "core/Tools.h"
+#include "core/Trace.h"
 #include "core/Translator.h"
 #include "crypto/Crypto.h"
 #include "gui/Application.h"
@@ -60,8 +62,21 @@ static inline void earlyQNetworkAccessManagerWorkaround()
     qputenv("QT_BEARER_POLL_TIMEOUT", QByteArray::number(-1));
 }
 
+// Writes the trace on every return from main()
+struct TraceFinisher
+{
+    ~TraceFinisher()
+    {
+        Trace::finish();
+    }
+};
+
 int main(int argc, char** argv)
 {
+    // Started before anything else so the trace covers the whole startup
+    Trace::startFromEnvironment();
+    const TraceFinisher traceFinisher;
+
 #ifdef QT_NO_DEBUG
     Tools::disableCoreDumps();
 #endif
@@ -70,6 +85,7 @@ int main(int argc, char** argv)
     earlyQNetworkAccessManagerWorkaround();
 
     Application app(argc, argv);
+    Trace::mark("startup", "application created");
     Application::setApplicationName("keepassxc");
     Application::setApplicationVersion(KEEPASSX_VERSION);
     // don't set organizationName as that changes the return value of
@@ -94,6 +110,8 @@ int main(int argc, char** argv)
                                                         << "parent-window",
                                           QCoreApplication::translate("main", "Parent window handle"),
                                           "handle");
+    QCommandLineOption traceOption(
+        "trace", QCoreApplication::translate("main", "write a performance trace to file"), "file");
 
     parser.addHelpOption();
     QCommandLineOption versionOption = parser.addVersionOption();
@@ -101,8 +119,12 @@ int main(int argc, char** argv)
     parser.addOption(keyfileOption);
     parser.addOption(pwstdinOption);
     parser.addOption(parentWindowOption);
+    parser.addOption(traceOption);
 
     parser.process(app);
+    if (parser.isSet(traceOption)) {
+        Trace::start(parser.value(traceOption));
+    }
     const QStringList fileNames = parser.positionalArguments();
 
     if (app.isAlreadyRunning() && !parser.isSet(versionOption)) {
@@ -124,12 +146,14 @@ int main(int argc, char** argv)
         MessageBox::critical(nullptr, QCoreApplication::translate("Main", "KeePassXC - Error"), error);
         return 1;
     }
+    Trace::mark("startup", "crypto initialized");
 
     if (parser.isSet(configOption)) {
         Config::createConfigFromFile(parser.value(configOption));
     }
 
     Translator::installTranslators();
+    Trace::mark("startup", "translators installed");
 
 #ifdef Q_OS_MAC
     // Don't show menu icons on OSX
@@ -161,30 +185,42 @@ int main(int argc, char** argv)
         mainWindow.show();
     }
 
-    if (config()->get("OpenPreviousDatabasesOnStartup").toBool()) {
-        const QStringList fileNames = config()->get("LastOpenedDatabases").toStringList();
-        for (const QString& filename : fileNames) {
-            if (!filename.isEmpty() && QFile::exists(filename)) {
-                mainWindow.openDatabase(filename);
+    // Databases are opened once the main window is on screen
+    const bool pwstdin = parser.isSet(pwstdinOption);
+    const QString keyFile = parser.value(keyfileOption);
+    QObject::connect(
+        &mainWindow, &MainWindow::startupCompleted, &mainWindow, [&mainWindow, fileNames, pwstdin, keyFile]() {
+            TRACE_SPAN("startup", "open databases");
+            if (config()->get("OpenPreviousDatabasesOnStartup").toBool()) {
+                const QStringList lastFileNames = config()->get("LastOpenedDatabases").toStringList();
+                for (const QString& filename : lastFileNames) {
+                    if (!filename.isEmpty() && QFile::exists(filename)) {
+                        mainWindow.openDatabase(filename);
+                    }
+                }
             }
-        }
-    }
 
-    const bool pwstdin = parser.isSet(pwstdinOption);
-    for (const QString& filename : fileNames) {
-        QString password;
-        if (pwstdin) {
-            // we always need consume a line of STDIN if --pw-stdin is set to clear out the
-            // buffer for native messaging, even if the specified file does not exist
-            static QTextStream in(stdin, QIODevice::ReadOnly);
-            static QTextStream out(stdout, QIODevice::WriteOnly);
-            out << QCoreApplication::translate("Main", "Database password: ") << flush;
-            password = Utils::getPassword();
-        }
+            for (const QString& filename : fileNames) {
+                QString password;
+                if (pwstdin) {
+                    // we always need consume a line of STDIN if --pw-stdin is set to clear out the
+                    // buffer for native messaging, even if the specified file does not exist
+                    static QTextStream in(stdin, QIODevice::ReadOnly);
+                    static QTextStream out(stdout, QIODevice::WriteOnly);
+                    out << QCoreApplication::translate("Main", "Database password: ") << flush;
+                    password = Utils::getPassword();
+                }
+
+                if (!filename.isEmpty() && QFile::exists(filename)
+                    && !filename.endsWith(".json", Qt::CaseInsensitive)) {
+                    mainWindow.openDatabase(filename, password, keyFile);
+                }
+            }
+        });
 
-        if (!filename.isEmpty() && QFile::exists(filename) && !filename.endsWith(".json", Qt::CaseInsensitive)) {
-            mainWindow.openDatabase(filename, password, parser.value(keyfileOption));
-        }
+    if (minimizeOnStartup) {
+        // There may be no first paint to wait for
+        QTimer::singleShot(0, &mainWindow, SLOT(completeStartup()));
     }
 
     int exitCode = app.exec();
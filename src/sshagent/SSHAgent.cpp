@@ -19,6 +19,9 @@
 #include "SSHAgent.h"
 #include "BinaryStream.h"
 #include "KeeAgentSettings.h"
+#include "core/ListDeleter.h"
+
+#include <QtConcurrent>
 
 #ifndef Q_OS_WIN
 #include <QtNetwork>
@@ -38,10 +41,8 @@ SSHAgent::SSHAgent(QObject* parent)
 
 SSHAgent::~SSHAgent()
 {
-    for (QSet<OpenSSHKey> keys : m_keys.values()) {
-        for (OpenSSHKey key : keys) {
-            removeIdentity(key);
-        }
+    for (const QSet<OpenSSHKey>& keys : m_keys.values()) {
+        removeIdentities(keys);
     }
 }
 
@@ -76,25 +77,12 @@ bool SSHAgent::isAgentRunning() const
 bool SSHAgent::sendMessage(const QByteArray& in, QByteArray& out)
 {
 #ifndef Q_OS_WIN
-    QLocalSocket socket;
-    BinaryStream stream(&socket);
-
-    socket.connectToServer(m_socketPath);
-    if (!socket.waitForConnected(500)) {
-        m_error = tr("Agent connection failed.");
-        return false;
-    }
-
-    stream.writeString(in);
-    stream.flush();
-
-    if (!stream.readString(out)) {
-        m_error = tr("Agent protocol error.");
+    QList<QByteArray> responses;
+    if (!sendMessages(QList<QByteArray>() << in, responses)) {
         return false;
     }
 
-    socket.close();
-
+    out = responses.first();
     return true;
 #else
     HWND hWnd = FindWindowA("Pageant", "Pageant");
@@ -159,6 +147,64 @@ bool SSHAgent::sendMessage(const QByteArray& in, QByteArray& out)
 #endif
 }
 
+/**
+ * Send several requests to the agent and collect the responses in order.
+ * On Unix all requests are pipelined over a single connection.
+ */
+bool SSHAgent::sendMessages(const QList<QByteArray>& in, QList<QByteArray>& out)
+{
+    out.clear();
+
+#ifndef Q_OS_WIN
+    if (in.isEmpty()) {
+        return true;
+    }
+
+    QLocalSocket socket;
+    BinaryStream stream(&socket);
+
+    socket.connectToServer(m_socketPath);
+    if (!socket.waitForConnected(500)) {
+        m_error = tr("Agent connection failed.");
+        return false;
+    }
+
+    for (const QByteArray& request : in) {
+        stream.writeString(request);
+    }
+
+    while (socket.bytesToWrite() > 0) {
+        if (!stream.flush()) {
+            m_error = tr("Agent connection failed.");
+            return false;
+        }
+    }
+
+    for (int i = 0; i < in.size(); ++i) {
+        QByteArray response;
+        if (!stream.readString(response)) {
+            m_error = tr("Agent protocol error.");
+            return false;
+        }
+        out.append(response);
+    }
+
+    socket.close();
+
+    return true;
+#else
+    for (const QByteArray& request : in) {
+        QByteArray response;
+        if (!sendMessage(request, response)) {
+            return false;
+        }
+        out.append(response);
+    }
+
+    return true;
+#endif
+}
+
 bool SSHAgent::addIdentity(OpenSSHKey& key, quint32 lifetime, bool confirm)
 {
     if (!isAgentRunning()) {
@@ -166,6 +212,21 @@ bool SSHAgent::addIdentity(OpenSSHKey& key, quint32 lifetime, bool confirm)
         return false;
     }
 
+    QByteArray responseData;
+    if (!sendMessage(addIdentityRequest(key, lifetime, confirm), responseData)) {
+        return false;
+    }
+
+    if (responseData.length() < 1 || static_cast<quint8>(responseData[0]) != SSH_AGENT_SUCCESS) {
+        m_error = addIdentityError(lifetime, confirm);
+        return false;
+    }
+
+    return true;
+}
+
+QByteArray SSHAgent::addIdentityRequest(OpenSSHKey& key, quint32 lifetime, bool confirm) const
+{
     QByteArray requestData;
     BinaryStream request(&requestData);
 
@@ -181,27 +242,23 @@ bool SSHAgent::addIdentity(OpenSSHKey& key, quint32 lifetime, bool confirm)
         request.write(SSH_AGENT_CONSTRAIN_CONFIRM);
     }
 
-    QByteArray responseData;
-    if (!sendMessage(requestData, responseData)) {
-        return false;
-    }
-
-    if (responseData.length() < 1 || static_cast<quint8>(responseData[0]) != SSH_AGENT_SUCCESS) {
-        m_error =
-            tr("Agent refused this identity. Possible reasons include:") + "\n" + tr("The key has already been added.");
+    return requestData;
+}
 
-        if (lifetime > 0) {
-            m_error += "\n" + tr("Restricted lifetime is not supported by the agent (check options).");
-        }
+QString SSHAgent::addIdentityError(quint32 lifetime, bool confirm) const
+{
+    QString error =
+        tr("Agent refused this identity. Possible reasons include:") + "\n" + tr("The key has already been added.");
 
-        if (confirm) {
-            m_error += "\n" + tr("A confirmation request is not supported by the agent (check options).");
-        }
+    if (lifetime > 0) {
+        error += "\n" + tr("Restricted lifetime is not supported by the agent (check options).");
+    }
 
-        return false;
+    if (confirm) {
+        error += "\n" + tr("A confirmation request is not supported by the agent (check options).");
     }
 
-    return true;
+    return error;
 }
 
 bool SSHAgent::removeIdentity(OpenSSHKey& key)
@@ -211,6 +268,21 @@ bool SSHAgent::removeIdentity(OpenSSHKey& key)
         return false;
     }
 
+    QByteArray responseData;
+    if (!sendMessage(removeIdentityRequest(key), responseData)) {
+        return false;
+    }
+
+    if (responseData.length() < 1 || static_cast<quint8>(responseData[0]) != SSH_AGENT_SUCCESS) {
+        m_error = tr("Agent does not have this identity.");
+        return false;
+    }
+
+    return true;
+}
+
+QByteArray SSHAgent::removeIdentityRequest(OpenSSHKey& key) const
+{
     QByteArray requestData;
     BinaryStream request(&requestData);
 
@@ -221,17 +293,41 @@ bool SSHAgent::removeIdentity(OpenSSHKey& key)
     request.write(SSH_AGENTC_REMOVE_IDENTITY);
     request.writeString(keyData);
 
-    QByteArray responseData;
-    if (!sendMessage(requestData, responseData)) {
-        return false;
+    return requestData;
+}
+
+/**
+ * Remove several identities from the agent using a single connection.
+ */
+void SSHAgent::removeIdentities(QSet<OpenSSHKey> keys)
+{
+    if (keys.isEmpty()) {
+        return;
     }
 
-    if (responseData.length() < 1 || static_cast<quint8>(responseData[0]) != SSH_AGENT_SUCCESS) {
-        m_error = tr("Agent does not have this identity.");
-        return false;
+    if (!isAgentRunning()) {
+        m_error = tr("No agent running, cannot remove identity.");
+        emit error(m_error);
+        return;
     }
 
-    return true;
+    QList<QByteArray> requests;
+    for (OpenSSHKey key : keys) {
+        requests.append(removeIdentityRequest(key));
+    }
+
+    QList<QByteArray> responses;
+    if (!sendMessages(requests, responses)) {
+        emit error(m_error);
+        return;
+    }
+
+    for (const QByteArray& responseData : responses) {
+        if (responseData.length() < 1 || static_cast<quint8>(responseData[0]) != SSH_AGENT_SUCCESS) {
+            m_error = tr("Agent does not have this identity.");
+            emit error(m_error);
+        }
+    }
 }
 
 void SSHAgent::removeIdentityAtLock(const OpenSSHKey& key, const QUuid& uuid)
@@ -241,6 +337,79 @@ void SSHAgent::removeIdentityAtLock(const OpenSSHKey& key, const QUuid& uuid)
     m_keys[uuid].insert(copy);
 }
 
+/**
+ * Collect the key data and settings of an entry. Returns nullptr if the
+ * entry has no SSH key that may be used.
+ */
+SSHAgent::KeyRequest* SSHAgent::keyRequest(Entry* e) const
+{
+    if (!e->attachments()->hasKey("KeeAgent.settings")) {
+        return nullptr;
+    }
+
+    QScopedPointer<KeyRequest> request(new KeyRequest());
+    request->settings.fromXml(e->attachments()->value("KeeAgent.settings"));
+
+    if (!request->settings.allowUseOfSshKey()) {
+        return nullptr;
+    }
+
+    if (request->settings.selectedType() == "attachment") {
+        request->fileName = request->settings.attachmentName();
+        request->keyData = e->attachments()->value(request->fileName);
+    } else if (!request->settings.fileName().isEmpty()) {
+        QFile file(request->settings.fileName());
+        QFileInfo fileInfo(file);
+
+        request->fileName = fileInfo.fileName();
+
+        if (file.size() > 1024 * 1024) {
+            return nullptr;
+        }
+
+        if (!file.open(QIODevice::ReadOnly)) {
+            return nullptr;
+        }
+
+        request->keyData = file.readAll();
+    }
+
+    if (request->keyData.isEmpty()) {
+        return nullptr;
+    }
+
+    request->passphrase = e->password();
+    request->userName = e->username();
+    request->opened = false;
+
+    return request.take();
+}
+
+/**
+ * Parse and decrypt a key. This runs on a worker thread and must not
+ * touch the database.
+ */
+void SSHAgent::openKey(KeyRequest* request)
+{
+    if (!request->key.parse(request->keyData)) {
+        return;
+    }
+
+    if (!request->key.openPrivateKey(request->passphrase)) {
+        return;
+    }
+
+    if (request->key.comment().isEmpty()) {
+        request->key.setComment(request->userName);
+    }
+
+    if (request->key.comment().isEmpty()) {
+        request->key.setComment(request->fileName);
+    }
+
+    request->opened = true;
+}
+
 void SSHAgent::databaseModeChanged(DatabaseWidget::Mode mode)
 {
     DatabaseWidget* widget = qobject_cast<DatabaseWidget*>(sender());
@@ -252,14 +421,11 @@ void SSHAgent::databaseModeChanged(DatabaseWidget::Mode mode)
     const QUuid& uuid = widget->database()->uuid();
 
     if (mode == DatabaseWidget::LockedMode && m_keys.contains(uuid)) {
-
-        QSet<OpenSSHKey> keys = m_keys.take(uuid);
-        for (OpenSSHKey key : keys) {
-            if (!removeIdentity(key)) {
-                emit error(m_error);
-            }
-        }
+        removeIdentities(m_keys.take(uuid));
     } else if (mode == DatabaseWidget::ViewMode && !m_keys.contains(uuid)) {
+        QList<KeyRequest*> requests;
+        ListDeleter<KeyRequest*> requestsDeleter(&requests);
+
         for (Entry* e : widget->database()->rootGroup()->entriesRecursive()) {
 
             if (widget->database()->metadata()->recycleBinEnabled()
@@ -267,75 +433,62 @@ void SSHAgent::databaseModeChanged(DatabaseWidget::Mode mode)
                 continue;
             }
 
-            if (!e->attachments()->hasKey("KeeAgent.settings")) {
-                continue;
-            }
-
-            KeeAgentSettings settings;
-            settings.fromXml(e->attachments()->value("KeeAgent.settings"));
-
-            if (!settings.allowUseOfSshKey()) {
-                continue;
+            KeyRequest* request = keyRequest(e);
+            if (request) {
+                requests.append(request);
             }
+        }
 
-            QByteArray keyData;
-            QString fileName;
-            if (settings.selectedType() == "attachment") {
-                fileName = settings.attachmentName();
-                keyData = e->attachments()->value(fileName);
-            } else if (!settings.fileName().isEmpty()) {
-                QFile file(settings.fileName());
-                QFileInfo fileInfo(file);
-
-                fileName = fileInfo.fileName();
-
-                if (file.size() > 1024 * 1024) {
-                    continue;
-                }
-
-                if (!file.open(QIODevice::ReadOnly)) {
-                    continue;
-                }
-
-                keyData = file.readAll();
-            }
+        // Key derivation is deliberately slow, decrypt all keys concurrently
+        QtConcurrent::blockingMap(requests, &SSHAgent::openKey);
 
-            if (keyData.isEmpty()) {
+        QList<QByteArray> addRequests;
+        QList<KeyRequest*> addedKeys;
+        for (KeyRequest* request : requests) {
+            if (!request->opened) {
                 continue;
             }
 
-            OpenSSHKey key;
-
-            if (!key.parse(keyData)) {
-                continue;
+            if (request->settings.removeAtDatabaseClose()) {
+                removeIdentityAtLock(request->key, uuid);
             }
 
-            if (!key.openPrivateKey(e->password())) {
-                continue;
-            }
+            if (request->settings.addAtDatabaseOpen()) {
+                quint32 lifetime = 0;
 
-            if (key.comment().isEmpty()) {
-                key.setComment(e->username());
-            }
+                if (request->settings.useLifetimeConstraintWhenAdding()) {
+                    lifetime = request->settings.lifetimeConstraintDuration();
+                }
 
-            if (key.comment().isEmpty()) {
-                key.setComment(fileName);
+                addRequests.append(
+                    addIdentityRequest(request->key, lifetime, request->settings.useConfirmConstraintWhenAdding()));
+                addedKeys.append(request);
             }
+        }
 
-            if (settings.removeAtDatabaseClose()) {
-                removeIdentityAtLock(key, uuid);
-            }
+        if (addRequests.isEmpty()) {
+            return;
+        }
 
-            if (settings.addAtDatabaseOpen()) {
-                int lifetime = 0;
+        if (!isAgentRunning()) {
+            m_error = tr("No agent running, cannot add identity.");
+            emit error(m_error);
+            return;
+        }
 
-                if (settings.useLifetimeConstraintWhenAdding()) {
-                    lifetime = settings.lifetimeConstraintDuration();
-                }
+        QList<QByteArray> responses;
+        if (!sendMessages(addRequests, responses)) {
+            emit error(m_error);
+            return;
+        }
 
-                if (!addIdentity(key, lifetime, settings.useConfirmConstraintWhenAdding())) {
-                    emit error(m_error);
-                }
+        for (int i = 0; i < responses.size(); ++i) {
+            const QByteArray& responseData = responses[i];
+            if (responseData.length() < 1 || static_cast<quint8>(responseData[0]) != SSH_AGENT_SUCCESS) {
+                const KeeAgentSettings& settings = addedKeys[i]->settings;
+                quint32 lifetime = settings.useLifetimeConstraintWhenAdding() ? settings.lifetimeConstraintDuration() : 0;
+                m_error = addIdentityError(lifetime, settings.useConfirmConstraintWhenAdding());
+                emit error(m_error);
             }
         }
     }
@@ -19,6 +19,7 @@
 #ifndef AGENTCLIENT_H
 #define AGENTCLIENT_H
 
+#include "KeeAgentSettings.h"
 #include "OpenSSHKey.h"
 #include <QList>
 #include <QtCore>
@@ -57,10 +58,28 @@ private:
     const quint8 SSH_AGENT_CONSTRAIN_LIFETIME = 1;
     const quint8 SSH_AGENT_CONSTRAIN_CONFIRM = 2;
 
+    struct KeyRequest
+    {
+        KeeAgentSettings settings;
+        QByteArray keyData;
+        QString passphrase;
+        QString fileName;
+        QString userName;
+        OpenSSHKey key;
+        bool opened;
+    };
+
     explicit SSHAgent(QObject* parent = nullptr);
     ~SSHAgent();
 
     bool sendMessage(const QByteArray& in, QByteArray& out);
+    bool sendMessages(const QList<QByteArray>& in, QList<QByteArray>& out);
+    QByteArray addIdentityRequest(OpenSSHKey& key, quint32 lifetime, bool confirm) const;
+    QString addIdentityError(quint32 lifetime, bool confirm) const;
+    QByteArray removeIdentityRequest(OpenSSHKey& key) const;
+    void removeIdentities(QSet<OpenSSHKey> keys);
+    KeyRequest* keyRequest(Entry* entry) const;
+    static void openKey(KeyRequest* request);
 
     static SSHAgent* m_instance;
 
@@ -15,6 +15,7 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <QtConcurrent>
 #include <QtCore>
 
 extern "C" {
@@ -50,39 +51,134 @@ extern "C" {
 #define BCRYPT_WORDS 8
 #define BCRYPT_HASHSIZE (BCRYPT_WORDS * 4)
 #define SHA512_DIGEST_LENGTH 64
+#define SHA512_DIGEST_WORDS (SHA512_DIGEST_LENGTH / 4)
 
 // FIXME: explicit_bzero exists to ensure bzero is not optimized out
 #define explicit_bzero bzero
 
+/*
+ * Blowfish core specialised for bcrypt_hash.
+ *
+ * Both the key and the data are always SHA512 digests, so the stream of
+ * key words repeats every 16 words. The digests are converted to words
+ * once instead of re-extracting every word byte by byte, and the cipher
+ * rounds work on local copies of the state.
+ */
+
+#define BCRYPT_F(s, x)                                                                                                 \
+    ((((s)[(x) >> 24] + (s)[0x100 + (((x) >> 16) & 0xff)]) ^ (s)[0x200 + (((x) >> 8) & 0xff)])                         \
+     + (s)[0x300 + ((x)&0xff)])
+
+#define BCRYPT_ROUND(s, p, i, j, n) (i ^= BCRYPT_F(s, j) ^ (p)[n])
+
+static inline void bcrypt_encipher(const quint32* s, const quint32* p, quint32& xl, quint32& xr)
+{
+    quint32 l = xl ^ p[0];
+    quint32 r = xr;
+
+    BCRYPT_ROUND(s, p, r, l, 1);
+    BCRYPT_ROUND(s, p, l, r, 2);
+    BCRYPT_ROUND(s, p, r, l, 3);
+    BCRYPT_ROUND(s, p, l, r, 4);
+    BCRYPT_ROUND(s, p, r, l, 5);
+    BCRYPT_ROUND(s, p, l, r, 6);
+    BCRYPT_ROUND(s, p, r, l, 7);
+    BCRYPT_ROUND(s, p, l, r, 8);
+    BCRYPT_ROUND(s, p, r, l, 9);
+    BCRYPT_ROUND(s, p, l, r, 10);
+    BCRYPT_ROUND(s, p, r, l, 11);
+    BCRYPT_ROUND(s, p, l, r, 12);
+    BCRYPT_ROUND(s, p, r, l, 13);
+    BCRYPT_ROUND(s, p, l, r, 14);
+    BCRYPT_ROUND(s, p, r, l, 15);
+    BCRYPT_ROUND(s, p, l, r, 16);
+
+    xl = r ^ p[17];
+    xr = l;
+}
+
+/*
+ * Equivalent to Blowfish_expandstate() (withData = true) and
+ * Blowfish_expand0state() (withData = false) for 64 byte keys and data.
+ */
+template <bool withData>
+static void bcrypt_expand(blf_ctx* c, const quint32* data, const quint32* key)
+{
+    quint32* s = c->S[0];
+    quint32* p = c->P;
+    quint32 datal = 0;
+    quint32 datar = 0;
+    int j = 0;
+
+    for (int i = 0; i < BLF_N + 2; i++) {
+        p[i] ^= key[i % SHA512_DIGEST_WORDS];
+    }
+
+    for (int i = 0; i < BLF_N + 2; i += 2) {
+        if (withData) {
+            datal ^= data[j];
+            datar ^= data[j + 1];
+            j = (j + 2) % SHA512_DIGEST_WORDS;
+        }
+        bcrypt_encipher(s, p, datal, datar);
+
+        p[i] = datal;
+        p[i + 1] = datar;
+    }
+
+    for (int i = 0; i < 4 * 256; i += 2) {
+        if (withData) {
+            datal ^= data[j];
+            datar ^= data[j + 1];
+            j = (j + 2) % SHA512_DIGEST_WORDS;
+        }
+        bcrypt_encipher(s, p, datal, datar);
+
+        s[i] = datal;
+        s[i + 1] = datar;
+    }
+}
+
+static void bcrypt_words(const quint8* in, quint32* out, int words)
+{
+    for (int i = 0; i < words; i++) {
+        out[i] = (static_cast<quint32>(in[4 * i]) << 24) | (static_cast<quint32>(in[4 * i + 1]) << 16)
+                 | (static_cast<quint32>(in[4 * i + 2]) << 8) | static_cast<quint32>(in[4 * i + 3]);
+    }
+}
+
 static void
 bcrypt_hash(const quint8* sha2pass, const quint8* sha2salt, quint8* out)
 {
     blf_ctx state;
-    quint8 ciphertext[BCRYPT_HASHSIZE] = // "OxychromaticBlowfishSwatDynamite"
+    static const quint8 ciphertext[BCRYPT_HASHSIZE] = // "OxychromaticBlowfishSwatDynamite"
         { 0x4f, 0x78, 0x79, 0x63, 0x68, 0x72, 0x6f, 0x6d,
           0x61, 0x74, 0x69, 0x63, 0x42, 0x6c, 0x6f, 0x77,
           0x66, 0x69, 0x73, 0x68, 0x53, 0x77, 0x61, 0x74,
           0x44, 0x79, 0x6e, 0x61, 0x6d, 0x69, 0x74, 0x65 };
     quint32 cdata[BCRYPT_WORDS];
+    quint32 passWords[SHA512_DIGEST_WORDS];
+    quint32 saltWords[SHA512_DIGEST_WORDS];
     int i;
-    quint16 j;
-    size_t shalen = SHA512_DIGEST_LENGTH;
+
+    bcrypt_words(sha2pass, passWords, SHA512_DIGEST_WORDS);
+    bcrypt_words(sha2salt, saltWords, SHA512_DIGEST_WORDS);
 
     /* key expansion */
     Blowfish_initstate(&state);
-    Blowfish_expandstate(&state, sha2salt, shalen, sha2pass, shalen);
+    bcrypt_expand<true>(&state, saltWords, passWords);
     for (i = 0; i < 64; i++) {
-        Blowfish_expand0state(&state, sha2salt, shalen);
-        Blowfish_expand0state(&state, sha2pass, shalen);
+        bcrypt_expand<false>(&state, nullptr, saltWords);
+        bcrypt_expand<false>(&state, nullptr, passWords);
     }
 
     /* encryption */
-    j = 0;
-    for (i = 0; i < BCRYPT_WORDS; i++)
-        cdata[i] = Blowfish_stream2word(ciphertext, sizeof(ciphertext),
-            &j);
-    for (i = 0; i < 64; i++)
-        blf_enc(&state, cdata, sizeof(cdata) / sizeof(uint64_t));
+    bcrypt_words(ciphertext, cdata, BCRYPT_WORDS);
+    for (i = 0; i < 64; i++) {
+        for (int j = 0; j < BCRYPT_WORDS; j += 2) {
+            bcrypt_encipher(state.S[0], state.P, cdata[j], cdata[j + 1]);
+        }
+    }
 
     /* copy out */
     for (i = 0; i < BCRYPT_WORDS; i++) {
@@ -93,63 +189,86 @@ bcrypt_hash(const quint8* sha2pass, const quint8* sha2salt, quint8* out)
     }
 
     /* zap */
-    explicit_bzero(ciphertext, sizeof(ciphertext));
     explicit_bzero(cdata, sizeof(cdata));
+    explicit_bzero(passWords, sizeof(passWords));
+    explicit_bzero(saltWords, sizeof(saltWords));
     explicit_bzero(&state, sizeof(state));
 }
 
-int bcrypt_pbkdf(const QByteArray& pass, const QByteArray& salt, QByteArray& key, quint32 rounds)
+/*
+ * Compute one output block of the key. Every block only depends on its
+ * own counter, so the blocks can be computed concurrently.
+ */
+static void bcrypt_pbkdf_block(const QByteArray& sha2pass, const QByteArray& salt, quint32 count, quint32 rounds, quint8* out)
 {
     QCryptographicHash ctx(QCryptographicHash::Sha512);
-    QByteArray sha2pass;
     QByteArray sha2salt;
-    quint8 out[BCRYPT_HASHSIZE];
     quint8 tmpout[BCRYPT_HASHSIZE];
     quint8 countsalt[4];
 
+    countsalt[0] = (count >> 24) & 0xff;
+    countsalt[1] = (count >> 16) & 0xff;
+    countsalt[2] = (count >> 8) & 0xff;
+    countsalt[3] = count & 0xff;
+
+    /* first round, salt is salt */
+    ctx.addData(salt);
+    ctx.addData(reinterpret_cast<char *>(countsalt), sizeof(countsalt));
+    sha2salt = ctx.result();
+
+    bcrypt_hash(reinterpret_cast<const quint8 *>(sha2pass.constData()), reinterpret_cast<const quint8 *>(sha2salt.constData()), tmpout);
+    memcpy(out, tmpout, sizeof(tmpout));
+
+    for (quint32 i = 1; i < rounds; i++) {
+        /* subsequent rounds, salt is previous output */
+        ctx.reset();
+        ctx.addData(reinterpret_cast<char *>(tmpout), sizeof(tmpout));
+        sha2salt = ctx.result();
+        bcrypt_hash(reinterpret_cast<const quint8 *>(sha2pass.constData()), reinterpret_cast<const quint8 *>(sha2salt.constData()), tmpout);
+        for (quint32 j = 0; j < sizeof(tmpout); j++)
+            out[j] ^= tmpout[j];
+    }
+
+    /* zap */
+    explicit_bzero(tmpout, sizeof(tmpout));
+}
+
+int bcrypt_pbkdf(const QByteArray& pass, const QByteArray& salt, QByteArray& key, quint32 rounds)
+{
+    QCryptographicHash ctx(QCryptographicHash::Sha512);
+    QByteArray sha2pass;
+
     /* nothing crazy */
     if (rounds < 1) {
         return -1;
     }
 
     if (pass.isEmpty() || salt.isEmpty() || key.isEmpty() ||
-        static_cast<quint32>(key.length()) > sizeof(out) * sizeof(out)) {
+        static_cast<quint32>(key.length()) > BCRYPT_HASHSIZE * BCRYPT_HASHSIZE) {
         return -1;
     }
 
-    quint32 stride = (key.length() + sizeof(out) - 1) / sizeof(out);
+    quint32 stride = (key.length() + BCRYPT_HASHSIZE - 1) / BCRYPT_HASHSIZE;
     quint32 amt = (key.length() + stride - 1) / stride;
 
     /* collapse password */
-    ctx.reset();
     ctx.addData(pass);
     sha2pass = ctx.result();
 
-    /* generate key, sizeof(out) at a time */
-    for (quint32 count = 1, keylen = key.length(); keylen > 0; count++) {
-        countsalt[0] = (count >> 24) & 0xff;
-        countsalt[1] = (count >> 16) & 0xff;
-        countsalt[2] = (count >> 8) & 0xff;
-        countsalt[3] = count & 0xff;
-
-        /* first round, salt is salt */
-        ctx.reset();
-        ctx.addData(salt);
-        ctx.addData(reinterpret_cast<char *>(countsalt), sizeof(countsalt));
-        sha2salt = ctx.result();
+    /* generate all blocks of the key concurrently, the first one on this thread */
+    QVector<quint8> blocks(stride * BCRYPT_HASHSIZE);
+    QList<QFuture<void>> futures;
+    for (quint32 count = 2; count <= stride; count++) {
+        futures.append(QtConcurrent::run(
+            bcrypt_pbkdf_block, sha2pass, salt, count, rounds, blocks.data() + (count - 1) * BCRYPT_HASHSIZE));
+    }
+    bcrypt_pbkdf_block(sha2pass, salt, 1, rounds, blocks.data());
+    for (QFuture<void>& future : futures) {
+        future.waitForFinished();
+    }
 
-        bcrypt_hash(reinterpret_cast<quint8 *>(sha2pass.data()), reinterpret_cast<quint8 *>(sha2salt.data()), tmpout);
-        memcpy(out, tmpout, sizeof(out));
-
-        for (quint32 i = 1; i < rounds; i++) {
-            /* subsequent rounds, salt is previous output */
-            ctx.reset();
-            ctx.addData(reinterpret_cast<char *>(tmpout), sizeof(tmpout));
-            sha2salt = ctx.result();
-            bcrypt_hash(reinterpret_cast<quint8 *>(sha2pass.data()), reinterpret_cast<quint8 *>(sha2salt.data()), tmpout);
-            for (quint32 j = 0; j < sizeof(out); j++)
-                out[j] ^= tmpout[j];
-        }
+    for (quint32 count = 1, keylen = key.length(); keylen > 0; count++) {
+        const quint8* out = blocks.constData() + (count - 1) * BCRYPT_HASHSIZE;
 
         /*
          * pbkdf2 deviation: output the key material non-linearly.
@@ -166,7 +285,7 @@ int bcrypt_pbkdf(const QByteArray& pass, const QByteArray& salt, QByteArray& key
     }
 
     /* zap */
-    explicit_bzero(out, sizeof(out));
+    explicit_bzero(blocks.data(), blocks.size());
 
     return 0;
 }
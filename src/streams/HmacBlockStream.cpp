@@ -18,6 +18,7 @@
 #include "HmacBlockStream.h"
 
 #include "core/Endian.h"
+#include "core/Trace.h"
 #include "crypto/CryptoHash.h"
 
 const QSysInfo::Endian HmacBlockStream::ByteOrder = QSysInfo::LittleEndian;
@@ -123,6 +124,8 @@ qint64 HmacBlockStream::readData(char* data, qint64 maxSize)
 
 bool HmacBlockStream::readHashedBlock()
 {
+    TRACE_SPAN("streams", "HmacBlockStream::readHashedBlock");
+
     if (m_eof) {
         return false;
     }
@@ -208,6 +211,8 @@ qint64 HmacBlockStream::writeData(const char* data, qint64 maxSize)
 
 bool HmacBlockStream::writeHashedBlock()
 {
+    TRACE_SPAN("streams", "HmacBlockStream::writeHashedBlock");
+
     CryptoHash hasher(CryptoHash::Sha256, true);
     hasher.setKey(getCurrentHmacKey());
     hasher.addData(Endian::sizedIntToBytes<quint64>(m_blockIndex, ByteOrder));
@@ -0,0 +1,270 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ParallelGzipStream.h"
+
+#include <QThread>
+#include <QtConcurrent>
+
+#include <cstring>
+#include <zlib.h>
+
+#include "core/Trace.h"
+
+namespace
+{
+    const int DefaultChunkSize = 128 * 1024;
+    // Largest distance a deflate match may reach back
+    const int DictionarySize = 32 * 1024;
+
+    ParallelGzipStream::Chunk deflateChunk(const QByteArray& input, const QByteArray& dictionary, int level, bool last)
+    {
+        TRACE_SPAN("streams", "ParallelGzipStream::deflateChunk");
+
+        ParallelGzipStream::Chunk chunk;
+        chunk.crc = crc32(0, reinterpret_cast<const Bytef*>(input.constData()), static_cast<uInt>(input.size()));
+        chunk.inputSize = input.size();
+        chunk.ok = false;
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        // Raw deflate, the gzip header and trailer are written by the stream
+        if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return chunk;
+        }
+        if (!dictionary.isEmpty()
+            && deflateSetDictionary(&stream,
+                                    reinterpret_cast<const Bytef*>(dictionary.constData()),
+                                    static_cast<uInt>(dictionary.size()))
+                   != Z_OK) {
+            deflateEnd(&stream);
+            return chunk;
+        }
+
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+        stream.avail_in = static_cast<uInt>(input.size());
+
+        const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+        // The bound does not include the sync flush marker
+        chunk.data.resize(static_cast<int>(deflateBound(&stream, stream.avail_in)) + 16);
+        int produced = 0;
+        while (true) {
+            stream.next_out = reinterpret_cast<Bytef*>(chunk.data.data() + produced);
+            stream.avail_out = static_cast<uInt>(chunk.data.size() - produced);
+            const int result = deflate(&stream, flush);
+            produced = chunk.data.size() - static_cast<int>(stream.avail_out);
+
+            if (result == Z_STREAM_ERROR) {
+                deflateEnd(&stream);
+                return chunk;
+            }
+            if (last ? result == Z_STREAM_END : (stream.avail_in == 0 && stream.avail_out > 0)) {
+                break;
+            }
+            chunk.data.resize(chunk.data.size() * 2);
+        }
+
+        deflateEnd(&stream);
+        chunk.data.resize(produced);
+        chunk.ok = true;
+        return chunk;
+    }
+} // namespace
+
+ParallelGzipStream::ParallelGzipStream(QIODevice* baseDevice, int compressionLevel)
+    : ParallelGzipStream(baseDevice, compressionLevel, DefaultChunkSize)
+{
+}
+
+ParallelGzipStream::ParallelGzipStream(QIODevice* baseDevice, int compressionLevel, int chunkSize)
+    : LayeredStream(baseDevice)
+    , m_compressionLevel(compressionLevel)
+    , m_chunkSize(chunkSize)
+    , m_maxPendingChunks(qMax(2, QThread::idealThreadCount() * 2))
+{
+    init();
+}
+
+ParallelGzipStream::~ParallelGzipStream()
+{
+    close();
+}
+
+void ParallelGzipStream::init()
+{
+    m_buffer.clear();
+    m_dictionary.clear();
+    m_pendingChunks.clear();
+    m_crc = crc32(0, Z_NULL, 0);
+    m_inputSize = 0;
+    m_headerWritten = false;
+    m_finished = false;
+    m_error = false;
+}
+
+bool ParallelGzipStream::open(QIODevice::OpenMode mode)
+{
+    if (mode & QIODevice::ReadOnly) {
+        qWarning("ParallelGzipStream::open: Only writing is supported.");
+        return false;
+    }
+
+    init();
+    return LayeredStream::open(mode);
+}
+
+/**
+ * Write the remaining data and the gzip trailer, further data starts a new member.
+ *
+ * @return false if writing to the base device failed
+ */
+bool ParallelGzipStream::reset()
+{
+    if (isWritable() && !m_finished) {
+        return finish();
+    }
+    return !m_error;
+}
+
+void ParallelGzipStream::close()
+{
+    if (isWritable() && !m_finished) {
+        finish();
+    }
+
+    LayeredStream::close();
+}
+
+qint64 ParallelGzipStream::readData(char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 ParallelGzipStream::writeData(const char* data, qint64 maxSize)
+{
+    Q_ASSERT(maxSize >= 0);
+
+    if (m_error) {
+        return -1;
+    }
+    if (m_finished) {
+        // Data written after a reset starts a new gzip member
+        init();
+    }
+
+    qint64 bytesRemaining = maxSize;
+    qint64 offset = 0;
+
+    while (bytesRemaining > 0) {
+        qint64 bytesToCopy = qMin(bytesRemaining, static_cast<qint64>(m_chunkSize - m_buffer.size()));
+
+        m_buffer.append(data + offset, static_cast<int>(bytesToCopy));
+
+        offset += bytesToCopy;
+        bytesRemaining -= bytesToCopy;
+
+        if (m_buffer.size() == m_chunkSize && !submitChunk(false)) {
+            return -1;
+        }
+    }
+
+    return maxSize;
+}
+
+bool ParallelGzipStream::submitChunk(bool last)
+{
+    const QByteArray input = m_buffer;
+    const QByteArray dictionary = m_dictionary;
+    m_dictionary = m_buffer.right(DictionarySize);
+    m_buffer.clear();
+
+    // Small streams are deflated right away, it is not worth a thread
+    if (last && m_pendingChunks.isEmpty()) {
+        return writeChunk(deflateChunk(input, dictionary, m_compressionLevel, true));
+    }
+
+    m_pendingChunks.enqueue(QtConcurrent::run(deflateChunk, input, dictionary, m_compressionLevel, last));
+    while (m_pendingChunks.size() > (last ? 0 : m_maxPendingChunks)) {
+        if (!writeChunk(m_pendingChunks.dequeue().result())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParallelGzipStream::writeChunk(const Chunk& chunk)
+{
+    if (m_error) {
+        return false;
+    }
+
+    if (!chunk.ok) {
+        m_error = true;
+        setErrorString(tr("Compression failed."));
+        return false;
+    }
+
+    if (!m_headerWritten) {
+        // Deflate, no flags, no modification time, unknown OS
+        static const char header[] = {'\x1f', '\x8b', '\x08', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\xff'};
+        if (m_baseDevice->write(header, sizeof(header)) != static_cast<qint64>(sizeof(header))) {
+            m_error = true;
+            setErrorString(m_baseDevice->errorString());
+            return false;
+        }
+        m_headerWritten = true;
+    }
+
+    if (m_baseDevice->write(chunk.data) != chunk.data.size()) {
+        m_error = true;
+        setErrorString(m_baseDevice->errorString());
+        return false;
+    }
+
+    m_crc = crc32_combine(m_crc, chunk.crc, static_cast<z_off_t>(chunk.inputSize));
+    m_inputSize += chunk.inputSize;
+    return true;
+}
+
+bool ParallelGzipStream::finish()
+{
+    m_finished = true;
+    if (m_error) {
+        // The workers only hold copies of their input, their results can be dropped
+        m_pendingChunks.clear();
+        return false;
+    }
+
+    if (!submitChunk(true)) {
+        return false;
+    }
+
+    char trailer[8];
+    for (int i = 0; i < 4; ++i) {
+        trailer[i] = static_cast<char>((m_crc >> (8 * i)) & 0xff);
+        trailer[i + 4] = static_cast<char>((static_cast<quint64>(m_inputSize) >> (8 * i)) & 0xff);
+    }
+    if (m_baseDevice->write(trailer, sizeof(trailer)) != static_cast<qint64>(sizeof(trailer))) {
+        m_error = true;
+        setErrorString(m_baseDevice->errorString());
+        return false;
+    }
+
+    return true;
+}
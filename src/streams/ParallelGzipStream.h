@@ -0,0 +1,81 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_PARALLELGZIPSTREAM_H
+#define KEEPASSXC_PARALLELGZIPSTREAM_H
+
+#include <QFuture>
+#include <QQueue>
+
+#include "streams/LayeredStream.h"
+
+/**
+ * Write-only stream producing a single gzip member, like pigz.
+ *
+ * The input is split into chunks which are deflated on the global thread
+ * pool. Every chunk uses the end of the previous one as its dictionary and
+ * ends on a sync flush boundary, so the compressed chunks join to one deflate
+ * stream. The chunk CRCs are combined for the gzip trailer.
+ */
+class ParallelGzipStream : public LayeredStream
+{
+    Q_OBJECT
+
+public:
+    // Same as Z_DEFAULT_COMPRESSION
+    static const int DefaultCompressionLevel = -1;
+
+    explicit ParallelGzipStream(QIODevice* baseDevice, int compressionLevel = DefaultCompressionLevel);
+    ParallelGzipStream(QIODevice* baseDevice, int compressionLevel, int chunkSize);
+    ~ParallelGzipStream();
+
+    bool open(QIODevice::OpenMode mode) override;
+    bool reset() override;
+    void close() override;
+
+    struct Chunk
+    {
+        QByteArray data;
+        quint32 crc;
+        qint64 inputSize;
+        bool ok;
+    };
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    void init();
+    bool submitChunk(bool last);
+    bool writeChunk(const Chunk& chunk);
+    bool finish();
+
+    const int m_compressionLevel;
+    const int m_chunkSize;
+    const int m_maxPendingChunks;
+    QByteArray m_buffer;
+    QByteArray m_dictionary;
+    QQueue<QFuture<Chunk>> m_pendingChunks;
+    quint32 m_crc;
+    qint64 m_inputSize;
+    bool m_headerWritten;
+    bool m_finished;
+    bool m_error;
+};
+
+#endif // KEEPASSXC_PARALLELGZIPSTREAM_H
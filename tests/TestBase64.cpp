@@ -0,0 +1,88 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "TestBase64.h"
+#include "TestGlobal.h"
+#include "core/Base64.h"
+
+QTEST_GUILESS_MAIN(TestBase64)
+
+namespace
+{
+    QByteArray testData(int size)
+    {
+        QByteArray data(size, '\0');
+        for (int i = 0; i < size; ++i) {
+            data[i] = static_cast<char>((i * 167 + size * 13) ^ (i >> 3));
+        }
+        return data;
+    }
+} // namespace
+
+void TestBase64::testEncode()
+{
+    QCOMPARE(Base64::encode(QByteArray()), QByteArray());
+    QCOMPARE(Base64::encode("f"), QByteArray("Zg=="));
+    QCOMPARE(Base64::encode("fo"), QByteArray("Zm8="));
+    QCOMPARE(Base64::encode("foo"), QByteArray("Zm9v"));
+    QCOMPARE(Base64::encode("foobar"), QByteArray("Zm9vYmFy"));
+    QCOMPARE(Base64::encodeToString("foob"), QString("Zm9vYg=="));
+    QCOMPARE(Base64::encode(QByteArray::fromHex("fbff")), QByteArray("+/8="));
+}
+
+void TestBase64::testDecode()
+{
+    QCOMPARE(Base64::decode(QByteArray()), QByteArray());
+    QCOMPARE(Base64::decode(QByteArray("Zg==")), QByteArray("f"));
+    QCOMPARE(Base64::decode(QByteArray("Zm8=")), QByteArray("fo"));
+    QCOMPARE(Base64::decode(QString("Zm9vYmFy")), QByteArray("foobar"));
+    QCOMPARE(Base64::decode(QString("+/8=")), QByteArray::fromHex("fbff"));
+
+    const QString text("<Value>Zm9vYg==</Value>");
+    QCOMPARE(Base64::decode(text.midRef(7, 8)), QByteArray("foob"));
+}
+
+void TestBase64::testDecodeLenient()
+{
+    // characters outside of the alphabet are skipped like QByteArray::fromBase64() does
+    const QStringList inputs{"Zm9v\nYmFy",
+                             " Zm9vYmFy ",
+                             "Zg==Zg==",
+                             "Zm9vYmFyZm9vYmFyZm9vYmFy\r\nZm9vYmFyZm9vYmFyZm9vYmFyZm9vYmFy",
+                             QString("Zm9vYmFyZm9vYmFy") + QChar(0x00e9) + "Zm9vYmFyZm9vYmFy",
+                             QString("Zm9vYmFyZm9vYmFy") + QChar(0x0141) + "Zm9vYmFyZm9vYmFy",
+                             "Zm9vY"};
+    for (const QString& input : inputs) {
+        QCOMPARE(Base64::decode(input), QByteArray::fromBase64(input.toLatin1()));
+        QCOMPARE(Base64::decode(input.toLatin1()), QByteArray::fromBase64(input.toLatin1()));
+    }
+}
+
+void TestBase64::testRandomRoundTrip()
+{
+    // covers the vector kernels, their tails and every padding length
+    for (int size = 0; size < 300; ++size) {
+        const QByteArray data = testData(size);
+        const QByteArray expected = data.toBase64();
+
+        QCOMPARE(Base64::encode(data), expected);
+        QCOMPARE(Base64::encodeToString(data), QString::fromLatin1(expected));
+        QCOMPARE(Base64::decode(expected), data);
+        QCOMPARE(Base64::decode(QString::fromLatin1(expected)), data);
+    }
+}
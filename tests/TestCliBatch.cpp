@@ -0,0 +1,176 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestCliBatch.h"
+
+#include <QJsonArray>
+#include <QTest>
+
+#include "cli/Batch.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "crypto/Crypto.h"
+
+QTEST_GUILESS_MAIN(TestCliBatch)
+
+void TestCliBatch::initTestCase()
+{
+    QVERIFY(Crypto::init());
+}
+
+void TestCliBatch::testParseRequest()
+{
+    QJsonObject request;
+    QString error;
+
+    QVERIFY(Batch::parseRequest(
+        "show \"Group/My Entry\" --attribute UserName --attribute 'Two Words'", request, error));
+    QCOMPARE(request.value("command").toString(), QString("show"));
+    QCOMPARE(request.value("entry").toString(), QString("Group/My Entry"));
+    QCOMPARE(request.value("attributes").toArray(), QJsonArray({"UserName", "Two Words"}));
+
+    request = QJsonObject();
+    QVERIFY(Batch::parseRequest("add My\\ Entry --password \"a \\\"quoted\\\" 'value'\" --length=20 --generate",
+                                request,
+                                error));
+    QCOMPARE(request.value("entry").toString(), QString("My Entry"));
+    QCOMPARE(request.value("password").toString(), QString("a \"quoted\" 'value'"));
+    QCOMPARE(request.value("length").toInt(), 20);
+    QCOMPARE(request.value("generate").toBool(), true);
+
+    // single quotes keep backslashes
+    request = QJsonObject();
+    QVERIFY(Batch::parseRequest("export 'C:\\Entry' Password", request, error));
+    QCOMPARE(request.value("entry").toString(), QString("C:\\Entry"));
+    QCOMPARE(request.value("field").toString(), QString("Password"));
+
+    request = QJsonObject();
+    QVERIFY(Batch::parseRequest(R"({"id": 3, "command": "locate", "term": "entry"})", request, error));
+    QCOMPARE(request.value("id").toInt(), 3);
+    QCOMPARE(request.value("command").toString(), QString("locate"));
+    QCOMPARE(request.value("term").toString(), QString("entry"));
+}
+
+void TestCliBatch::testParseErrors()
+{
+    QJsonObject request;
+    QString error;
+
+    QVERIFY(!Batch::parseRequest("show \"Unterminated", request, error));
+    QCOMPARE(error, QString("Unterminated quote."));
+    QVERIFY(!Batch::parseRequest("rm entry other", request, error));
+    QCOMPARE(error, QString("Unexpected argument other."));
+    QVERIFY(!Batch::parseRequest("add entry --password", request, error));
+    QCOMPARE(error, QString("Missing value for option --password."));
+    QVERIFY(!Batch::parseRequest(" ", request, error));
+    QCOMPARE(error, QString("Missing command."));
+    QVERIFY(!Batch::parseRequest(R"({"command": "show")", request, error));
+    QVERIFY(!error.isEmpty());
+}
+
+void TestCliBatch::testRunRequest()
+{
+    Database db;
+    Entry* entry = new Entry();
+    entry->setUuid(QUuid::createUuid());
+    entry->setTitle("entry");
+    entry->setUsername("user");
+    entry->setPassword("pass");
+    entry->setGroup(db.rootGroup());
+
+    bool modified = false;
+    QJsonObject request({{"id", 1}, {"command", "show"}, {"entry", "entry"}});
+    QJsonObject response = Batch::runRequest(&db, request, modified);
+    QCOMPARE(response.value("id").toInt(), 1);
+    QCOMPARE(response.value("ok").toBool(), true);
+    QVERIFY(!response.contains("error"));
+    QCOMPARE(response.value("entry").toString(), QString("entry"));
+    const QJsonObject attributes = response.value("attributes").toObject();
+    QCOMPARE(attributes.value("UserName").toString(), QString("user"));
+    QCOMPARE(attributes.value("Password").toString(), QString("pass"));
+    QVERIFY(!modified);
+
+    request = QJsonObject({{"command", "export"}, {"entry", "entry"}});
+    response = Batch::runRequest(&db, request, modified);
+    QCOMPARE(response.value("ok").toBool(), true);
+    QCOMPARE(response.value("field").toString(), QString("Password"));
+    QCOMPARE(response.value("value").toString(), QString("pass"));
+
+    request = QJsonObject({{"command", "locate"}, {"term", "ENT"}});
+    response = Batch::runRequest(&db, request, modified);
+    QCOMPARE(response.value("entries").toArray(), QJsonArray({"/entry"}));
+
+    request = QJsonObject({{"command", "add"}, {"entry", "new"}, {"generate", true}, {"length", 24}});
+    response = Batch::runRequest(&db, request, modified);
+    QCOMPARE(response.value("ok").toBool(), true);
+    QVERIFY(modified);
+    Entry* added = db.rootGroup()->findEntryByPath("new");
+    QVERIFY(added);
+    QCOMPARE(added->password().size(), 24);
+
+    modified = false;
+    request = QJsonObject({{"command", "edit"}, {"entry", "entry"}, {"username", "other"}});
+    response = Batch::runRequest(&db, request, modified);
+    QCOMPARE(response.value("ok").toBool(), true);
+    QVERIFY(modified);
+    QCOMPARE(entry->username(), QString("other"));
+
+    modified = false;
+    request = QJsonObject({{"command", "rm"}, {"entry", "new"}});
+    response = Batch::runRequest(&db, request, modified);
+    QCOMPARE(response.value("ok").toBool(), true);
+    QCOMPARE(response.value("recycled").toBool(), true);
+    QVERIFY(modified);
+}
+
+void TestCliBatch::testFailedRequests()
+{
+    Database db;
+    Entry* entry = new Entry();
+    entry->setUuid(QUuid::createUuid());
+    entry->setTitle("entry");
+    entry->setGroup(db.rootGroup());
+
+    bool modified = false;
+    QJsonObject response = Batch::runRequest(&db, QJsonObject({{"id", "a"}, {"command", "unknown"}}), modified);
+    QCOMPARE(response.value("id").toString(), QString("a"));
+    QCOMPARE(response.value("ok").toBool(), false);
+    QCOMPARE(response.value("error").toString(), QString("Invalid command unknown."));
+
+    response = Batch::runRequest(&db, QJsonObject({{"command", "show"}, {"entry", "missing"}}), modified);
+    QCOMPARE(response.value("ok").toBool(), false);
+    QCOMPARE(response.value("error").toString(), QString("Could not find entry with path missing."));
+
+    response = Batch::runRequest(
+        &db, QJsonObject({{"command", "show"}, {"entry", "entry"}, {"attributes", QJsonArray({"Nope"})}}), modified);
+    QCOMPARE(response.value("ok").toBool(), false);
+    QCOMPARE(response.value("error").toString(), QString("Unknown attribute Nope."));
+
+    // invalid input leaves nothing behind, not even a deleted object
+    response = Batch::runRequest(&db, QJsonObject({{"command", "add"}, {"entry", "new"}, {"length", 0}}), modified);
+    QCOMPARE(response.value("ok").toBool(), false);
+    QCOMPARE(response.value("error").toString(), QString("Invalid value for password length."));
+    QVERIFY(!db.rootGroup()->findEntryByPath("new"));
+    QVERIFY(db.deletedObjects().isEmpty());
+
+    response = Batch::runRequest(
+        &db, QJsonObject({{"command", "edit"}, {"entry", "entry"}, {"title", "changed"}, {"length", -1}}), modified);
+    QCOMPARE(response.value("ok").toBool(), false);
+    QCOMPARE(entry->title(), QString("entry"));
+    QVERIFY(!modified);
+}
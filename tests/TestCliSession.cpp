@@ -0,0 +1,183 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestCliSession.h"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "cli/Session.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "crypto/Crypto.h"
+#include "keys/CompositeKey.h"
+#include "keys/PasswordKey.h"
+
+QTEST_GUILESS_MAIN(TestCliSession)
+
+namespace
+{
+    CompositeKey databaseKey()
+    {
+        CompositeKey key;
+        key.addKey(PasswordKey("a"));
+        return key;
+    }
+
+    // Run a command in the session with the given text on stdin, like a separate client would.
+    bool runClient(const QStringList& arguments, const QByteArray& input, int& exitCode)
+    {
+        int inputPipe[2];
+        if (pipe(inputPipe) != 0) {
+            return false;
+        }
+        const bool written = write(inputPipe[1], input.constData(), static_cast<size_t>(input.size())) == input.size();
+        close(inputPipe[1]);
+
+        const int savedStdin = dup(STDIN_FILENO);
+        dup2(inputPipe[0], STDIN_FILENO);
+        close(inputPipe[0]);
+
+        const bool forwarded = written && Session::forwardCommand(arguments, exitCode);
+
+        dup2(savedStdin, STDIN_FILENO);
+        close(savedStdin);
+        return forwarded;
+    }
+
+    // like the open command, only open the database after forking
+    pid_t startSession(const QString& databasePath, int socket)
+    {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            Database* db = Database::openDatabaseFile(databasePath, databaseKey());
+            _exit(db ? Session::serve(socket, db, databasePath, 0) : EXIT_FAILURE);
+        }
+        close(socket);
+        return pid;
+    }
+
+    int stopSession(pid_t pid)
+    {
+        kill(pid, SIGTERM);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return status;
+    }
+} // namespace
+
+void TestCliSession::initTestCase()
+{
+    QVERIFY(Crypto::init());
+}
+
+void TestCliSession::testSequentialClients()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString databasePath = dir.path() + "/session.kdbx";
+    const QString socketPath = dir.path() + "/session";
+    QVERIFY(QFile::copy(QString(KEEPASSX_TEST_DATA_DIR).append("/Format300.kdbx"), databasePath));
+    QVERIFY(QFile::setPermissions(databasePath, QFile::ReadOwner | QFile::WriteOwner));
+
+    const int socket = Session::listen(socketPath);
+    QVERIFY(socket >= 0);
+    const pid_t pid = startSession(databasePath, socket);
+    QVERIFY(pid > 0);
+
+    qputenv(Session::SocketVariable, QFile::encodeName(socketPath));
+    int firstExitCode = EXIT_FAILURE;
+    int secondExitCode = EXIT_FAILURE;
+    // the first client sends more than it consumes, none of it may reach the second one
+    const bool firstForwarded =
+        runClient({"add", databasePath, "-p", "first"}, "first password\nleftover\n", firstExitCode);
+    const bool secondForwarded = runClient({"add", databasePath, "-p", "second"}, "", secondExitCode);
+    qunsetenv(Session::SocketVariable);
+    const int status = stopSession(pid);
+
+    QVERIFY(firstForwarded);
+    QVERIFY(secondForwarded);
+    QCOMPARE(firstExitCode, EXIT_SUCCESS);
+    QCOMPARE(secondExitCode, EXIT_SUCCESS);
+    QVERIFY(WIFEXITED(status));
+    QCOMPARE(WEXITSTATUS(status), EXIT_SUCCESS);
+
+    QScopedPointer<Database> db(Database::openDatabaseFile(databasePath, databaseKey()));
+    QVERIFY(db);
+    Entry* first = db->rootGroup()->findEntryByPath("first");
+    Entry* second = db->rootGroup()->findEntryByPath("second");
+    QVERIFY(first);
+    QVERIFY(second);
+    QCOMPARE(first->password(), QString("first password"));
+    QCOMPARE(second->password(), QString());
+}
+
+void TestCliSession::testFailedSave()
+{
+    if (geteuid() == 0) {
+        QSKIP("The directory permissions can't make saving fail for root.");
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString databaseDir = dir.path() + "/database";
+    const QString databasePath = databaseDir + "/session.kdbx";
+    const QString socketPath = dir.path() + "/session";
+    QVERIFY(QDir().mkdir(databaseDir));
+    QVERIFY(QFile::copy(QString(KEEPASSX_TEST_DATA_DIR).append("/Format300.kdbx"), databasePath));
+    QVERIFY(QFile::setPermissions(databasePath, QFile::ReadOwner | QFile::WriteOwner));
+
+    const int socket = Session::listen(socketPath);
+    QVERIFY(socket >= 0);
+    const pid_t pid = startSession(databasePath, socket);
+    QVERIFY(pid > 0);
+
+    qputenv(Session::SocketVariable, QFile::encodeName(socketPath));
+    int failedExitCode = EXIT_SUCCESS;
+    int showExitCode = EXIT_SUCCESS;
+    int addExitCode = EXIT_FAILURE;
+    // the database can't be saved into a read only directory
+    QFile::setPermissions(databaseDir, QFile::ReadOwner | QFile::ExeOwner);
+    const bool failedForwarded = runClient({"add", databasePath, "failed"}, "", failedExitCode);
+    QFile::setPermissions(databaseDir, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    // the unsaved entry is dropped from the session, and not saved with the next change
+    const bool showForwarded = runClient({"show", databasePath, "failed"}, "", showExitCode);
+    const bool addForwarded = runClient({"add", databasePath, "saved"}, "", addExitCode);
+    qunsetenv(Session::SocketVariable);
+    const int status = stopSession(pid);
+
+    QVERIFY(failedForwarded);
+    QVERIFY(showForwarded);
+    QVERIFY(addForwarded);
+    QCOMPARE(failedExitCode, EXIT_FAILURE);
+    QCOMPARE(showExitCode, EXIT_FAILURE);
+    QCOMPARE(addExitCode, EXIT_SUCCESS);
+    QVERIFY(WIFEXITED(status));
+    QCOMPARE(WEXITSTATUS(status), EXIT_SUCCESS);
+
+    QScopedPointer<Database> db(Database::openDatabaseFile(databasePath, databaseKey()));
+    QVERIFY(db);
+    QVERIFY(!db->rootGroup()->findEntryByPath("failed"));
+    QVERIFY(db->rootGroup()->findEntryByPath("saved"));
+}
@@ -23,6 +23,8 @@
 #include <QTemporaryFile>
 
 #include "config-keepassx-tests.h"
+#include "core/DatabaseMemoryStats.h"
+#include "core/Group.h"
 #include "core/Metadata.h"
 #include "crypto/Crypto.h"
 #include "format/KeePass2Writer.h"
@@ -109,3 +111,227 @@ void TestDatabase::testEmptyRecycleBinWithHierarchicalData()
 
     delete db;
 }
+
+void TestDatabase::testGeneration()
+{
+    QScopedPointer<Database> db(new Database());
+    quint64 generation = db->generation();
+
+    Entry* entry = new Entry();
+    entry->setGroup(db->rootGroup());
+    QVERIFY(db->generation() > generation);
+    generation = db->generation();
+
+    entry->setTitle("Title");
+    QVERIFY(db->generation() > generation);
+    generation = db->generation();
+
+    // Unchanged values don't modify the database
+    entry->setTitle("Title");
+    QCOMPARE(db->generation(), generation);
+
+    db->metadata()->setName("Name");
+    QVERIFY(db->generation() > generation);
+    generation = db->generation();
+
+    delete entry;
+    QVERIFY(db->generation() > generation);
+}
+
+void TestDatabase::testSnapshot()
+{
+    QString filename = QString(KEEPASSX_TEST_DATA_DIR).append("/RecycleBinWithData.kdbx");
+    CompositeKey key;
+    key.addKey(PasswordKey("123"));
+    QScopedPointer<Database> db(Database::openDatabaseFile(filename, key));
+    QVERIFY(db);
+    QVERIFY(db->metadata()->recycleBin());
+
+    const QByteArray seed = db->kdf()->seed();
+    const QByteArray transformedMasterKey = db->transformedMasterKey();
+    QScopedPointer<Database> snapshot(db->snapshot());
+    QCOMPARE(snapshot->kdf()->seed(), seed);
+    // preparing the snapshot leaves the key of the database alone
+    QCOMPARE(snapshot->prepareSnapshot(), QString());
+    QVERIFY(snapshot->kdf()->seed() != seed);
+    QCOMPARE(db->kdf()->seed(), seed);
+    QCOMPARE(db->transformedMasterKey(), transformedMasterKey);
+    QCOMPARE(snapshot->rootGroup()->uuid(), db->rootGroup()->uuid());
+    QVERIFY(snapshot->metadata()->recycleBin());
+    QVERIFY(snapshot->metadata()->recycleBin() != db->metadata()->recycleBin());
+    QCOMPARE(snapshot->metadata()->recycleBin()->uuid(), db->metadata()->recycleBin()->uuid());
+    QCOMPARE(snapshot->metadata()->name(), db->metadata()->name());
+
+    const QList<Entry*> entries = db->rootGroup()->entriesRecursive(true);
+    const QList<Entry*> snapshotEntries = snapshot->rootGroup()->entriesRecursive(true);
+    QCOMPARE(snapshotEntries.size(), entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        QCOMPARE(snapshotEntries[i]->uuid(), entries[i]->uuid());
+        QCOMPARE(snapshotEntries[i]->title(), entries[i]->title());
+        QCOMPARE(snapshotEntries[i]->timeInfo().locationChanged(), entries[i]->timeInfo().locationChanged());
+        QCOMPARE(snapshotEntries[i]->timeInfo().lastModificationTime(),
+                 entries[i]->timeInfo().lastModificationTime());
+    }
+
+    // edits after taking the snapshot are not part of it
+    Entry* entry = db->rootGroup()->entriesRecursive().first();
+    Entry* snapshotEntry = snapshot->rootGroup()->entriesRecursive().first();
+    const QString title = entry->title();
+    entry->setTitle(title + " edited");
+    QCOMPARE(snapshotEntry->title(), title);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.close();
+    QCOMPARE(snapshot->saveToFile(file.fileName()), QString());
+    // the snapshot is written with the key it was prepared with
+    QVERIFY(snapshot->kdf()->seed() != seed);
+
+    // the database takes the new key over, unless its key changed meanwhile
+    const quint64 generation = db->generation();
+    db->applySnapshotKey(snapshot.data(), transformedMasterKey);
+    QCOMPARE(db->kdf()->seed(), snapshot->kdf()->seed());
+    QCOMPARE(db->transformedMasterKey(), snapshot->transformedMasterKey());
+    QCOMPARE(db->generation(), generation);
+    QVERIFY(db->setKey(key, false, true));
+    const QByteArray changedSeed = db->kdf()->seed();
+    db->applySnapshotKey(snapshot.data(), transformedMasterKey);
+    QCOMPARE(db->kdf()->seed(), changedSeed);
+
+    QScopedPointer<Database> savedDb(Database::openDatabaseFile(file.fileName(), key));
+    QVERIFY(savedDb);
+    QCOMPARE(savedDb->rootGroup()->entriesRecursive(true).size(), entries.size());
+    QCOMPARE(savedDb->rootGroup()->entriesRecursive().first()->title(), title);
+}
+
+void TestDatabase::testUpdateFrom()
+{
+    QScopedPointer<Database> db(new Database());
+    Group* group1 = new Group();
+    group1->setUuid(QUuid::createUuid());
+    group1->setName("group1");
+    group1->setParent(db->rootGroup());
+    Group* group2 = new Group();
+    group2->setUuid(QUuid::createUuid());
+    group2->setName("group2");
+    group2->setParent(db->rootGroup());
+
+    QList<Entry*> entries;
+    for (int i = 0; i < 4; ++i) {
+        Entry* entry = new Entry();
+        entry->setUuid(QUuid::createUuid());
+        entry->setTitle(QString("entry%1").arg(i));
+        entry->setGroup(group1);
+        entries.append(entry);
+    }
+
+    QScopedPointer<Database> other(db->snapshot());
+    Group* otherGroup1 = other->rootGroup()->findChildByUuid(group1->uuid());
+    Group* otherGroup2 = other->rootGroup()->findChildByUuid(group2->uuid());
+    other->rootGroup()->findEntryByUuid(entries[0]->uuid())->setTitle("changed");
+    other->rootGroup()->findEntryByUuid(entries[1]->uuid())->setGroup(otherGroup2);
+    delete other->rootGroup()->findEntryByUuid(entries[2]->uuid());
+    Entry* newEntry = new Entry();
+    newEntry->setUuid(QUuid::createUuid());
+    newEntry->setTitle("new");
+    newEntry->setGroup(otherGroup1);
+    Group* newGroup = new Group();
+    newGroup->setUuid(QUuid::createUuid());
+    newGroup->setName("new");
+    newGroup->setParent(otherGroup2);
+    otherGroup2->setName("renamed");
+    // the top visible entry of a group can be an entry of another group
+    otherGroup2->setLastTopVisibleEntry(other->rootGroup()->findEntryByUuid(entries[3]->uuid()));
+    other->rootGroup()->setLastTopVisibleEntry(other->rootGroup()->findEntryByUuid(newEntry->uuid()));
+
+    QSignalSpy spyGroupRemoved(db.data(), SIGNAL(groupRemoved()));
+    db->updateFrom(other.data());
+
+    // existing objects are updated in place
+    QCOMPARE(db->rootGroup()->findEntryByUuid(entries[0]->uuid()), entries[0]);
+    QCOMPARE(entries[0]->title(), QString("changed"));
+    QCOMPARE(entries[1]->group(), group2);
+    QVERIFY(!db->rootGroup()->findEntryByUuid(entries[2]->uuid()));
+    QCOMPARE(entries[3]->title(), QString("entry3"));
+    QCOMPARE(group2->name(), QString("renamed"));
+    QCOMPARE(spyGroupRemoved.count(), 0);
+
+    Entry* addedEntry = db->rootGroup()->findEntryByUuid(newEntry->uuid());
+    QVERIFY(addedEntry);
+    QCOMPARE(addedEntry->group(), group1);
+    Group* addedGroup = db->rootGroup()->findChildByUuid(newGroup->uuid());
+    QVERIFY(addedGroup);
+    QCOMPARE(addedGroup->parentGroup(), group2);
+    QCOMPARE(db->rootGroup()->entriesRecursive().size(), 4);
+
+    // top visible entries point into this database, not the other one
+    QCOMPARE(group2->lastTopVisibleEntry(), entries[3]);
+    QCOMPARE(db->rootGroup()->lastTopVisibleEntry(), addedEntry);
+    QVERIFY(!group1->lastTopVisibleEntry());
+
+    // groups missing from the other database are deleted
+    delete otherGroup1;
+    db->updateFrom(other.data());
+    QVERIFY(!db->rootGroup()->findChildByUuid(group1->uuid()));
+    QCOMPARE(db->rootGroup()->entriesRecursive().size(), 1);
+    QCOMPARE(spyGroupRemoved.count(), 1);
+    QVERIFY(!db->rootGroup()->lastTopVisibleEntry());
+    QVERIFY(!group2->lastTopVisibleEntry());
+}
+
+void TestDatabase::testMemoryStats()
+{
+    QScopedPointer<Database> db(new Database());
+    Group* group = new Group();
+    group->setUuid(QUuid::createUuid());
+    group->setName("group");
+    group->setParent(db->rootGroup());
+
+    const QByteArray attachment(1000, 'x');
+    Entry* entry1 = new Entry();
+    entry1->setUuid(QUuid::createUuid());
+    entry1->setTitle("entry1");
+    entry1->attachments()->set("attachment", attachment);
+    entry1->addHistoryItem(entry1->clone(Entry::CloneNoFlags));
+    entry1->setGroup(group);
+
+    Entry* entry2 = new Entry();
+    entry2->setUuid(QUuid::createUuid());
+    entry2->setTitle("entry2");
+    entry2->attachments()->set("attachment", attachment);
+    entry2->setGroup(group);
+
+    const DatabaseMemoryStats stats = db->memoryStats(1);
+    QCOMPARE(stats.total.entries, 2);
+    QCOMPARE(stats.total.historyItems, 1);
+    // the attachment data is shared by all three entries and only counted once
+    QVERIFY(stats.total.attachments >= attachment.size());
+    QVERIFY(stats.total.attachments < 2 * attachment.size());
+    QCOMPARE(stats.total.sharedAttachments, 2 * static_cast<qint64>(attachment.size()));
+    QVERIFY(stats.totalBytes() >= stats.total.total());
+
+    QCOMPARE(stats.groups.size(), 2);
+    QCOMPARE(stats.groups[1].path, QString("/group"));
+    QCOMPARE(stats.groups[1].usage.entries, 2);
+    QCOMPARE(stats.groups[0].usage.entries, 0);
+
+    QCOMPARE(stats.largestEntries.size(), 1);
+    QCOMPARE(stats.largestEntries.first().uuid, entry1->uuid());
+    QCOMPARE(stats.largestEntries.first().historyItems, 1);
+}
+
+void TestDatabase::testCompressionLevel()
+{
+    QScopedPointer<Database> db(new Database());
+    QCOMPARE(db->compressionLevel(), Database::DefaultCompressionLevel);
+
+    db->setCompressionLevel(9);
+    QCOMPARE(db->compressionLevel(), 9);
+    QScopedPointer<Database> snapshot(db->snapshot());
+    QCOMPARE(snapshot->compressionLevel(), 9);
+
+    // the default is not stored
+    db->setCompressionLevel(Database::DefaultCompressionLevel);
+    QCOMPARE(db->compressionLevel(), Database::DefaultCompressionLevel);
+    QVERIFY(db->metadata()->customData()->isEmpty());
+}
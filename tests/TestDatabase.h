@@ -31,6 +31,11 @@ private slots:
     void testEmptyRecycleBinOnNotCreated();
     void testEmptyRecycleBinOnEmpty();
     void testEmptyRecycleBinWithHierarchicalData();
+    void testGeneration();
+    void testSnapshot();
+    void testUpdateFrom();
+    void testMemoryStats();
+    void testCompressionLevel();
 };
 
 #endif // KEEPASSX_TESTDATABASE_H
@@ -19,6 +19,7 @@
 #include "TestGlobal.h"
 
 #include <QSignalSpy>
+#include <QSortFilterProxyModel>
 
 #include "core/DatabaseIcons.h"
 #include "core/Entry.h"
@@ -330,6 +331,134 @@ void TestEntryModel::testProxyModel()
     delete db;
 }
 
+void TestEntryModel::testCachedData()
+{
+    EntryModel* model = new EntryModel(this);
+    ModelTest* modelTest = new ModelTest(model, this);
+
+    Database* db = new Database();
+    Entry* entry1 = new Entry();
+    entry1->setTitle("Title 1");
+    entry1->setUsername("user1");
+    entry1->setGroup(db->rootGroup());
+    Entry* entry2 = new Entry();
+    entry2->setTitle("Title 2");
+    entry2->setUsername(QString("{REF:U@I:%1}").arg(QString(entry1->uuid().toRfc4122().toHex())));
+    entry2->setGroup(db->rootGroup());
+
+    model->setGroup(db->rootGroup());
+    model->setUsernamesHidden(false);
+
+    QModelIndex title1 = model->index(0, EntryModel::Title);
+    QModelIndex username2 = model->index(1, EntryModel::Username);
+    QCOMPARE(model->data(title1).toString(), QString("Title 1"));
+    QCOMPARE(model->data(username2, Qt::UserRole).toString(), QString("user1"));
+
+    // changes invalidate the entry and the entries referencing it
+    entry1->setTitle("New Title");
+    entry1->setUsername("user2");
+    QCOMPARE(model->data(title1).toString(), QString("New Title"));
+    QCOMPARE(model->data(username2, Qt::UserRole).toString(), QString("user2"));
+    QCOMPARE(model->data(username2).toString(), QString("Ref: user2"));
+
+    model->setUsernamesHidden(true);
+    QVERIFY(model->data(username2).toString() != QString("Ref: user2"));
+    QCOMPARE(model->data(username2, Qt::UserRole).toString(), QString("user2"));
+
+    delete modelTest;
+    delete model;
+    delete db;
+}
+
+void TestEntryModel::testUncachedColumns()
+{
+    EntryModel* model = new EntryModel(this);
+    ModelTest* modelTest = new ModelTest(model, this);
+    QSortFilterProxyModel* modelProxy = new QSortFilterProxyModel(this);
+    modelProxy->setSourceModel(model);
+    modelProxy->setSortRole(Qt::UserRole);
+
+    Database* db = new Database();
+    Entry* entry1 = new Entry();
+    entry1->setTitle("Title 1");
+    entry1->setGroup(db->rootGroup());
+    Entry* entry2 = new Entry();
+    entry2->setTitle("Title 2");
+    entry2->setGroup(db->rootGroup());
+
+    model->setGroup(db->rootGroup());
+
+    QModelIndex expires1 = model->index(0, EntryModel::Expires);
+    QModelIndex attachments1 = model->index(0, EntryModel::Attachments);
+    QCOMPARE(model->data(expires1).toString(), QString("Never"));
+    QCOMPARE(model->data(attachments1).toString(), QString(""));
+
+    modelProxy->sort(EntryModel::Expires, Qt::AscendingOrder);
+    QCOMPARE(modelProxy->data(modelProxy->index(0, EntryModel::Title)).toString(), QString("Title 1"));
+    modelProxy->sort(EntryModel::Paperclip, Qt::AscendingOrder);
+    QCOMPARE(modelProxy->data(modelProxy->index(0, EntryModel::Title)).toString(), QString("Title 1"));
+
+    // neither change emits Entry::dataChanged()
+    const QDateTime expiry = QDateTime(QDate(2030, 1, 1), QTime(0, 0), Qt::UTC);
+    entry2->setExpires(true);
+    entry2->setExpiryTime(expiry);
+    entry2->attachments()->set("file.txt", QByteArray("data"));
+
+    QModelIndex expires2 = model->index(1, EntryModel::Expires);
+    QModelIndex attachments2 = model->index(1, EntryModel::Attachments);
+    QCOMPARE(model->data(expires2).toString(), expiry.toLocalTime().toString(Qt::DefaultLocaleShortDate));
+    QCOMPARE(model->data(expires2, Qt::UserRole).toDateTime(), expiry);
+    QCOMPARE(model->data(attachments2).toString(), QString("file.txt"));
+
+    modelProxy->sort(EntryModel::Expires, Qt::AscendingOrder);
+    QCOMPARE(modelProxy->data(modelProxy->index(0, EntryModel::Title)).toString(), QString("Title 2"));
+    modelProxy->sort(EntryModel::Paperclip, Qt::AscendingOrder);
+    QCOMPARE(modelProxy->data(modelProxy->index(0, EntryModel::Title)).toString(), QString("Title 2"));
+
+    delete modelProxy;
+    delete modelTest;
+    delete model;
+    delete db;
+}
+
+void TestEntryModel::testFetchMore()
+{
+    EntryModel* model = new EntryModel(this);
+    ModelTest* modelTest = new ModelTest(model, this);
+
+    Database* db = new Database();
+    QList<Entry*> entries;
+    for (int i = 0; i < 1200; ++i) {
+        Entry* entry = new Entry();
+        entry->setTitle(QString("Entry %1").arg(i));
+        entry->setUsername(QString("user%1").arg(i % 100, 3, 10, QChar('0')));
+        entry->setGroup(db->rootGroup());
+        entries.append(entry);
+    }
+
+    model->setSortOrder(EntryModel::Username, Qt::DescendingOrder);
+    model->setEntryList(entries);
+    QCOMPARE(model->rowCount(), 0);
+
+    // the first batch is fetched once the entries are sorted
+    QTRY_VERIFY(model->rowCount() > 0);
+    QVERIFY(model->rowCount() < entries.size());
+    QCOMPARE(model->data(model->index(0, EntryModel::Username)).toString(), QString("user099"));
+
+    // entries that were not fetched yet are removed without a row
+    delete entries.takeAt(1100);
+
+    while (model->canFetchMore(QModelIndex())) {
+        model->fetchMore(QModelIndex());
+    }
+    QCOMPARE(model->rowCount(), entries.size());
+    QCOMPARE(model->data(model->index(entries.size() - 1, EntryModel::Username)).toString(), QString("user000"));
+
+    delete modelTest;
+    delete model;
+    delete db;
+}
+
 void TestEntryModel::testDatabaseDelete()
 {
     EntryModel* model = new EntryModel(this);
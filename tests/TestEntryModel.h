@@ -33,6 +33,9 @@ private slots:
     void testCustomIconModel();
     void testAutoTypeAssociationsModel();
     void testProxyModel();
+    void testCachedData();
+    void testUncachedColumns();
+    void testFetchMore();
     void testDatabaseDelete();
 };
 
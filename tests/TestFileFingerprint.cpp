@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestFileFingerprint.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "core/FileFingerprint.h"
+
+QTEST_GUILESS_MAIN(TestFileFingerprint)
+
+namespace
+{
+    QByteArray testData()
+    {
+        QByteArray data(20000, '\0');
+        for (int i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<char>(i * 31 + (i >> 8));
+        }
+        return data;
+    }
+
+    bool writeFile(const QString& filePath, const QByteArray& data)
+    {
+        QFile file(filePath);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size();
+    }
+} // namespace
+
+void TestFileFingerprint::testUnchanged()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.path() + "/test.kdbx";
+    QVERIFY(writeFile(filePath, testData()));
+
+    const FileFingerprint fingerprint(filePath);
+    QVERIFY(fingerprint.isValid());
+    QVERIFY(fingerprint.hasSameContent(FileFingerprint(filePath)));
+}
+
+void TestFileFingerprint::testTouched()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.path() + "/test.kdbx";
+    QVERIFY(writeFile(filePath, testData()));
+    const FileFingerprint fingerprint(filePath);
+
+    // rewriting the same content only updates the modification time
+    QTest::qSleep(1100);
+    QVERIFY(writeFile(filePath, testData()));
+    QVERIFY(fingerprint.hasSameContent(FileFingerprint(filePath)));
+}
+
+void TestFileFingerprint::testSizeChanged()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.path() + "/test.kdbx";
+    const QByteArray data = testData();
+    QVERIFY(writeFile(filePath, data));
+    const FileFingerprint fingerprint(filePath);
+
+    QVERIFY(writeFile(filePath, data + QByteArray(16, '\0')));
+    QVERIFY(!fingerprint.hasSameContent(FileFingerprint(filePath)));
+    QVERIFY(writeFile(filePath, data.left(data.size() - 16)));
+    QVERIFY(!fingerprint.hasSameContent(FileFingerprint(filePath)));
+}
+
+void TestFileFingerprint::testContentChanged()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.path() + "/test.kdbx";
+    const QByteArray data = testData();
+    QVERIFY(writeFile(filePath, data));
+    const FileFingerprint fingerprint(filePath);
+
+    // a new master seed in the header
+    QByteArray header = data;
+    header[40] = static_cast<char>(header[40] ^ 0x01);
+    QVERIFY(writeFile(filePath, header));
+    QVERIFY(!fingerprint.hasSameContent(FileFingerprint(filePath)));
+
+    // a new HMAC at the end of the payload
+    QByteArray trailer = data;
+    trailer[trailer.size() - 1] = static_cast<char>(trailer[trailer.size() - 1] ^ 0x01);
+    QVERIFY(writeFile(filePath, trailer));
+    QVERIFY(!fingerprint.hasSameContent(FileFingerprint(filePath)));
+}
+
+void TestFileFingerprint::testMissingFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const FileFingerprint missing(dir.path() + "/missing.kdbx");
+    QVERIFY(!missing.isValid());
+    QVERIFY(!missing.hasSameContent(missing));
+    QVERIFY(!FileFingerprint().isValid());
+}
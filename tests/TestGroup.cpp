@@ -88,6 +88,22 @@ void TestGroup::testParenting()
     QVERIFY(db->rootGroup()->children().at(1) == g6);
     QVERIFY(db->rootGroup()->children().at(2) == g5);
 
+    QCOMPARE(rootGroup->row(), -1);
+    QCOMPARE(g1->row(), 0);
+    QCOMPARE(g6->row(), 1);
+    QCOMPARE(g5->row(), 2);
+    QCOMPARE(g3->row(), 1);
+
+    g5->setParent(db->rootGroup(), 0);
+    QCOMPARE(g5->row(), 0);
+    QCOMPARE(g1->row(), 1);
+    QCOMPARE(g6->row(), 2);
+
+    g2->setParent(db->rootGroup(), 1);
+    QCOMPARE(g2->row(), 1);
+    QCOMPARE(g1->row(), 2);
+    QCOMPARE(g3->row(), 0);
+
     QSignalSpy spy(db, SIGNAL(groupDataChanged(Group*)));
     g2->setName("test");
     g4->setName("test");
@@ -18,6 +18,8 @@
 #include "TestKdbx4.h"
 #include "TestGlobal.h"
 
+#include <QtEndian>
+
 #include "config-keepassx-tests.h"
 #include "core/Metadata.h"
 #include "format/KdbxXmlReader.h"
@@ -416,6 +418,49 @@ void TestKdbx4::testCustomData()
     QCOMPARE(newEntry->customData()->value(customDataKey2), customData2);
 }
 
+void TestKdbx4::testXmlDateTimeOutOfRange()
+{
+    QScopedPointer<Database> dbWrite(new Database());
+    auto entry = new Entry();
+    entry->setUuid(QUuid::createUuid());
+    entry->setGroup(dbWrite->rootGroup());
+    TimeInfo timeInfo;
+    timeInfo.setCreationTime(Test::datetime(2010, 8, 25, 16, 12, 57));
+    entry->setTimeInfo(timeInfo);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    bool hasError;
+    QString errorString;
+    writeXml(&buffer, dbWrite.data(), hasError, errorString);
+    QVERIFY(!hasError);
+
+    // seconds since 0001-01-01 in little endian
+    const qint64 secs = qToLittleEndian(timeInfo.creationTime().toMSecsSinceEpoch() / 1000 + Q_INT64_C(62135596800));
+    const QByteArray creationTime = QByteArray(reinterpret_cast<const char*>(&secs), sizeof(secs)).toBase64();
+    QVERIFY(buffer.data().contains("<CreationTime>" + creationTime + "</CreationTime>"));
+
+    // the largest and a negative value
+    for (const QByteArray& outOfRange : {QByteArray("/////////38="), QByteArray("//////////8=")}) {
+        QByteArray xml = buffer.data();
+        xml.replace("<CreationTime>" + creationTime, "<CreationTime>" + outOfRange);
+        QBuffer readBuffer(&xml);
+        readBuffer.open(QIODevice::ReadOnly);
+        QScopedPointer<Database> dbRead(readXml(&readBuffer, true, hasError, errorString));
+        QVERIFY(hasError);
+        QVERIFY(errorString.contains("Invalid date time value"));
+
+        // files with a broken time still open outside of strict mode
+        const QDateTime before = QDateTime::currentDateTimeUtc().addSecs(-1);
+        readBuffer.seek(0);
+        dbRead.reset(readXml(&readBuffer, false, hasError, errorString));
+        QVERIFY(!hasError);
+        QVERIFY(dbRead);
+        QCOMPARE(dbRead->rootGroup()->entries().size(), 1);
+        QVERIFY(dbRead->rootGroup()->entries().first()->timeInfo().creationTime() >= before);
+    }
+}
+
 QSharedPointer<Kdf> TestKdbx4::fastKdf(QSharedPointer<Kdf> kdf)
 {
     kdf->setRounds(1);
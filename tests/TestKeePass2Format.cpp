@@ -467,6 +467,46 @@ void TestKeePass2Format::testXmlInvalidXmlChars()
     QCOMPARE(attrRead->value("SurrogateValid2"), strSurrogateValid2);
 }
 
+void TestKeePass2Format::testXmlDateTimes()
+{
+    QScopedPointer<Database> dbWrite(new Database());
+
+    TimeInfo timeInfo;
+    timeInfo.setCreationTime(Test::datetime(1, 1, 1, 0, 0, 0));
+    timeInfo.setLastModificationTime(Test::datetime(1969, 12, 31, 23, 59, 59));
+    timeInfo.setLastAccessTime(Test::datetime(2016, 2, 29, 8, 5, 3));
+    timeInfo.setExpiryTime(Test::datetime(9999, 12, 31, 23, 59, 59));
+    timeInfo.setLocationChanged(Test::datetime(2010, 8, 25, 16, 12, 57));
+
+    auto entry = new Entry();
+    entry->setUuid(QUuid::createUuid());
+    entry->setGroup(dbWrite->rootGroup());
+    entry->setTimeInfo(timeInfo);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    bool hasError;
+    QString errorString;
+    writeXml(&buffer, dbWrite.data(), hasError, errorString);
+    QVERIFY(!hasError);
+    buffer.seek(0);
+
+    QScopedPointer<Database> dbRead(readXml(&buffer, true, hasError, errorString));
+    if (hasError) {
+        qWarning("Database read error: %s", qPrintable(errorString));
+    }
+    QVERIFY(!hasError);
+    QVERIFY(dbRead.data());
+    QCOMPARE(dbRead->rootGroup()->entries().size(), 1);
+    const TimeInfo timeInfoRead = dbRead->rootGroup()->entries().at(0)->timeInfo();
+
+    QCOMPARE(timeInfoRead.creationTime(), timeInfo.creationTime());
+    QCOMPARE(timeInfoRead.lastModificationTime(), timeInfo.lastModificationTime());
+    QCOMPARE(timeInfoRead.lastAccessTime(), timeInfo.lastAccessTime());
+    QCOMPARE(timeInfoRead.expiryTime(), timeInfo.expiryTime());
+    QCOMPARE(timeInfoRead.locationChanged(), timeInfo.locationChanged());
+}
+
 void TestKeePass2Format::testXmlRepairUuidHistoryItem()
 {
     QString xmlFile = QString("%1/%2.xml").arg(KEEPASSX_TEST_DATA_DIR, "BrokenDifferentEntryHistoryUuid");
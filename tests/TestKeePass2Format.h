@@ -51,6 +51,7 @@ private slots:
     void testXmlBroken_data();
     void testXmlEmptyUuids();
     void testXmlInvalidXmlChars();
+    void testXmlDateTimes();
     void testXmlRepairUuidHistoryItem();
 
     /**
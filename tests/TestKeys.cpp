@@ -317,3 +317,22 @@ void TestKeys::testCompositeKeyComponents()
     db2.reset(reader.readDatabase(&buffer, compositeKeyDec4));
     QVERIFY(reader.hasError());
 }
+
+void TestKeys::testAesKdfTransform()
+{
+    QByteArray raw(32, '\0');
+    QByteArray seed(32, '\0');
+    for (int i = 0; i < 32; ++i) {
+        raw[i] = static_cast<char>(i * 13 + 5);
+        seed[i] = static_cast<char>(i * 7 + 1);
+    }
+
+    AesKdf kdf;
+    QVERIFY(kdf.setSeed(seed));
+    QVERIFY(kdf.setRounds(1000));
+
+    // SHA-256 of both halves after 1000 rounds of AES-256-ECB, same result with or without AES-NI
+    QByteArray result;
+    QVERIFY(kdf.transform(raw, result));
+    QCOMPARE(result.toHex(), QByteArray("655c089a2a39ee2fdf3d775e24def166e9974bcf7a83927c586025f230521eba"));
+}
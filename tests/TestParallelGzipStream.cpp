@@ -0,0 +1,160 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestParallelGzipStream.h"
+#include "TestGlobal.h"
+
+#include <QBuffer>
+
+#include <cstring>
+#include <zlib.h>
+
+#include "FailDevice.h"
+#include "streams/ParallelGzipStream.h"
+
+QTEST_GUILESS_MAIN(TestParallelGzipStream)
+
+namespace
+{
+    QByteArray sampleData(int size)
+    {
+        // Compressible, with matches across chunk boundaries
+        QByteArray data;
+        data.reserve(size);
+        quint32 state = 1;
+        while (data.size() < size) {
+            state = state * 1103515245 + 12345;
+            data.append(QString("<Entry><Title>%1</Title></Entry>\n").arg(state % 1000).toLatin1());
+        }
+        data.resize(size);
+        return data;
+    }
+
+    /**
+     * Inflate a single gzip member, zlib verifies the CRC and size in the trailer.
+     */
+    bool decompress(const QByteArray& compressed, QByteArray& output)
+    {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+            return false;
+        }
+
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.constData()));
+        stream.avail_in = static_cast<uInt>(compressed.size());
+        output.clear();
+        char chunk[16384];
+        int result;
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>(chunk);
+            stream.avail_out = sizeof(chunk);
+            result = inflate(&stream, Z_NO_FLUSH);
+            output.append(chunk, static_cast<int>(sizeof(chunk) - stream.avail_out));
+        } while (result == Z_OK);
+        inflateEnd(&stream);
+
+        // the whole input has to be one member
+        return result == Z_STREAM_END && stream.avail_in == 0;
+    }
+} // namespace
+
+void TestParallelGzipStream::testRoundTrip_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("level");
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("single chunk") << 1000 << ParallelGzipStream::DefaultCompressionLevel << 4096;
+    QTest::newRow("exact chunks") << 4 * 4096 << ParallelGzipStream::DefaultCompressionLevel << 4096;
+    QTest::newRow("many chunks") << 300000 << ParallelGzipStream::DefaultCompressionLevel << 4096;
+    QTest::newRow("fastest") << 300000 << 1 << 4096;
+    QTest::newRow("best") << 300000 << 9 << 4096;
+    QTest::newRow("stored") << 300000 << 0 << 4096;
+    QTest::newRow("default chunk size") << 1000000 << 6 << 128 * 1024;
+}
+
+void TestParallelGzipStream::testRoundTrip()
+{
+    QFETCH(int, size);
+    QFETCH(int, level);
+    QFETCH(int, chunkSize);
+
+    const QByteArray data = sampleData(size);
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    ParallelGzipStream writer(&buffer, level, chunkSize);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+    // odd write sizes so writes straddle the chunks
+    for (int offset = 0; offset < data.size(); offset += 999) {
+        QCOMPARE(writer.write(data.mid(offset, 999)), qint64(data.mid(offset, 999).size()));
+    }
+    QVERIFY(writer.reset());
+
+    const QByteArray compressed = buffer.data();
+    QCOMPARE(compressed.left(3), QByteArray("\x1f\x8b\x08", 3));
+    if (level != 0) {
+        QVERIFY(compressed.size() < data.size());
+    }
+
+    QByteArray output;
+    QVERIFY(decompress(compressed, output));
+    QCOMPARE(output.size(), data.size());
+    QVERIFY(output == data);
+}
+
+void TestParallelGzipStream::testEmpty()
+{
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    ParallelGzipStream writer(&buffer);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+    writer.close();
+
+    QByteArray output("not empty");
+    QVERIFY(decompress(buffer.data(), output));
+    QVERIFY(output.isEmpty());
+}
+
+void TestParallelGzipStream::testReset()
+{
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    ParallelGzipStream writer(&buffer);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+    QCOMPARE(writer.write(QByteArray(8, 'Z')), qint64(8));
+    // test if reset() and close() write only one trailer
+    QVERIFY(writer.reset());
+    const qint64 size = buffer.size();
+    QVERIFY(writer.reset());
+    writer.close();
+    QCOMPARE(buffer.size(), size);
+}
+
+void TestParallelGzipStream::testWriteFailure()
+{
+    FailDevice failDevice(1500);
+    QVERIFY(failDevice.open(QIODevice::WriteOnly));
+
+    ParallelGzipStream writer(&failDevice, 0, 500);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+
+    writer.write(QByteArray(5000, 'Z'));
+    QVERIFY(!writer.reset());
+    QCOMPARE(writer.errorString(), QString("FAILDEVICE"));
+}
@@ -0,0 +1,95 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestTrace.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "core/Trace.h"
+
+QTEST_GUILESS_MAIN(TestTrace)
+
+void TestTrace::testDisabled()
+{
+    QVERIFY(!Trace::isEnabled());
+    {
+        TRACE_SPAN("test", "disabled");
+    }
+    QVERIFY(Trace::finish());
+}
+
+void TestTrace::testChromeTraceOutput()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.path() + "/trace.json";
+
+    Trace::start(filePath);
+    QVERIFY(Trace::isEnabled());
+    {
+        TRACE_SPAN("test", "outer");
+        TRACE_SPAN("test", "inner");
+    }
+    QVERIFY(Trace::finish());
+    QVERIFY(!Trace::isEnabled());
+
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+
+    const QJsonArray events = document.object().value("traceEvents").toArray();
+    QCOMPARE(events.size(), 3);
+    QCOMPARE(events.at(0).toObject().value("ph").toString(), QString("M"));
+
+    // Spans are recorded when they end, so the inner one comes first
+    const QJsonObject inner = events.at(1).toObject();
+    const QJsonObject outer = events.at(2).toObject();
+    QCOMPARE(inner.value("name").toString(), QString("inner"));
+    QCOMPARE(outer.value("name").toString(), QString("outer"));
+    QCOMPARE(outer.value("cat").toString(), QString("test"));
+    QCOMPARE(outer.value("ph").toString(), QString("X"));
+    QCOMPARE(outer.value("tid").toInt(), 1);
+    QVERIFY(outer.value("ts").toDouble() <= inner.value("ts").toDouble());
+    QVERIFY(outer.value("dur").toDouble() >= inner.value("dur").toDouble());
+}
+
+void TestTrace::testMark()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.path() + "/trace.json";
+
+    Trace::start(filePath);
+    Trace::mark("test", "mark");
+    QVERIFY(Trace::finish());
+
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QJsonArray events = QJsonDocument::fromJson(file.readAll()).object().value("traceEvents").toArray();
+    QCOMPARE(events.size(), 2);
+
+    const QJsonObject mark = events.at(1).toObject();
+    QCOMPARE(mark.value("name").toString(), QString("mark"));
+    QCOMPARE(mark.value("ph").toString(), QString("i"));
+    QVERIFY(!mark.contains("dur"));
+}
@@ -53,6 +53,7 @@ void TestWildcardMatcher::testMatcher()
 
     initMatcher(text);
     verifyMatchResult(pattern, match);
+    QCOMPARE(m_matcher->matchParts(WildcardMatcher::splitPattern(pattern)), match);
     cleanupMatcher();
 }
 
@@ -0,0 +1,83 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkBrowser.h"
+
+#include <QTest>
+
+#include "VaultGenerator.h"
+#include "browser/BrowserService.h"
+#include "browser/BrowserSettings.h"
+#include "core/Config.h"
+#include "core/Database.h"
+#include "crypto/Crypto.h"
+#include "format/KeePass2Writer.h"
+#include "gui/DatabaseTabWidget.h"
+#include "gui/DatabaseWidget.h"
+
+QTEST_MAIN(BenchmarkBrowser)
+
+void BenchmarkBrowser::initTestCase()
+{
+    QVERIFY(Crypto::init());
+    Config::createTempFileInstance();
+    // Entries without stored permissions would otherwise ask for confirmation
+    BrowserSettings::setAlwaysAllowAccess(true);
+
+    VaultGenerator generator;
+    QScopedPointer<Database> db(generator.generate());
+    QVERIFY(m_dbFile.open());
+    KeePass2Writer writer;
+    QVERIFY(writer.writeDatabase(&m_dbFile, db.data()));
+    m_dbFile.close();
+
+    m_tabWidget.reset(new DatabaseTabWidget());
+    m_browserService.reset(new BrowserService(m_tabWidget.data()));
+    m_tabWidget->openDatabase(m_dbFile.fileName(), "benchmark");
+    QVERIFY(m_tabWidget->currentDatabaseWidget());
+    QTRY_COMPARE_WITH_TIMEOUT(m_tabWidget->currentDatabaseWidget()->currentMode(), DatabaseWidget::ViewMode, 60000);
+}
+
+void BenchmarkBrowser::cleanupTestCase()
+{
+    m_browserService.reset();
+    m_tabWidget.reset();
+}
+
+void BenchmarkBrowser::benchmarkFindMatchingEntries_data()
+{
+    VaultGenerator generator;
+
+    QTest::addColumn<QString>("url");
+
+    QTest::newRow("host") << QString("https://%1/login").arg(generator.hostName(7));
+    QTest::newRow("subdomain") << QString("https://accounts.%1/login").arg(generator.hostName(7));
+    QTest::newRow("no match") << QString("https://unknown.example.org/");
+}
+
+void BenchmarkBrowser::benchmarkFindMatchingEntries()
+{
+    QFETCH(QString, url);
+
+    // A different id per request keeps the response cache from answering
+    int request = 0;
+    QBENCHMARK
+    {
+        m_browserService->findMatchingEntries(
+            QString::number(++request), url, url, QString(), StringPairList());
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkDatabase.h"
+
+#include <QTest>
+
+#include "VaultGenerator.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/EntrySearcher.h"
+#include "core/Group.h"
+#include "crypto/Crypto.h"
+#include "gui/SortFilterHideProxyModel.h"
+#include "gui/entry/EntryModel.h"
+
+QTEST_GUILESS_MAIN(BenchmarkDatabase)
+
+void BenchmarkDatabase::initTestCase()
+{
+    QVERIFY(Crypto::init());
+    m_db.reset(VaultGenerator().generate());
+}
+
+void BenchmarkDatabase::benchmarkEntrySearcher_data()
+{
+    QTest::addColumn<QString>("searchTerm");
+
+    QTest::newRow("single word") << "tango";
+    QTest::newRow("two words") << "tango example";
+    QTest::newRow("no match") << "doesnotexist";
+}
+
+void BenchmarkDatabase::benchmarkEntrySearcher()
+{
+    QFETCH(QString, searchTerm);
+
+    EntrySearcher searcher;
+    QBENCHMARK
+    {
+        searcher.search(searchTerm, m_db->rootGroup(), Qt::CaseInsensitive);
+    }
+}
+
+/**
+ * Merges a copy in which every tenth entry was changed later. The first
+ * iteration applies the changes, the following ones measure the comparison
+ * of two databases which are in sync, which is the common case.
+ */
+void BenchmarkDatabase::benchmarkGroupMerge()
+{
+    QScopedPointer<Database> source(m_db->snapshot());
+    QScopedPointer<Database> target(m_db->snapshot());
+
+    const QList<Entry*> entries = source->rootGroup()->entriesRecursive();
+    for (int i = 0; i < entries.size(); i += 10) {
+        Entry* entry = entries.at(i);
+        TimeInfo timeInfo = entry->timeInfo();
+        timeInfo.setLastModificationTime(timeInfo.lastModificationTime().addDays(1));
+        entry->setTitle(entry->title() + " (changed)");
+        entry->setTimeInfo(timeInfo);
+    }
+
+    QBENCHMARK
+    {
+        target->rootGroup()->merge(source->rootGroup());
+    }
+}
+
+void BenchmarkDatabase::benchmarkEntryModelSort_data()
+{
+    QTest::addColumn<int>("column");
+
+    QTest::newRow("group") << static_cast<int>(EntryModel::ParentGroup);
+    QTest::newRow("title") << static_cast<int>(EntryModel::Title);
+    QTest::newRow("username") << static_cast<int>(EntryModel::Username);
+    QTest::newRow("url") << static_cast<int>(EntryModel::Url);
+    QTest::newRow("modified") << static_cast<int>(EntryModel::Modified);
+}
+
+void BenchmarkDatabase::benchmarkEntryModelSort()
+{
+    QFETCH(int, column);
+
+    EntryModel model;
+    model.setEntryList(m_db->rootGroup()->entriesRecursive());
+
+    SortFilterHideProxyModel sortModel;
+    sortModel.setSortRole(Qt::UserRole);
+    sortModel.setSourceModel(&model);
+
+    // Alternate the order, sorting twice in the same order is a no-op
+    Qt::SortOrder order = Qt::AscendingOrder;
+    QBENCHMARK
+    {
+        sortModel.sort(column, order);
+        order = order == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder;
+    }
+}
@@ -0,0 +1,232 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkFormat.h"
+
+#include <QBuffer>
+#include <QTest>
+
+#include "VaultGenerator.h"
+#include "core/CsvParser.h"
+#include "core/Database.h"
+#include "crypto/Crypto.h"
+#include "crypto/Random.h"
+#include "crypto/SymmetricCipher.h"
+#include "format/CsvExporter.h"
+#include "format/Kdbx4Reader.h"
+#include "format/Kdbx4Writer.h"
+#include "format/KdbxXmlReader.h"
+#include "format/KdbxXmlWriter.h"
+#include "format/KeePass2.h"
+#include "streams/HmacBlockStream.h"
+#include "streams/SymmetricCipherStream.h"
+
+QTEST_GUILESS_MAIN(BenchmarkFormat)
+
+Q_DECLARE_METATYPE(SymmetricCipher::Algorithm)
+Q_DECLARE_METATYPE(SymmetricCipher::Mode)
+
+namespace
+{
+    const int PayloadSize = 16 * 1024 * 1024;
+} // namespace
+
+void BenchmarkFormat::initTestCase()
+{
+    QVERIFY(Crypto::init());
+
+    m_db.reset(VaultGenerator().generate());
+
+    QBuffer kdbxBuffer(&m_kdbxData);
+    kdbxBuffer.open(QIODevice::WriteOnly);
+    Kdbx4Writer kdbxWriter;
+    QVERIFY(kdbxWriter.writeDatabase(&kdbxBuffer, m_db.data()));
+
+    QBuffer xmlBuffer(&m_xmlData);
+    xmlBuffer.open(QIODevice::WriteOnly);
+    KdbxXmlWriter xmlWriter(KeePass2::FILE_VERSION_4);
+    xmlWriter.writeDatabase(&xmlBuffer, m_db.data());
+    QVERIFY(!xmlWriter.hasError());
+
+    m_payload = randomGen()->randomArray(PayloadSize);
+
+    QVERIFY(m_csvFile.open());
+    CsvExporter csvExporter;
+    QVERIFY(csvExporter.exportDatabase(&m_csvFile, m_db.data()));
+    m_csvFile.close();
+}
+
+void BenchmarkFormat::benchmarkKdbx4Write()
+{
+    QBENCHMARK
+    {
+        QByteArray data;
+        data.reserve(m_kdbxData.size());
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        Kdbx4Writer writer;
+        QVERIFY(writer.writeDatabase(&buffer, m_db.data()));
+    }
+}
+
+void BenchmarkFormat::benchmarkKdbx4Read()
+{
+    const CompositeKey key = VaultGenerator::key();
+
+    QBENCHMARK
+    {
+        QBuffer buffer(&m_kdbxData);
+        buffer.open(QIODevice::ReadOnly);
+        Kdbx4Reader reader;
+        QScopedPointer<Database> db(reader.readDatabase(&buffer, key));
+        QVERIFY2(db, qPrintable(reader.errorString()));
+    }
+}
+
+void BenchmarkFormat::benchmarkXmlRead()
+{
+    QBENCHMARK
+    {
+        QBuffer buffer(&m_xmlData);
+        buffer.open(QIODevice::ReadOnly);
+        KdbxXmlReader reader(KeePass2::FILE_VERSION_4);
+        QScopedPointer<Database> db(reader.readDatabase(&buffer));
+        QVERIFY2(!reader.hasError(), qPrintable(reader.errorString()));
+    }
+}
+
+void BenchmarkFormat::benchmarkSymmetricCipherStream_data()
+{
+    QTest::addColumn<SymmetricCipher::Algorithm>("algorithm");
+    QTest::addColumn<SymmetricCipher::Mode>("mode");
+    QTest::addColumn<int>("keySize");
+    QTest::addColumn<int>("ivSize");
+    QTest::addColumn<bool>("encrypt");
+
+    QTest::newRow("AES-256 encrypt") << SymmetricCipher::Aes256 << SymmetricCipher::Cbc << 32 << 16 << true;
+    QTest::newRow("AES-256 decrypt") << SymmetricCipher::Aes256 << SymmetricCipher::Cbc << 32 << 16 << false;
+    QTest::newRow("Twofish encrypt") << SymmetricCipher::Twofish << SymmetricCipher::Cbc << 32 << 16 << true;
+    QTest::newRow("Twofish decrypt") << SymmetricCipher::Twofish << SymmetricCipher::Cbc << 32 << 16 << false;
+    QTest::newRow("ChaCha20 encrypt") << SymmetricCipher::ChaCha20 << SymmetricCipher::Stream << 32 << 12 << true;
+    QTest::newRow("ChaCha20 decrypt") << SymmetricCipher::ChaCha20 << SymmetricCipher::Stream << 32 << 12 << false;
+}
+
+void BenchmarkFormat::benchmarkSymmetricCipherStream()
+{
+    QFETCH(SymmetricCipher::Algorithm, algorithm);
+    QFETCH(SymmetricCipher::Mode, mode);
+    QFETCH(int, keySize);
+    QFETCH(int, ivSize);
+    QFETCH(bool, encrypt);
+
+    const QByteArray key = randomGen()->randomArray(keySize);
+    const QByteArray iv = randomGen()->randomArray(ivSize);
+
+    QByteArray ciphertext;
+    {
+        QBuffer buffer(&ciphertext);
+        buffer.open(QIODevice::WriteOnly);
+        SymmetricCipherStream stream(&buffer, algorithm, mode, SymmetricCipher::Encrypt);
+        QVERIFY(stream.init(key, iv));
+        QVERIFY(stream.open(QIODevice::WriteOnly));
+        QCOMPARE(stream.write(m_payload), static_cast<qint64>(m_payload.size()));
+        stream.close();
+    }
+
+    if (encrypt) {
+        QBENCHMARK
+        {
+            QByteArray output;
+            output.reserve(ciphertext.size());
+            QBuffer buffer(&output);
+            buffer.open(QIODevice::WriteOnly);
+            SymmetricCipherStream stream(&buffer, algorithm, mode, SymmetricCipher::Encrypt);
+            QVERIFY(stream.init(key, iv));
+            QVERIFY(stream.open(QIODevice::WriteOnly));
+            QCOMPARE(stream.write(m_payload), static_cast<qint64>(m_payload.size()));
+            stream.close();
+        }
+    } else {
+        QBENCHMARK
+        {
+            QBuffer buffer(&ciphertext);
+            buffer.open(QIODevice::ReadOnly);
+            SymmetricCipherStream stream(&buffer, algorithm, mode, SymmetricCipher::Decrypt);
+            QVERIFY(stream.init(key, iv));
+            QVERIFY(stream.open(QIODevice::ReadOnly));
+            QCOMPARE(stream.readAll().size(), m_payload.size());
+        }
+    }
+}
+
+void BenchmarkFormat::benchmarkHmacBlockStream_data()
+{
+    QTest::addColumn<bool>("write");
+
+    QTest::newRow("write") << true;
+    QTest::newRow("read") << false;
+}
+
+void BenchmarkFormat::benchmarkHmacBlockStream()
+{
+    QFETCH(bool, write);
+
+    const QByteArray key = randomGen()->randomArray(64);
+
+    QByteArray blocks;
+    {
+        QBuffer buffer(&blocks);
+        buffer.open(QIODevice::WriteOnly);
+        HmacBlockStream stream(&buffer, key);
+        QVERIFY(stream.open(QIODevice::WriteOnly));
+        QCOMPARE(stream.write(m_payload), static_cast<qint64>(m_payload.size()));
+        stream.close();
+    }
+
+    if (write) {
+        QBENCHMARK
+        {
+            QByteArray output;
+            output.reserve(blocks.size());
+            QBuffer buffer(&output);
+            buffer.open(QIODevice::WriteOnly);
+            HmacBlockStream stream(&buffer, key);
+            QVERIFY(stream.open(QIODevice::WriteOnly));
+            QCOMPARE(stream.write(m_payload), static_cast<qint64>(m_payload.size()));
+            stream.close();
+        }
+    } else {
+        QBENCHMARK
+        {
+            QBuffer buffer(&blocks);
+            buffer.open(QIODevice::ReadOnly);
+            HmacBlockStream stream(&buffer, key);
+            QVERIFY(stream.open(QIODevice::ReadOnly));
+            QCOMPARE(stream.readAll().size(), m_payload.size());
+        }
+    }
+}
+
+void BenchmarkFormat::benchmarkCsvParser()
+{
+    QBENCHMARK
+    {
+        QFile file(m_csvFile.fileName());
+        CsvParser parser;
+        QVERIFY2(parser.parse(&file), qPrintable(parser.getStatus()));
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_BENCHMARKFORMAT_H
+#define KEEPASSXC_BENCHMARKFORMAT_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QScopedPointer>
+#include <QTemporaryFile>
+
+class Database;
+
+class BenchmarkFormat : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void benchmarkKdbx4Write();
+    void benchmarkKdbx4Read();
+    void benchmarkXmlRead();
+    void benchmarkSymmetricCipherStream_data();
+    void benchmarkSymmetricCipherStream();
+    void benchmarkHmacBlockStream_data();
+    void benchmarkHmacBlockStream();
+    void benchmarkCsvParser();
+
+private:
+    QScopedPointer<Database> m_db;
+    QByteArray m_kdbxData;
+    QByteArray m_xmlData;
+    QByteArray m_payload;
+    QTemporaryFile m_csvFile;
+};
+
+#endif // KEEPASSXC_BENCHMARKFORMAT_H
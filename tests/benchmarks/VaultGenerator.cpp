@@ -0,0 +1,266 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "VaultGenerator.h"
+
+#include <QColor>
+#include <QImage>
+
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "core/Metadata.h"
+#include "crypto/kdf/Kdf.h"
+#include "format/KeePass2.h"
+#include "keys/PasswordKey.h"
+
+namespace
+{
+    const char* const Words[] = {"alpha",  "bravo",  "charlie", "delta", "echo",    "foxtrot", "golf",    "hotel",
+                                 "india",  "juliet", "kilo",    "lima",  "mike",    "november", "oscar",  "papa",
+                                 "quebec", "romeo",  "sierra",  "tango", "uniform", "victor",  "whiskey", "xray",
+                                 "yankee", "zulu",   "account", "bank",  "mail",    "forum",   "shop",    "server"};
+    const int WordCount = sizeof(Words) / sizeof(Words[0]);
+
+    const int HostCount = 500;
+
+    int environmentValue(const char* name, int defaultValue)
+    {
+        bool ok;
+        const int value = qgetenv(name).toInt(&ok);
+        return ok && value >= 0 ? value : defaultValue;
+    }
+} // namespace
+
+VaultGenerator::Options::Options()
+    : entries(2000)
+    , groupDepth(3)
+    , groupsPerLevel(4)
+    , historyDepth(3)
+    , attachmentInterval(10)
+    , attachmentSize(4096)
+    , referenceInterval(25)
+    , customIcons(20)
+    , seed(0x4b505843)
+{
+}
+
+VaultGenerator::Options VaultGenerator::Options::fromEnvironment()
+{
+    Options options;
+    options.entries = environmentValue("KEEPASSXC_BENCHMARK_ENTRIES", options.entries);
+    options.groupDepth = environmentValue("KEEPASSXC_BENCHMARK_GROUP_DEPTH", options.groupDepth);
+    options.groupsPerLevel = environmentValue("KEEPASSXC_BENCHMARK_GROUPS_PER_LEVEL", options.groupsPerLevel);
+    options.historyDepth = environmentValue("KEEPASSXC_BENCHMARK_HISTORY_DEPTH", options.historyDepth);
+    options.attachmentInterval =
+        environmentValue("KEEPASSXC_BENCHMARK_ATTACHMENT_INTERVAL", options.attachmentInterval);
+    options.attachmentSize = environmentValue("KEEPASSXC_BENCHMARK_ATTACHMENT_SIZE", options.attachmentSize);
+    options.referenceInterval = environmentValue("KEEPASSXC_BENCHMARK_REFERENCE_INTERVAL", options.referenceInterval);
+    options.customIcons = environmentValue("KEEPASSXC_BENCHMARK_CUSTOM_ICONS", options.customIcons);
+    options.seed = static_cast<quint32>(environmentValue("KEEPASSXC_BENCHMARK_SEED", static_cast<int>(options.seed)));
+    return options;
+}
+
+VaultGenerator::VaultGenerator(const Options& options)
+    : m_options(options)
+    , m_state(options.seed ? options.seed : 1)
+{
+}
+
+/**
+ * Creates a KDBX 4 database with a minimal Argon2 KDF, so reading and writing
+ * it is dominated by the payload and not by the key derivation.
+ */
+Database* VaultGenerator::generate()
+{
+    m_state = m_options.seed ? m_options.seed : 1;
+
+    Database* db = new Database();
+    QSharedPointer<Kdf> kdf = KeePass2::uuidToKdf(KeePass2::KDF_ARGON2);
+    kdf->setRounds(1);
+    kdf->processParameters({{KeePass2::KDFPARAM_ARGON2_MEMORY, 1024}, {KeePass2::KDFPARAM_ARGON2_PARALLELISM, 1}});
+    db->setKdf(kdf);
+    db->setKey(key(), false, true);
+    db->metadata()->setName(QString("Benchmark vault (%1 entries)").arg(m_options.entries));
+
+    Group* root = db->rootGroup();
+    root->setUuid(uuid());
+    root->setName("Root");
+
+    QList<QUuid> icons;
+    for (int i = 0; i < m_options.customIcons; ++i) {
+        QImage icon(16, 16, QImage::Format_ARGB32);
+        icon.fill(QColor::fromRgb(next()));
+        const QUuid iconUuid = uuid();
+        db->metadata()->addCustomIcon(iconUuid, icon);
+        icons.append(iconUuid);
+    }
+
+    QList<Group*> groups;
+    groups.append(root);
+    createGroups(root, m_options.groupDepth, groups);
+
+    QList<Entry*> entries;
+    for (int i = 0; i < m_options.entries; ++i) {
+        entries.append(createEntry(i, groups.at(bounded(groups.size())), entries, icons));
+    }
+
+    return db;
+}
+
+QString VaultGenerator::hostName(int index) const
+{
+    return QString("%1%2.example.com").arg(Words[index % WordCount]).arg(index % HostCount);
+}
+
+CompositeKey VaultGenerator::key()
+{
+    CompositeKey key;
+    key.addKey(PasswordKey("benchmark"));
+    return key;
+}
+
+/**
+ * xorshift32, good enough for test data and identical on every platform.
+ */
+quint32 VaultGenerator::next()
+{
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+    return m_state;
+}
+
+int VaultGenerator::bounded(int max)
+{
+    return max > 0 ? static_cast<int>(next() % static_cast<quint32>(max)) : 0;
+}
+
+QString VaultGenerator::word()
+{
+    return QString::fromLatin1(Words[bounded(WordCount)]);
+}
+
+QString VaultGenerator::words(int count)
+{
+    QStringList list;
+    for (int i = 0; i < count; ++i) {
+        list.append(word());
+    }
+    return list.join(' ');
+}
+
+QString VaultGenerator::password(int length)
+{
+    static const char Characters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!#$%&()*+,-./:;<=>?@[]^_";
+    QString result;
+    result.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        result.append(QLatin1Char(Characters[bounded(sizeof(Characters) - 1)]));
+    }
+    return result;
+}
+
+QByteArray VaultGenerator::bytes(int size)
+{
+    QByteArray result(size, '\0');
+    for (int i = 0; i < size; ++i) {
+        result[i] = static_cast<char>(next());
+    }
+    return result;
+}
+
+QUuid VaultGenerator::uuid()
+{
+    return QUuid::fromRfc4122(bytes(16));
+}
+
+QDateTime VaultGenerator::timestamp()
+{
+    static const QDateTime Epoch(QDate(2015, 1, 1), QTime(0, 0), Qt::UTC);
+    return Epoch.addSecs(bounded(3 * 365 * 24 * 3600));
+}
+
+void VaultGenerator::createGroups(Group* parent, int depth, QList<Group*>& groups)
+{
+    if (depth <= 0) {
+        return;
+    }
+
+    for (int i = 0; i < m_options.groupsPerLevel; ++i) {
+        Group* group = new Group();
+        group->setUpdateTimeinfo(false);
+        group->setUuid(uuid());
+        group->setName(words(2));
+        group->setNotes(words(8));
+        TimeInfo timeInfo;
+        timeInfo.setCreationTime(timestamp());
+        timeInfo.setLastModificationTime(timeInfo.creationTime());
+        timeInfo.setLastAccessTime(timeInfo.creationTime());
+        timeInfo.setLocationChanged(timeInfo.creationTime());
+        group->setTimeInfo(timeInfo);
+        group->setParent(parent);
+        groups.append(group);
+        createGroups(group, depth - 1, groups);
+    }
+}
+
+Entry* VaultGenerator::createEntry(int index, Group* group, const QList<Entry*>& entries, const QList<QUuid>& icons)
+{
+    Entry* entry = new Entry();
+    entry->setUpdateTimeinfo(false);
+    entry->setUuid(uuid());
+    entry->setTitle(words(2));
+    entry->setUsername(QString("%1.%2@example.com").arg(word(), word()));
+    entry->setPassword(password(20));
+    entry->setUrl(QString("https://%1/login").arg(hostName(index)));
+    entry->setNotes(words(bounded(40)));
+    entry->attributes()->set("Account", QString::number(next()));
+    entry->attributes()->set("PIN", QString::number(next() % 10000), true);
+
+    if (!icons.isEmpty() && bounded(4) == 0) {
+        entry->setIcon(icons.at(bounded(icons.size())));
+    }
+    if (m_options.attachmentInterval > 0 && index % m_options.attachmentInterval == 0) {
+        entry->attachments()->set(QString("%1.bin").arg(word()), bytes(m_options.attachmentSize));
+    }
+    if (m_options.referenceInterval > 0 && index % m_options.referenceInterval == 0 && !entries.isEmpty()) {
+        const Entry* target = entries.at(bounded(entries.size()));
+        entry->setUsername(QString("{REF:U@I:%1}").arg(QString::fromLatin1(target->uuid().toRfc4122().toHex())));
+    }
+
+    TimeInfo timeInfo;
+    timeInfo.setCreationTime(timestamp());
+    timeInfo.setLastAccessTime(timeInfo.creationTime());
+    timeInfo.setLocationChanged(timeInfo.creationTime());
+
+    // Older versions differ in the password and were modified before the current one
+    QDateTime modified = timeInfo.creationTime();
+    for (int i = 0; i < m_options.historyDepth; ++i) {
+        modified = modified.addSecs(3600 + bounded(30 * 24 * 3600));
+        timeInfo.setLastModificationTime(modified);
+        entry->setTimeInfo(timeInfo);
+        Entry* historyItem = entry->clone(Entry::CloneNoFlags);
+        entry->addHistoryItem(historyItem);
+        entry->setPassword(password(20));
+    }
+
+    timeInfo.setLastModificationTime(modified.addSecs(3600));
+    entry->setTimeInfo(timeInfo);
+    entry->setGroup(group);
+    return entry;
+}
@@ -0,0 +1,89 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_VAULTGENERATOR_H
+#define KEEPASSXC_VAULTGENERATOR_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QUuid>
+
+#include "keys/CompositeKey.h"
+
+class Database;
+class Entry;
+class Group;
+
+/**
+ * Generates synthetic databases for the benchmarks.
+ *
+ * The output only depends on the options, so two runs with the same options
+ * produce the same groups, entries and uuids and the results stay comparable.
+ */
+class VaultGenerator
+{
+public:
+    struct Options
+    {
+        Options();
+
+        int entries;
+        int groupDepth;
+        int groupsPerLevel;
+        int historyDepth;
+        int attachmentInterval;
+        int attachmentSize;
+        int referenceInterval;
+        int customIcons;
+        quint32 seed;
+
+        /**
+         * Reads the options from KEEPASSXC_BENCHMARK_ENTRIES, _GROUP_DEPTH,
+         * _GROUPS_PER_LEVEL, _HISTORY_DEPTH, _ATTACHMENT_INTERVAL,
+         * _ATTACHMENT_SIZE, _REFERENCE_INTERVAL, _CUSTOM_ICONS and _SEED.
+         * Unset variables keep their default.
+         */
+        static Options fromEnvironment();
+    };
+
+    explicit VaultGenerator(const Options& options = Options::fromEnvironment());
+
+    Database* generate();
+    QString hostName(int index) const;
+
+    static CompositeKey key();
+
+private:
+    quint32 next();
+    int bounded(int max);
+    QString word();
+    QString words(int count);
+    QString password(int length);
+    QByteArray bytes(int size);
+    QUuid uuid();
+    QDateTime timestamp();
+
+    void createGroups(Group* parent, int depth, QList<Group*>& groups);
+    Entry* createEntry(int index, Group* group, const QList<Entry*>& entries, const QList<QUuid>& icons);
+
+    const Options m_options;
+    quint32 m_state;
+};
+
+#endif // KEEPASSXC_VAULTGENERATOR_H
@@ -0,0 +1,107 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestBrowserCache.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTest>
+
+#include "browser/BrowserService.h"
+#include "browser/BrowserSettings.h"
+#include "core/Config.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "crypto/Crypto.h"
+#include "format/KeePass2Writer.h"
+#include "gui/DatabaseTabWidget.h"
+#include "gui/DatabaseWidget.h"
+#include "gui/MessageBox.h"
+#include "keys/PasswordKey.h"
+
+QTEST_MAIN(TestBrowserCache)
+
+void TestBrowserCache::initTestCase()
+{
+    QVERIFY(Crypto::init());
+    Config::createTempFileInstance();
+    Config::instance()->set("AutoSaveAfterEveryChange", false);
+    // Entries without stored permissions would otherwise ask for confirmation
+    BrowserSettings::setAlwaysAllowAccess(true);
+
+    Database db;
+    CompositeKey key;
+    key.addKey(PasswordKey("a"));
+    QVERIFY(db.setKey(key));
+    auto* entry = new Entry();
+    entry->setUuid(QUuid::createUuid());
+    entry->setTitle("Example");
+    entry->setUsername("user");
+    entry->setPassword("secret");
+    entry->setUrl("https://example.com/login");
+    entry->setGroup(db.rootGroup());
+
+    QVERIFY(m_dbFile.open());
+    KeePass2Writer writer;
+    QVERIFY(writer.writeDatabase(&m_dbFile, &db));
+    m_dbFile.close();
+
+    m_tabWidget.reset(new DatabaseTabWidget());
+    m_browserService.reset(new BrowserService(m_tabWidget.data()));
+    m_tabWidget->openDatabase(m_dbFile.fileName(), "a");
+    QVERIFY(m_tabWidget->currentDatabaseWidget());
+    QTRY_COMPARE(m_tabWidget->currentDatabaseWidget()->currentMode(), DatabaseWidget::ViewMode);
+}
+
+void TestBrowserCache::cleanupTestCase()
+{
+    m_browserService.reset();
+    m_tabWidget.reset();
+}
+
+void TestBrowserCache::testResponseCache()
+{
+    const QString url("https://example.com/login");
+    QCOMPARE(m_browserService->responseCacheSize(), 0);
+
+    QJsonArray result = m_browserService->findMatchingEntries("id", url, url, QString(), StringPairList());
+    QCOMPARE(result.size(), 1);
+    QCOMPARE(result.first().toObject().value("name").toString(), QString("Example"));
+    QCOMPARE(m_browserService->responseCacheSize(), 1);
+
+    // the same request is answered from the cache, which builds the password fields again
+    QCOMPARE(m_browserService->findMatchingEntries("id", url, url, QString(), StringPairList()), result);
+    QCOMPARE(result.first().toObject().value("password").toString(), QString("secret"));
+    QCOMPARE(m_browserService->responseCacheSize(), 1);
+    m_browserService->findMatchingEntries("other", url, url, QString(), StringPairList());
+    QCOMPARE(m_browserService->responseCacheSize(), 2);
+
+    // modifying the database invalidates all cached responses
+    Database* db = m_tabWidget->currentDatabaseWidget()->database();
+    db->rootGroup()->entries().first()->setTitle("Changed");
+    result = m_browserService->findMatchingEntries("id", url, url, QString(), StringPairList());
+    QCOMPARE(result.size(), 1);
+    QCOMPARE(result.first().toObject().value("name").toString(), QString("Changed"));
+    QCOMPARE(m_browserService->responseCacheSize(), 1);
+
+    // locking the database clears the cache
+    MessageBox::setNextAnswer(QMessageBox::Discard);
+    m_tabWidget->lockDatabases();
+    QCOMPARE(m_tabWidget->currentDatabaseWidget()->currentMode(), DatabaseWidget::LockedMode);
+    QCOMPARE(m_browserService->responseCacheSize(), 0);
+}
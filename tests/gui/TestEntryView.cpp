@@ -0,0 +1,68 @@
+/*
+ *  Copyright (C) 2018 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestEntryView.h"
+
+#include <QHeaderView>
+#include <QTest>
+
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "crypto/Crypto.h"
+#include "gui/entry/EntryModel.h"
+#include "gui/entry/EntryView.h"
+
+QTEST_MAIN(TestEntryView)
+
+void TestEntryView::initTestCase()
+{
+    QVERIFY(Crypto::init());
+}
+
+void TestEntryView::testSetCurrentEntryWhileSorting()
+{
+    QScopedPointer<Database> db(new Database());
+    QList<Entry*> entries;
+    // more than EntryModel::FetchBatchSize, so the results are sorted in the background
+    for (int i = 0; i < 1200; ++i) {
+        Entry* entry = new Entry();
+        entry->setUuid(QUuid::createUuid());
+        entry->setTitle(QString("Entry %1").arg(i, 4, 10, QChar('0')));
+        entry->setGroup(db->rootGroup());
+        entries.append(entry);
+    }
+
+    EntryView view;
+    view.setEntryList(entries);
+    QCOMPARE(view.model()->rowCount(), 0);
+
+    // selecting a result before it has a row selects it once sorting is done
+    view.setCurrentEntry(entries[1000]);
+    QTRY_COMPARE(view.currentEntry(), entries[1000]);
+
+    // sorting again keeps the current entry, unless another one is selected meanwhile
+    view.header()->setSortIndicator(EntryModel::Title, Qt::DescendingOrder);
+    QCOMPARE(view.model()->rowCount(), 0);
+    QVERIFY(!view.currentEntry());
+    view.setCurrentEntry(entries[1100]);
+    QTRY_COMPARE(view.currentEntry(), entries[1100]);
+
+    view.header()->setSortIndicator(EntryModel::Title, Qt::AscendingOrder);
+    QTRY_VERIFY(view.model()->rowCount() > 0);
+    QCOMPARE(view.currentEntry(), entries[1100]);
+}
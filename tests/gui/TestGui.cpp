@@ -108,9 +108,10 @@ void TestGui::init()
 
     QTest::keyClicks(editPassword, "a");
     QTest::keyClick(editPassword, Qt::Key_Enter);
-    Tools::wait(100);
 
     QVERIFY(m_tabWidget->currentDatabaseWidget());
+    // the database is unlocked in the background
+    QTRY_COMPARE(m_tabWidget->currentDatabaseWidget()->currentMode(), DatabaseWidget::ViewMode);
 
     m_dbWidget = m_tabWidget->currentDatabaseWidget();
     m_db = m_dbWidget->database();
@@ -1059,7 +1060,7 @@ void TestGui::testDatabaseLocking()
     QTest::keyClicks(editPassword, "a");
     QTest::keyClick(editPassword, Qt::Key_Enter);
 
-    QCOMPARE(m_tabWidget->tabText(0).remove('&'), origDbName);
+    QTRY_COMPARE(m_tabWidget->tabText(0).remove('&'), origDbName);
 
     actionDatabaseMerge = m_mainWindow->findChild<QAction*>("actionDatabaseMerge", Qt::FindChildrenRecursively);
     QCOMPARE(actionDatabaseMerge->isEnabled(), true);